@@ -0,0 +1,245 @@
+// Generador de entradas para las mediciones de bench/run.sh. La salida solo
+// depende del tipo, el tamaño y la semilla, así que las cifras se pueden
+// reproducir en otra máquina.
+//
+//   gen TIPO MEGABYTES [SEMILLA] > archivo.pycl
+//   gen tree DIRECTORIO ARCHIVOS [SEMILLA]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+
+static unsigned long long rng_state = 88172645463325252ull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t rng_below(size_t limit) {
+    return (size_t)(rng_next() % limit);
+}
+
+typedef struct {
+    FILE *out;
+    size_t written;
+} Output;
+
+static void emit(Output *out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void emit(Output *out, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vfprintf(out->out, format, args);
+    va_end(args);
+    if (length > 0) {
+        out->written += (size_t)length;
+    }
+}
+
+static const char *const WORDS[] = {
+    "total", "indice", "valor", "suma", "cuenta", "dato", "tmp", "limite", "paso", "resto",
+};
+
+static void name(char *buffer, size_t size, size_t distinct) {
+    size_t id = rng_below(distinct);
+    snprintf(buffer, size, "%s_%zu", WORDS[id % (sizeof(WORDS) / sizeof(WORDS[0]))], id);
+}
+
+static void emit_expression(Output *out, size_t depth) {
+    static const char *const OPERATORS[] = {"+", "-", "*", "/", "%", "<", "<=", "==", "!=", "&&", "||"};
+    char buffer[32];
+    if (depth == 0 || rng_below(4) == 0) {
+        if (rng_below(2) == 0) {
+            emit(out, "%zu", rng_below(1000));
+        } else {
+            name(buffer, sizeof(buffer), 64);
+            emit(out, "%s", buffer);
+        }
+        return;
+    }
+    switch (rng_below(5)) {
+        case 0:
+            emit(out, "(");
+            emit_expression(out, depth - 1);
+            emit(out, ")");
+            break;
+        case 1:
+            emit(out, rng_below(2) ? "-" : "!");
+            emit_expression(out, depth - 1);
+            break;
+        case 2:
+            name(buffer, sizeof(buffer), 64);
+            emit(out, "%s(", buffer);
+            emit_expression(out, depth - 1);
+            emit(out, ", ");
+            emit_expression(out, depth - 1);
+            emit(out, ")");
+            break;
+        default:
+            emit_expression(out, depth - 1);
+            emit(out, " %s ", OPERATORS[rng_below(sizeof(OPERATORS) / sizeof(OPERATORS[0]))]);
+            emit_expression(out, depth - 1);
+            break;
+    }
+}
+
+// Un programa variado: declaraciones, control de flujo, funciones de nivel
+// superior (los puntos de corte del parseo por regiones), cadenas y comentarios.
+static void emit_mixed(Output *out, size_t index) {
+    char a[32];
+    char b[32];
+    name(a, sizeof(a), 256);
+    name(b, sizeof(b), 256);
+    switch (index % 8) {
+        case 0:
+            emit(out, "int %s = %zu;\n", a, rng_below(100000));
+            break;
+        case 1:
+            emit(out, "float %s = %zu.%zu;\n", a, rng_below(100), rng_below(100));
+            break;
+        case 2:
+            emit(out, "if (%s > %s) {\n    csay(\"mayor \\\"%zu\\\"\");\n} \n", a, b, index);
+            break;
+        case 3:
+            emit(out, "while (%s < %zu) {\n    %s = %s + 1;\n}\n", a, rng_below(50), a, a);
+            break;
+        case 4:
+            emit(out, "func f_%zu(%s, %s) {\n    // suma de los dos\n    return %s * 2 + %s;\n}\n", index, a, b, a, b);
+            break;
+        case 5:
+            emit(out, "array %s = [%zu, %zu, %zu];\nfor (%s in %s) {\n    csay(%s);\n}\n", a, rng_below(9),
+                 rng_below(9), rng_below(9), b, a, b);
+            break;
+        case 6:
+            emit(out, "/* bloque %zu */ char %s = 'x';\n", index, a);
+            break;
+        default:
+            emit(out, "%s = ", a);
+            emit_expression(out, 3);
+            emit(out, ";\n");
+            break;
+    }
+}
+
+static void emit_comments(Output *out, size_t index) {
+    switch (index % 4) {
+        case 0:
+            emit(out, "// comentario de línea %zu con texto de relleno para alargarlo bastante más\n", index);
+            break;
+        case 1:
+            emit(out, "$ comentario con dólar %zu, también de una línea entera de relleno\n", index);
+            break;
+        case 2:
+            emit(out, "/* comentario de bloque %zu\n   que ocupa varias líneas\n   y contiene * y / sueltos */\n", index);
+            break;
+        default:
+            emit(out, "%%%% bloque %zu de porcentaje\n   con varias líneas de texto %%%%\nint c_%zu = %zu;\n", index,
+                 index, index);
+            break;
+    }
+}
+
+static void emit_blanks(Output *out, size_t index) {
+    size_t indent = 4 + rng_below(60);
+    emit(out, "%*sint b_%zu   =   %zu  ;\t\t\n\n\n", (int)indent, "", index, index);
+}
+
+// Muchos identificadores distintos por línea, casi sin otra cosa: el coste
+// lo pone internarlos.
+static void emit_identifiers(Output *out, size_t index) {
+    char a[32];
+    char b[32];
+    char c[32];
+    name(a, sizeof(a), 20000);
+    name(b, sizeof(b), 20000);
+    name(c, sizeof(c), 20000);
+    emit(out, "%s = %s(%s, %s, %s_%zu);\n", a, b, c, a, c, index % 997);
+}
+
+// Una asignación por línea con una expresión de ocho niveles: casi todo el
+// tiempo se va en el parser de expresiones.
+static void emit_expressions(Output *out, size_t index) {
+    (void)index;
+    char a[32];
+    name(a, sizeof(a), 64);
+    emit(out, "%s = ", a);
+    emit_expression(out, 8);
+    emit(out, ";\n");
+}
+
+typedef void (*Emitter)(Output *out, size_t index);
+
+typedef struct {
+    const char *kind;
+    Emitter emitter;
+} Generator;
+
+static const Generator GENERATORS[] = {
+    {"mixed", emit_mixed},
+    {"comments", emit_comments},
+    {"blanks", emit_blanks},
+    {"exprs", emit_expressions},
+    {"idents", emit_identifiers},
+};
+
+// Muchos archivos pequeños, como un proyecto, para medir el reparto de -j.
+static int generate_tree(const char *dir, size_t files) {
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "No se pudo crear el directorio: %s\n", dir);
+        return 1;
+    }
+    for (size_t i = 0; i < files; ++i) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/m%05zu.pycl", dir, i);
+        FILE *file = fopen(path, "w");
+        if (!file) {
+            fprintf(stderr, "No se pudo escribir el archivo: %s\n", path);
+            return 1;
+        }
+        // Entre 1,5 y 40 KB por archivo.
+        Output out = {file, 0};
+        size_t target = 1536 + rng_below(40 * 1024 - 1536);
+        for (size_t index = 0; out.written < target; ++index) {
+            emit_mixed(&out, index);
+        }
+        fclose(file);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bool tree = argc > 1 && strcmp(argv[1], "tree") == 0;
+    if (argc < (tree ? 4 : 3)) {
+        fprintf(stderr, "Uso: %s mixed|comments|blanks|exprs|idents MEGABYTES [SEMILLA]\n"
+                        "     %s tree DIRECTORIO ARCHIVOS [SEMILLA]\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (argc > (tree ? 4 : 3)) {
+        rng_state ^= strtoull(argv[tree ? 4 : 3], NULL, 10) * 0x9e3779b97f4a7c15ull;
+    }
+    if (tree) {
+        return generate_tree(argv[2], strtoul(argv[3], NULL, 10));
+    }
+    for (size_t i = 0; i < sizeof(GENERATORS) / sizeof(GENERATORS[0]); ++i) {
+        if (strcmp(argv[1], GENERATORS[i].kind) == 0) {
+            Output out = {stdout, 0};
+            size_t target = (size_t)(strtod(argv[2], NULL) * 1024 * 1024);
+            for (size_t index = 0; out.written < target; ++index) {
+                GENERATORS[i].emitter(&out, index);
+            }
+            return fflush(stdout) == 0 ? 0 : 1;
+        }
+    }
+    fprintf(stderr, "Tipo de entrada desconocido: %s\n", argv[1]);
+    return 1;
+}
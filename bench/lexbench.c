@@ -0,0 +1,99 @@
+// Rendimiento del analizador léxico sin leer ni parsear: tokeniza el archivo
+// completo varias veces con lexer_tokenize_all (o lexer_tokenize_parallel con
+// --threads y --chunk) y escribe la mejor vuelta en MB/s y millones de tokens
+// por segundo.
+//
+//   lexbench ARCHIVO [--lexer=classic|dfa] [--scan=scalar|sse2|avx2] [--threads=N --chunk=BYTES] [--repeat=N]
+
+#include "lexer/lexer.h"
+#include "lexer/structural.h"
+#include "source/source.h"
+#include "stats/stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *scan_level_name(ScanLevel level) {
+    switch (level) {
+        case SCAN_SCALAR:
+            return "scalar";
+        case SCAN_SSE2:
+            return "sse2";
+        case SCAN_AVX2:
+            return "avx2";
+        default:
+            return "auto";
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    LexerEngine engine = LEXER_ENGINE_CLASSIC;
+    ScanLevel level = SCAN_AUTO;
+    size_t threads = 1;
+    size_t chunk = 0;
+    size_t repeat = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--lexer=dfa") == 0) {
+            engine = LEXER_ENGINE_DFA;
+        } else if (strcmp(argv[i], "--lexer=classic") == 0) {
+            engine = LEXER_ENGINE_CLASSIC;
+        } else if (strcmp(argv[i], "--scan=scalar") == 0) {
+            level = SCAN_SCALAR;
+        } else if (strcmp(argv[i], "--scan=sse2") == 0) {
+            level = SCAN_SSE2;
+        } else if (strcmp(argv[i], "--scan=avx2") == 0) {
+            level = SCAN_AVX2;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            threads = strtoul(argv[i] + 10, NULL, 10);
+        } else if (strncmp(argv[i], "--chunk=", 8) == 0) {
+            chunk = strtoul(argv[i] + 8, NULL, 10);
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = strtoul(argv[i] + 9, NULL, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (!path || threads == 0 || repeat == 0) {
+        fprintf(stderr, "Uso: %s ARCHIVO [--lexer=classic|dfa] [--scan=scalar|sse2|avx2] [--threads=N --chunk=BYTES] "
+                        "[--repeat=N]\n", argv[0]);
+        return 1;
+    }
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+        return 1;
+    }
+    scan_set_level(level);
+    lexer_set_default_engine(engine);
+
+    double best = 0.0;
+    size_t tokens = 0;
+    for (size_t run = 0; run < repeat; ++run) {
+        Lexer lexer;
+        lexer_init(&lexer, file.data, file.length);
+        TokenBuffer buffer;
+        token_buffer_init(&buffer);
+        double started = stats_now();
+        bool ok = threads > 1 ? lexer_tokenize_parallel(&lexer, &buffer, threads, chunk)
+                              : lexer_tokenize_all(&lexer, &buffer);
+        double elapsed = stats_now() - started;
+        tokens = buffer.count;
+        token_buffer_free(&buffer);
+        lexer_free(&lexer);
+        if (!ok) {
+            fprintf(stderr, "Memoria insuficiente para %s\n", path);
+            source_release(&file);
+            return 1;
+        }
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    printf("%-32s %-7s %-6s %2zu hilos %8zu B/trozo  %8.1f MB/s  %6.1f Mtok/s\n", path,
+           engine == LEXER_ENGINE_DFA ? "dfa" : "classic", scan_level_name(scan_kernels()->level), threads,
+           threads > 1 ? chunk : file.length, (double)file.length / best / 1e6, (double)tokens / best / 1e6);
+    source_release(&file);
+    return 0;
+}
@@ -0,0 +1,321 @@
+#!/usr/bin/env bash
+# Mediciones de rendimiento reproducibles. Se lanza con `make bench`, que
+# compila con -O2 en bench/build el compilador, el generador de entradas
+# (gen.c) y los programas de medición; las entradas se generan una vez en
+# bench/build/data con una semilla fija.
+#
+#   make bench                       todas las secciones
+#   make bench BENCH="blanks"        solo las secciones indicadas
+#   make bench BENCH=guard BENCH_BASELINE=HEAD~1
+#                                    falla si el camino sin errores es más
+#                                    lento que en la referencia
+#
+# Variables: BENCH_SIZE (MB por entrada, 16 por defecto), BENCH_REPEAT
+# (vueltas por medida, se toma la mejor; 5 por defecto), BENCH_FILES
+# (archivos del árbol de proyecto, 3000 por defecto), BENCH_JOBS (hilos que
+# se prueban en las secciones paralelas; por defecto 1, 2, 4... hasta el
+# doble de núcleos), BENCH_SPLITS (valores de --split-size que se prueban),
+# BENCH_BASELINE y BENCH_TOLERANCE (referencia y margen de la guarda).
+
+set -eu
+
+BUILD=${BENCH_BUILD:-bench/build}
+DATA=$BUILD/data
+SIZE=${BENCH_SIZE:-16}
+REPEAT=${BENCH_REPEAT:-5}
+FILES=${BENCH_FILES:-3000}
+SPLITS=${BENCH_SPLITS:-262144 1048576 4194304}
+CORES=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+if [ -z "${BENCH_JOBS:-}" ]; then
+    BENCH_JOBS=1
+    while [ "${BENCH_JOBS##* }" -lt $((CORES * 2)) ] && [ "${BENCH_JOBS##* }" -lt 64 ]; do
+        BENCH_JOBS="$BENCH_JOBS $((${BENCH_JOBS##* } * 2))"
+    done
+fi
+
+mkdir -p "$DATA"
+
+# Ruta de la entrada generada de ese tipo y tamaño, creándola si no existe.
+input() {
+    local file=$DATA/$1-$2.pycl
+    if [ ! -f "$file" ]; then
+        "$BUILD/gen" "$1" "$2" > "$file"
+    fi
+    echo "$file"
+}
+
+# Árbol de proyecto generado, creándolo si no existe.
+tree() {
+    local dir=$DATA/tree-$FILES
+    if [ ! -d "$dir" ]; then
+        "$BUILD/gen" tree "$dir" "$FILES"
+    fi
+    echo "$dir"
+}
+
+# Mejor tiempo de pared, en segundos, de REPEAT ejecuciones del comando.
+best_of() {
+    local best="" run started elapsed
+    for run in $(seq "$REPEAT"); do
+        started=$(date +%s%N)
+        "$@" > /dev/null 2>&1 || true
+        elapsed=$(($(date +%s%N) - started))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    awk -v ns="$best" 'BEGIN { printf "%.3f", ns / 1e9 }'
+}
+
+# Imprime una fila de una tabla de escalado: etiqueta, segundos y aceleración
+# respecto a la primera fila (cuyo tiempo se pasa como tercer argumento).
+scaling_row() {
+    awk -v label="$1" -v t="$2" -v base="$3" 'BEGIN { printf "  %-32s %8.3f s  x%.2f\n", label, t, base / t }'
+}
+
+# Tiempo de pared, en nanosegundos, de una ejecución del comando.
+time_once() {
+    local started
+    started=$(date +%s%N)
+    "$@" > /dev/null 2>&1 || true
+    echo $(($(date +%s%N) - started))
+}
+
+# Imprime una fila de rendimiento: etiqueta, segundos y MB procesados.
+throughput_row() {
+    awk -v label="$1" -v t="$2" -v mb="$3" 'BEGIN { printf "  %-32s %8.3f s  %8.1f MB/s\n", label, t, mb / t }'
+}
+
+# Las secciones paralelas solo pueden mostrar aceleración con varios núcleos.
+warn_cores() {
+    echo "   ($CORES núcleos en línea; hilos probados: $BENCH_JOBS)"
+    if [ "$CORES" -lt 2 ]; then
+        echo "   AVISO: con un solo núcleo esta tabla mide el coste de los hilos, no su escalado."
+    fi
+}
+
+# Saltar espacios y comentarios con cada núcleo de scan.h.
+bench_blanks() {
+    echo "== Espacios y comentarios: lexer por núcleo de escaneo"
+    local kind level
+    for kind in comments blanks mixed; do
+        for level in scalar sse2 avx2; do
+            "$BUILD/lexbench" "$(input "$kind" "$SIZE")" --scan=$level --repeat="$REPEAT"
+        done
+    done
+}
+
+# Motor clásico frente al DFA de tablas (--lexer).
+bench_dfa() {
+    echo "== Motores del lexer: classic frente a dfa"
+    local kind engine
+    for kind in mixed comments blanks; do
+        for engine in classic dfa; do
+            "$BUILD/lexbench" "$(input "$kind" "$SIZE")" --lexer=$engine --repeat="$REPEAT"
+        done
+    done
+}
+
+# Muchos archivos repartidos en el pool de -j con robo de trabajo, frente a
+# un proceso por archivo.
+bench_jobs() {
+    echo "== Árbol de $FILES archivos con -j N"
+    warn_cores
+    local dir base jobs t
+    dir=$(tree)
+    base=$(best_of "$BUILD/pyclitec" -j 1 "$dir")
+    scaling_row "-j 1" "$base" "$base"
+    for jobs in $BENCH_JOBS; do
+        if [ "$jobs" -gt 1 ]; then
+            t=$(best_of "$BUILD/pyclitec" -j "$jobs" "$dir")
+            scaling_row "-j $jobs" "$t" "$base"
+        fi
+    done
+    t=$(best_of sh -c 'for f in "$1"/*.pycl; do "$2" "$f"; done' sh "$dir" "$BUILD/pyclitec")
+    scaling_row "un proceso por archivo" "$t" "$base"
+}
+
+# Un solo archivo grande parseado por regiones (--split-size) con -j N. Sirve
+# para elegir el tamaño mínimo de región en cada máquina.
+bench_regions() {
+    echo "== Un archivo de $SIZE MB parseado por regiones"
+    warn_cores
+    local file base jobs split t
+    file=$(input mixed "$SIZE")
+    base=$(best_of "$BUILD/pyclitec" "$file")
+    scaling_row "en serie" "$base" "$base"
+    for jobs in $BENCH_JOBS; do
+        if [ "$jobs" -gt 1 ]; then
+            for split in $SPLITS; do
+                t=$(best_of "$BUILD/pyclitec" -j "$jobs" --split-size="$split" "$file")
+                scaling_row "-j $jobs --split-size=$split" "$t" "$base"
+            done
+        fi
+    done
+}
+
+# Tokenización de un archivo grande por trozos separados por el índice
+# estructural (--batch con --split-size), con cada número de hilos y tamaño
+# mínimo de trozo.
+bench_chunks() {
+    echo "== Un archivo de $SIZE MB tokenizado por trozos"
+    warn_cores
+    local file jobs split
+    file=$(input mixed "$SIZE")
+    "$BUILD/lexbench" "$file" --repeat="$REPEAT"
+    for jobs in $BENCH_JOBS; do
+        if [ "$jobs" -gt 1 ]; then
+            for split in $SPLITS; do
+                "$BUILD/lexbench" "$file" --threads="$jobs" --chunk="$split" --repeat="$REPEAT"
+            done
+        fi
+    done
+}
+
+# Lexer en su propio hilo (--pipeline) frente al lexer dentro del parser y
+# a tokenizar todo antes de parsear (--batch).
+bench_pipeline() {
+    echo "== Un archivo de $SIZE MB con el lexer en otro hilo"
+    warn_cores
+    local file base t
+    file=$(input mixed "$SIZE")
+    base=$(best_of "$BUILD/pyclitec" "$file")
+    scaling_row "secuencial" "$base" "$base"
+    t=$(best_of "$BUILD/pyclitec" --batch "$file")
+    scaling_row "--batch" "$t" "$base"
+    t=$(best_of "$BUILD/pyclitec" --pipeline "$file")
+    scaling_row "--pipeline" "$t" "$base"
+}
+
+# Parser de expresiones por precedencia sobre una entrada hecha casi solo de
+# expresiones anidadas, con cada representación del árbol, frente a la
+# entrada mixta.
+bench_exprs() {
+    echo "== Parseo de expresiones"
+    local kind file t mode
+    for kind in exprs mixed; do
+        file=$(input "$kind" "$SIZE")
+        for mode in "" --heap-ast --flat-ast; do
+            t=$(best_of "$BUILD/pyclitec" $mode "$file")
+            throughput_row "$kind ${mode:-arena}" "$t" "$SIZE"
+        done
+    done
+}
+
+# Identificadores internados en el lexer: una entrada hecha casi solo de
+# nombres (veinte mil base, y uno nuevo con sufijo en casi cada línea),
+# frente a la mixta, en el lexer solo y en el parseo.
+bench_idents() {
+    echo "== Entrada llena de identificadores"
+    local kind file t
+    for kind in idents mixed; do
+        file=$(input "$kind" "$SIZE")
+        "$BUILD/lexbench" "$file" --repeat="$REPEAT"
+        t=$(best_of "$BUILD/pyclitec" "$file")
+        throughput_row "$kind parseo" "$t" "$SIZE"
+    done
+}
+
+# Mejor tiempo de cada comando, en nanosegundos, alternándolos en cada vuelta
+# para que los dos sufran el mismo ruido.
+best_pair() {
+    local repeat=$1 first=$2 second=$3 run t best_first="" best_second=""
+    shift 3
+    for run in $(seq "$repeat"); do
+        t=$(time_once "$first" "$@")
+        if [ -z "$best_first" ] || [ "$t" -lt "$best_first" ]; then
+            best_first=$t
+        fi
+        t=$(time_once "$second" "$@")
+        if [ -z "$best_second" ] || [ "$t" -lt "$best_second" ]; then
+            best_second=$t
+        fi
+    done
+    echo "$best_first $best_second"
+}
+
+# Guarda del camino sin errores: compila con -O2 el compilador de la
+# referencia BENCH_BASELINE (HEAD por defecto, es decir, sin los cambios
+# pendientes) y lo cronometra alternándolo con el actual sobre entradas sin
+# errores. Falla si el actual es más lento que la referencia en más de
+# BENCH_TOLERANCE por ciento (5 por defecto) en algún caso. Con menos de 9
+# vueltas por lado el ruido de una máquina compartida ya ronda ese margen, y
+# un caso que se pasa se vuelve a medir antes de darlo por más lento.
+bench_guard() {
+    local ref=${BENCH_BASELINE:-HEAD} tolerance=${BENCH_TOLERANCE:-5}
+    local repeat=$((REPEAT < 9 ? 9 : REPEAT))
+    local commit baseline kind mode file attempt times slower failed=0
+    commit=$(git rev-parse --short "$ref^{commit}")
+    baseline=$BUILD/baseline-$commit
+    echo "== Camino sin errores frente a $ref ($commit), tolerancia $tolerance%"
+    if [ ! -x "$baseline/pyclitec" ]; then
+        rm -rf "$baseline"
+        mkdir -p "$baseline"
+        git archive "$commit" | tar -x -C "$baseline"
+        make -s -C "$baseline" CC="${CC:-cc} -O2" pyclitec > /dev/null
+    fi
+    printf "  %-32s %10s  %10s\n" "" "referencia" "actual"
+    for kind in mixed exprs; do
+        file=$(input "$kind" "$SIZE")
+        if ! "$BUILD/pyclitec" "$file" > /dev/null 2>&1; then
+            echo "  $file tiene errores: no sirve para medir el camino sin errores" >&2
+            return 1
+        fi
+        for mode in "" --flat-ast; do
+            for attempt in 1 2; do
+                times=$(best_pair "$repeat" "$baseline/pyclitec" "$BUILD/pyclitec" $mode "$file")
+                slower=0
+                awk -v label="$kind ${mode:-arena}" -v times="$times" -v tol="$tolerance" '
+                    BEGIN {
+                        split(times, t, " ")
+                        change = (t[2] / t[1] - 1) * 100
+                        printf "  %-32s %8.3f s  %8.3f s  %+6.1f%%%s\n", label, t[1] / 1e9, t[2] / 1e9, change,
+                               (change > tol ? "  MÁS LENTO" : "")
+                        exit (change > tol)
+                    }' || slower=1
+                if [ "$slower" -eq 0 ]; then
+                    break
+                fi
+            done
+            failed=$((failed | slower))
+        done
+    done
+    return "$failed"
+}
+
+# Latencia de --connect frente a una ejecución en frío: con el archivo sin
+# cambios, tras editar su final y con el árbol de proyecto entero.
+bench_server() {
+    echo "== Servidor (--connect) frente a una ejecución en frío"
+    local file dir work socket base t
+    file=$(input mixed "$SIZE")
+    dir=$(tree)
+    work=$(mktemp -d)
+    socket=$work/pyclite.sock
+    cp "$file" "$work/edit.pycl"
+    "$BUILD/pyclitec" --serve="$socket" > /dev/null &
+    trap '"$BUILD/pyclitec" --connect="$socket" --stop > /dev/null 2>&1 || true; rm -rf "$work"' RETURN
+    while [ ! -S "$socket" ]; do
+        sleep 0.05
+    done
+    # La primera petición de cada archivo llena la caché del servidor.
+    "$BUILD/pyclitec" --connect="$socket" "$file" "$work/edit.pycl" "$dir" > /dev/null 2>&1 || true
+
+    base=$(best_of "$BUILD/pyclitec" "$file")
+    scaling_row "$SIZE MB en frío" "$base" "$base"
+    t=$(best_of "$BUILD/pyclitec" --connect="$socket" "$file")
+    scaling_row "$SIZE MB sin cambios" "$t" "$base"
+    t=$(best_of sh -c 'echo "int extra = 1;" >> "$1" && "$2" --connect="$3" "$1"' \
+        sh "$work/edit.pycl" "$BUILD/pyclitec" "$socket")
+    scaling_row "$SIZE MB tras editar el final" "$t" "$base"
+    base=$(best_of "$BUILD/pyclitec" "$dir")
+    scaling_row "árbol en frío" "$base" "$base"
+    t=$(best_of "$BUILD/pyclitec" --connect="$socket" "$dir")
+    scaling_row "árbol sin cambios" "$t" "$base"
+}
+
+SECTIONS=${*:-blanks dfa jobs regions chunks pipeline exprs idents server}
+for section in $SECTIONS; do
+    "bench_$section"
+    echo
+done
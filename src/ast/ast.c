@@ -1,39 +1,218 @@
  #include "ast.h"
 
+#include "stats/stats.h"
+
+ #include <stdalign.h>
+ #include <stddef.h>
  #include <stdlib.h>
+ #include <string.h>
+
+ #define AST_ARENA_CHUNK_SIZE (64 * 1024)
+ #define AST_ARENA_ALIGN alignof(max_align_t)
+
+ struct ASTArenaChunk {
+     ASTArenaChunk *next;
+     size_t used;
+     size_t capacity;
+     alignas(max_align_t) unsigned char data[];
+ };
+
+ static size_t align_up(size_t value) {
+     return (value + AST_ARENA_ALIGN - 1) & ~(size_t)(AST_ARENA_ALIGN - 1);
+ }
+
+ static void *ast_arena_alloc(ASTArena *arena, size_t size) {
+     size = align_up(size);
+     ASTArenaChunk *chunk = arena->chunks;
+     if (!chunk || chunk->capacity - chunk->used < size) {
+         size_t capacity = size > AST_ARENA_CHUNK_SIZE ? size : AST_ARENA_CHUNK_SIZE;
+         chunk = (ASTArenaChunk *)malloc(sizeof(ASTArenaChunk) + capacity);
+         if (!chunk) {
+             return NULL;
+         }
+         chunk->used = 0;
+         chunk->capacity = capacity;
+         chunk->next = arena->chunks;
+         arena->chunks = chunk;
+         arena->chunk_count++;
+     }
+     void *memory = chunk->data + chunk->used;
+     chunk->used += size;
+     STATS_ARENA_ALLOC(size);
+     arena->allocations++;
+     arena->bytes += size;
+     return memory;
+ }
+
+ void ast_arena_init(ASTArena *arena) {
+     arena->chunks = NULL;
+     arena->chunk_count = 0;
+     arena->allocations = 0;
+     arena->bytes = 0;
+ }
+
+ ASTNode *ast_arena_create(ASTArena *arena, ASTNodeType type, Token token) {
+     ASTNode *node = (ASTNode *)ast_arena_alloc(arena, sizeof(ASTNode));
+     if (!node) {
+         return NULL;
+     }
+     STATS_NODE(type);
+     node->type = type;
+     node->token = token;
+     node->depth = 0;
+     node->slot = AST_NO_SLOT;
+     node->frame_size = 0;
+     node->value_type = VALUE_UNKNOWN;
+     node->children = NULL;
+     node->child_count = 0;
+     node->child_capacity = 0;
+     node->arena = arena;
+     return node;
+ }
+
+ void ast_arena_reset(ASTArena *arena) {
+     ASTArenaChunk *keep = arena->chunks;
+     if (keep) {
+         ASTArenaChunk *chunk = keep->next;
+         while (chunk) {
+             ASTArenaChunk *next = chunk->next;
+             free(chunk);
+             chunk = next;
+         }
+         keep->next = NULL;
+         keep->used = 0;
+     }
+     arena->chunk_count = keep ? 1 : 0;
+     arena->allocations = 0;
+     arena->bytes = 0;
+ }
+
+ void ast_arena_free(ASTArena *arena) {
+     ASTArenaChunk *chunk = arena->chunks;
+     while (chunk) {
+         ASTArenaChunk *next = chunk->next;
+         free(chunk);
+         chunk = next;
+     }
+     ast_arena_init(arena);
+ }
+
+ const char *ast_type_str(ASTNodeType type) {
+     switch (type) {
+ #define AST_NAME(t) case t: return #t;
+         AST_NAME(AST_PROGRAM)
+         AST_NAME(AST_INSTRUCTION_LIST)
+         AST_NAME(AST_DECLARATION)
+         AST_NAME(AST_ASSIGNMENT)
+         AST_NAME(AST_IF)
+         AST_NAME(AST_FOR)
+         AST_NAME(AST_WHILE)
+         AST_NAME(AST_FUNCTION)
+         AST_NAME(AST_CALL)
+         AST_NAME(AST_RETURN)
+         AST_NAME(AST_EXPRESSION)
+         AST_NAME(AST_LITERAL)
+         AST_NAME(AST_IDENTIFIER)
+         AST_NAME(AST_ARRAY_LITERAL)
+         AST_NAME(AST_PARAM_LIST)
+         AST_NAME(AST_ARG_LIST)
+         AST_NAME(AST_COMMENT)
+ #undef AST_NAME
+         default:
+             return "AST_UNDEFINED";
+     }
+ }
 
  ASTNode *ast_create(ASTNodeType type, Token token) {
      ASTNode *node = (ASTNode *)calloc(1, sizeof(ASTNode));
      if (!node) {
          return NULL;
      }
+     STATS_HEAP_ALLOC(sizeof(ASTNode));
+     STATS_NODE(type);
      node->type = type;
      node->token = token;
+     node->slot = AST_NO_SLOT;
      return node;
  }
 
+ static bool ast_grow_children(ASTNode *parent) {
+     uint32_t new_capacity = parent->child_capacity ? parent->child_capacity * 2 : 2;
+     ASTNode **new_children;
+     if (parent->arena) {
+         new_children = (ASTNode **)ast_arena_alloc(parent->arena, new_capacity * sizeof(ASTNode *));
+         if (new_children && parent->child_count) {
+             memcpy(new_children, parent->children, parent->child_count * sizeof(ASTNode *));
+         }
+     } else {
+         new_children = (ASTNode **)realloc(parent->children, new_capacity * sizeof(ASTNode *));
+     }
+     if (!new_children) {
+         return false;
+     }
+     if (!parent->arena) {
+         STATS_HEAP_ALLOC(new_capacity * sizeof(ASTNode *));
+     }
+     parent->children = new_children;
+     parent->child_capacity = new_capacity;
+     return true;
+ }
+
  void ast_add_child(ASTNode *parent, ASTNode *child) {
      if (!parent || !child) {
          return;
      }
-     size_t new_count = parent->child_count + 1;
-     ASTNode **new_children = (ASTNode **)realloc(parent->children, new_count * sizeof(ASTNode *));
-     if (!new_children) {
+     if (parent->child_count == parent->child_capacity && !ast_grow_children(parent)) {
          return;
      }
-     parent->children = new_children;
-     parent->children[parent->child_count] = child;
-     parent->child_count = new_count;
+     parent->children[parent->child_count++] = child;
  }
 
- void ast_free(ASTNode *node) {
-     if (!node) {
+ static void ast_free_recursive(ASTNode *node) {
+     if (!node || node->arena) {
          return;
      }
      for (size_t i = 0; i < node->child_count; ++i) {
-         ast_free(node->children[i]);
+         ast_free_recursive(node->children[i]);
      }
      free(node->children);
      free(node);
  }
 
+ // Iterativo: el parser de expresiones admite anidamientos limitados solo por
+ // el heap, así que liberar el árbol tampoco puede depender de la pila de C.
+ void ast_free(ASTNode *node) {
+     if (!node || node->arena) {
+         return;
+     }
+     size_t capacity = 64;
+     size_t depth = 0;
+     ASTNode **stack = (ASTNode **)malloc(capacity * sizeof(ASTNode *));
+     if (!stack) {
+         ast_free_recursive(node);
+         return;
+     }
+     stack[depth++] = node;
+     while (depth > 0) {
+         ASTNode *current = stack[--depth];
+         for (size_t i = 0; i < current->child_count; ++i) {
+             ASTNode *child = current->children[i];
+             if (!child || child->arena) {
+                 continue;
+             }
+             if (depth == capacity) {
+                 ASTNode **grown = (ASTNode **)realloc(stack, capacity * 2 * sizeof(ASTNode *));
+                 if (!grown) {
+                     ast_free_recursive(child);
+                     continue;
+                 }
+                 stack = grown;
+                 capacity *= 2;
+             }
+             stack[depth++] = child;
+         }
+         free(current->children);
+         free(current);
+     }
+     free(stack);
+ }
@@ -25,16 +25,79 @@
      AST_COMMENT
  } ASTNodeType;
 
+ typedef struct ASTArenaChunk ASTArenaChunk;
+
+ typedef struct ASTArena {
+     ASTArenaChunk *chunks;
+     size_t chunk_count;
+     size_t allocations;
+     size_t bytes;
+ } ASTArena;
+
+ // slot de los identificadores que el resolvedor no pudo resolver.
+ #define AST_NO_SLOT UINT32_MAX
+ #define AST_NO_DECLARATION UINT32_MAX
+
+ // Tipo de valor que la inferencia (types.h) asigna a una expresión.
+ // VALUE_UNKNOWN es "sin analizar" o "nunca produce un valor"; VALUE_DYNAMIC,
+ // que el tipo depende de la ejecución y hace falta comprobarlo en tiempo real.
+ typedef enum {
+     VALUE_UNKNOWN,
+     VALUE_INT,
+     VALUE_FLOAT,
+     VALUE_CHAR,
+     VALUE_BOOL,
+     VALUE_STRING,
+     VALUE_ARRAY,
+     VALUE_FUNC,
+     VALUE_VOID,
+     VALUE_DYNAMIC
+ } ValueType;
+
  typedef struct ASTNode {
      ASTNodeType type;
      Token token;
+     // Anotaciones del resolvedor de nombres (resolver.h). Identificadores: la
+     // variable está en el hueco slot del marco que queda depth funciones hacia
+     // fuera, y declaration numera su declaración. AST_PROGRAM y AST_FUNCTION:
+     // número de huecos de su marco.
+     union {
+         struct {
+             uint32_t depth;
+             uint32_t slot;
+         };
+         // AST_LITERAL calculado por el optimizador (optimizer.h), que no tiene
+         // lexema (token.length es 0): su valor, real si value_type es
+         // VALUE_FLOAT y entero si no.
+         int64_t integer;
+         double real;
+     };
+     union {
+         uint32_t frame_size;
+         uint32_t declaration;
+         // AST_CALL: especialización de la func llamada (types.h).
+         uint32_t specialization;
+     };
+     // Anotación de la inferencia de tipos en las expresiones.
+     ValueType value_type;
      struct ASTNode **children;
-     size_t child_count;
+     uint32_t child_count;
+     uint32_t child_capacity;
+     ASTArena *arena;
  } ASTNode;
 
+ const char *ast_type_str(ASTNodeType type);
+
  ASTNode *ast_create(ASTNodeType type, Token token);
  void ast_add_child(ASTNode *parent, ASTNode *child);
  void ast_free(ASTNode *node);
 
+ // Los nodos creados en un arena se liberan todos juntos con ast_arena_reset o
+ // ast_arena_free; ast_free sobre ellos no hace nada.
+ void ast_arena_init(ASTArena *arena);
+ ASTNode *ast_arena_create(ASTArena *arena, ASTNodeType type, Token token);
+ void ast_arena_reset(ASTArena *arena);
+ void ast_arena_free(ASTArena *arena);
+
  #endif // PYCLITE_AST_H
 
@@ -0,0 +1,151 @@
+#include "flat_ast.h"
+
+#include <stdlib.h>
+
+void flat_ast_init(FlatAST *ast) {
+    ast->kinds = NULL;
+    ast->tokens = NULL;
+    ast->subtree_end = NULL;
+    ast->count = 0;
+    ast->capacity = 0;
+    ast->token_table = NULL;
+    ast->token_count = 0;
+    ast->token_capacity = 0;
+}
+
+void flat_ast_free(FlatAST *ast) {
+    free(ast->kinds);
+    free(ast->tokens);
+    free(ast->subtree_end);
+    free(ast->token_table);
+    flat_ast_init(ast);
+}
+
+static bool grow_array(uint32_t **array, uint32_t capacity) {
+    uint32_t *grown = (uint32_t *)realloc(*array, (size_t)capacity * sizeof(uint32_t));
+    if (!grown) {
+        return false;
+    }
+    *array = grown;
+    return true;
+}
+
+static bool flat_ast_reserve(FlatAST *ast) {
+    if (ast->count < ast->capacity) {
+        return true;
+    }
+    if (ast->capacity >= FLAT_AST_NONE / 2) {
+        return false;
+    }
+    uint32_t capacity = ast->capacity ? ast->capacity * 2 : 256;
+    if (!grow_array(&ast->kinds, capacity) || !grow_array(&ast->tokens, capacity) ||
+        !grow_array(&ast->subtree_end, capacity)) {
+        return false;
+    }
+    ast->capacity = capacity;
+    return true;
+}
+
+static uint32_t flat_ast_intern_token(FlatAST *ast, Token token) {
+    // Los nodos envoltorio (asignación, sentencia de expresión) reutilizan el
+    // token de su primer hijo, que en preorden es el nodo siguiente.
+    if (ast->token_count) {
+        const Token *last = &ast->token_table[ast->token_count - 1];
+        if (last->type == token.type && last->offset == token.offset && last->length == token.length) {
+            return ast->token_count - 1;
+        }
+    }
+    if (ast->token_count == ast->token_capacity) {
+        uint32_t capacity = ast->token_capacity ? ast->token_capacity * 2 : 256;
+        Token *grown = (Token *)realloc(ast->token_table, (size_t)capacity * sizeof(Token));
+        if (!grown) {
+            return FLAT_AST_NONE;
+        }
+        ast->token_table = grown;
+        ast->token_capacity = capacity;
+    }
+    ast->token_table[ast->token_count] = token;
+    return ast->token_count++;
+}
+
+uint32_t flat_ast_push(FlatAST *ast, ASTNodeType kind, Token token) {
+    if (!flat_ast_reserve(ast)) {
+        return FLAT_AST_NONE;
+    }
+    uint32_t token_index = flat_ast_intern_token(ast, token);
+    if (token_index == FLAT_AST_NONE) {
+        return FLAT_AST_NONE;
+    }
+    uint32_t index = ast->count++;
+    ast->kinds[index] = (uint32_t)kind;
+    ast->tokens[index] = token_index;
+    ast->subtree_end[index] = index + 1;
+    return index;
+}
+
+void flat_ast_close(FlatAST *ast, uint32_t node) {
+    ast->subtree_end[node] = ast->count;
+}
+
+typedef struct {
+    const ASTNode *node;
+    uint32_t index;
+    size_t next_child;
+} FlattenFrame;
+
+bool flat_ast_append_tree(FlatAST *ast, const ASTNode *root) {
+    if (!root) {
+        return true;
+    }
+    size_t depth = 0;
+    size_t capacity = 64;
+    FlattenFrame *stack = (FlattenFrame *)malloc(capacity * sizeof(FlattenFrame));
+    if (!stack) {
+        return false;
+    }
+    uint32_t index = flat_ast_push(ast, root->type, root->token);
+    if (index == FLAT_AST_NONE) {
+        free(stack);
+        return false;
+    }
+    stack[depth++] = (FlattenFrame){root, index, 0};
+
+    while (depth > 0) {
+        FlattenFrame *frame = &stack[depth - 1];
+        if (frame->next_child == frame->node->child_count) {
+            flat_ast_close(ast, frame->index);
+            depth--;
+            continue;
+        }
+        const ASTNode *child = frame->node->children[frame->next_child++];
+        index = flat_ast_push(ast, child->type, child->token);
+        if (index == FLAT_AST_NONE) {
+            free(stack);
+            return false;
+        }
+        if (depth == capacity) {
+            capacity *= 2;
+            FlattenFrame *grown = (FlattenFrame *)realloc(stack, capacity * sizeof(FlattenFrame));
+            if (!grown) {
+                free(stack);
+                return false;
+            }
+            stack = grown;
+        }
+        stack[depth++] = (FlattenFrame){child, index, 0};
+    }
+    free(stack);
+    return true;
+}
+
+uint32_t flat_ast_child_count(const FlatAST *ast, uint32_t node) {
+    uint32_t count = 0;
+    for (uint32_t child = node + 1; child < ast->subtree_end[node]; child = ast->subtree_end[child]) {
+        count++;
+    }
+    return count;
+}
+
+size_t flat_ast_memory(const FlatAST *ast) {
+    return (size_t)ast->capacity * 3 * sizeof(uint32_t) + (size_t)ast->token_capacity * sizeof(Token);
+}
@@ -0,0 +1,35 @@
+#ifndef PYCLITE_FLAT_AST_H
+#define PYCLITE_FLAT_AST_H
+
+#include "ast/ast.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLAT_AST_NONE UINT32_MAX
+
+// AST compacto en preorden: los hijos del nodo i empiezan en i + 1 y su
+// subárbol termina en subtree_end[i], de modo que los hermanos se recorren con
+// `for (uint32_t c = i + 1; c < ast->subtree_end[i]; c = ast->subtree_end[c])`.
+typedef struct {
+    uint32_t *kinds;
+    uint32_t *tokens;
+    uint32_t *subtree_end;
+    uint32_t count;
+    uint32_t capacity;
+
+    Token *token_table;
+    uint32_t token_count;
+    uint32_t token_capacity;
+} FlatAST;
+
+void flat_ast_init(FlatAST *ast);
+void flat_ast_free(FlatAST *ast);
+uint32_t flat_ast_push(FlatAST *ast, ASTNodeType kind, Token token);
+void flat_ast_close(FlatAST *ast, uint32_t node);
+bool flat_ast_append_tree(FlatAST *ast, const ASTNode *root);
+uint32_t flat_ast_child_count(const FlatAST *ast, uint32_t node);
+size_t flat_ast_memory(const FlatAST *ast);
+
+#endif // PYCLITE_FLAT_AST_H
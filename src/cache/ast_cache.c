@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ast_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define AST_CACHE_ALIGN 64
+#define AST_CACHE_BYTE_ORDER 0x01020304u
+
+static const char AST_CACHE_MAGIC[8] = "PYCLAST";
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t token_size;
+    uint32_t kind_count;
+    uint32_t token_type_count;
+    uint32_t node_count;
+    uint32_t token_count;
+    uint32_t reserved;
+    uint64_t source_hash;
+    uint64_t source_length;
+    // Posición de cada sección desde el principio del archivo.
+    uint64_t kinds_offset;
+    uint64_t tokens_offset;
+    uint64_t ends_offset;
+    uint64_t table_offset;
+    uint64_t size;
+} AstCacheHeader;
+
+static uint64_t align_section(uint64_t offset) {
+    return (offset + AST_CACHE_ALIGN - 1) & ~(uint64_t)(AST_CACHE_ALIGN - 1);
+}
+
+static void header_layout(AstCacheHeader *header, uint64_t source_hash, uint64_t source_length,
+                          uint32_t node_count, uint32_t token_count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, AST_CACHE_MAGIC, sizeof(header->magic));
+    header->version = AST_CACHE_VERSION;
+    header->byte_order = AST_CACHE_BYTE_ORDER;
+    header->token_size = (uint32_t)sizeof(Token);
+    header->kind_count = AST_COMMENT + 1;
+    header->token_type_count = TOKEN_UNKNOWN + 1;
+    header->node_count = node_count;
+    header->token_count = token_count;
+    header->source_hash = source_hash;
+    header->source_length = source_length;
+    uint64_t nodes = (uint64_t)node_count * sizeof(uint32_t);
+    header->kinds_offset = align_section(sizeof(AstCacheHeader));
+    header->tokens_offset = align_section(header->kinds_offset + nodes);
+    header->ends_offset = align_section(header->tokens_offset + nodes);
+    header->table_offset = align_section(header->ends_offset + nodes);
+    header->size = header->table_offset + (uint64_t)token_count * sizeof(Token);
+}
+
+static char *entry_path(const char *dir, uint64_t source_hash) {
+    size_t length = strlen(dir) + 1 + 16 + 4 + 1;
+    char *path = (char *)malloc(length);
+    if (path) {
+        snprintf(path, length, "%s/%016llx.ast", dir, (unsigned long long)source_hash);
+    }
+    return path;
+}
+
+bool ast_cache_prepare(const char *dir) {
+    if (mkdir(dir, 0777) == 0 || errno == EEXIST) {
+        struct stat info;
+        return stat(dir, &info) == 0 && S_ISDIR(info.st_mode);
+    }
+    return false;
+}
+
+// Comprueba los datos de una entrada cuya cabecera ya es válida. El
+// directorio de la caché es compartido, así que un archivo truncado o
+// manipulado no debe poder colgar ni sacar de la proyección a quien recorra el
+// árbol: cada nodo debe tener un tipo y un token existentes, y su subárbol
+// debe empezar después de él y quedar dentro del de su padre.
+static bool entry_valid(const AstCacheHeader *header, const char *base, size_t source_length) {
+    const uint32_t *kinds = (const uint32_t *)(base + header->kinds_offset);
+    const uint32_t *tokens = (const uint32_t *)(base + header->tokens_offset);
+    const uint32_t *ends = (const uint32_t *)(base + header->ends_offset);
+    const Token *table = (const Token *)(base + header->table_offset);
+    uint32_t count = header->node_count;
+
+    for (uint32_t i = 0; i < header->token_count; i++) {
+        if ((uint32_t)table[i].type >= header->token_type_count ||
+            (uint64_t)table[i].offset + table[i].length > source_length) {
+            return false;
+        }
+    }
+    if (count == 0) {
+        return true;
+    }
+    if (ends[0] != count) {
+        return false;
+    }
+    // Pila con el final del subárbol de cada antecesor abierto.
+    uint32_t *open_ends = (uint32_t *)malloc((size_t)count * sizeof(uint32_t));
+    if (!open_ends) {
+        return false;
+    }
+    size_t depth = 0;
+    bool valid = true;
+    for (uint32_t i = 0; i < count && valid; i++) {
+        while (depth > 0 && open_ends[depth - 1] <= i) {
+            depth--;
+        }
+        uint32_t parent_end = depth > 0 ? open_ends[depth - 1] : count;
+        valid = kinds[i] < header->kind_count && tokens[i] < header->token_count && i < ends[i] &&
+                ends[i] <= parent_end;
+        open_ends[depth++] = ends[i];
+    }
+    free(open_ends);
+    return valid;
+}
+
+bool ast_cache_load(const char *dir, uint64_t source_hash, size_t source_length, AstCacheEntry *entry) {
+    char *path = entry_path(dir, source_hash);
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) {
+        free(path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(AstCacheHeader)) {
+        close(fd);
+        free(path);
+        return false;
+    }
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        free(path);
+        return false;
+    }
+
+    // La cabecera debe coincidir exactamente con la que escribiría este binario
+    // para un árbol de ese tamaño; eso cubre versión, arquitectura y límites.
+    const AstCacheHeader *stored = (const AstCacheHeader *)mapping;
+    AstCacheHeader expected;
+    header_layout(&expected, source_hash, source_length, stored->node_count, stored->token_count);
+    if (memcmp(stored, &expected, sizeof(expected)) != 0) {
+        munmap(mapping, size);
+        free(path);
+        return false;
+    }
+    // Una entrada de este binario truncada o con datos incoherentes no es de
+    // otra versión sino un archivo roto: se borra para que se vuelva a escribir.
+    if (expected.size != size || !entry_valid(stored, (const char *)mapping, source_length)) {
+        munmap(mapping, size);
+        unlink(path);
+        free(path);
+        return false;
+    }
+    free(path);
+
+    const char *base = (const char *)mapping;
+    FlatAST *ast = &entry->ast;
+    ast->kinds = (uint32_t *)(base + stored->kinds_offset);
+    ast->tokens = (uint32_t *)(base + stored->tokens_offset);
+    ast->subtree_end = (uint32_t *)(base + stored->ends_offset);
+    ast->count = stored->node_count;
+    ast->capacity = stored->node_count;
+    ast->token_table = (Token *)(base + stored->table_offset);
+    ast->token_count = stored->token_count;
+    ast->token_capacity = stored->token_count;
+    entry->mapping = mapping;
+    entry->size = size;
+    return true;
+}
+
+static bool write_section(FILE *stream, uint64_t *position, uint64_t offset, const void *data, size_t size) {
+    static const char padding[AST_CACHE_ALIGN] = {0};
+    if (fwrite(padding, 1, (size_t)(offset - *position), stream) != offset - *position) {
+        return false;
+    }
+    if (size && fwrite(data, 1, size, stream) != size) {
+        return false;
+    }
+    *position = offset + size;
+    return true;
+}
+
+bool ast_cache_store(const char *dir, uint64_t source_hash, size_t source_length, const FlatAST *ast) {
+    char *path = entry_path(dir, source_hash);
+    size_t temp_length = strlen(dir) + sizeof("/.ast-XXXXXX");
+    char *temp = (char *)malloc(temp_length);
+    if (!path || !temp) {
+        free(path);
+        free(temp);
+        return false;
+    }
+    snprintf(temp, temp_length, "%s/.ast-XXXXXX", dir);
+    int fd = mkstemp(temp);
+    FILE *stream = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!stream) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(temp);
+        }
+        free(path);
+        free(temp);
+        return false;
+    }
+
+    AstCacheHeader header;
+    header_layout(&header, source_hash, source_length, ast->count, ast->token_count);
+    size_t nodes = (size_t)ast->count * sizeof(uint32_t);
+    uint64_t position = 0;
+    bool ok = write_section(stream, &position, 0, &header, sizeof(header)) &&
+              write_section(stream, &position, header.kinds_offset, ast->kinds, nodes) &&
+              write_section(stream, &position, header.tokens_offset, ast->tokens, nodes) &&
+              write_section(stream, &position, header.ends_offset, ast->subtree_end, nodes) &&
+              write_section(stream, &position, header.table_offset, ast->token_table,
+                            (size_t)ast->token_count * sizeof(Token));
+    ok = fclose(stream) == 0 && ok;
+    // Los permisos de mkstemp (0600) se relajan para que la caché sea compartible.
+    ok = ok && chmod(temp, 0644) == 0 && rename(temp, path) == 0;
+    if (!ok) {
+        unlink(temp);
+    }
+    free(path);
+    free(temp);
+    return ok;
+}
+
+void ast_cache_release(AstCacheEntry *entry) {
+    if (entry->mapping) {
+        munmap(entry->mapping, entry->size);
+    }
+    entry->mapping = NULL;
+    entry->size = 0;
+    flat_ast_init(&entry->ast);
+}
@@ -0,0 +1,42 @@
+#ifndef PYCLITE_AST_CACHE_H
+#define PYCLITE_AST_CACHE_H
+
+#include "ast/flat_ast.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Caché en disco de ASTs compactos, un archivo <hash>.ast por contenido de
+// fuente. El archivo es una cabecera seguida de los arreglos de FlatAST tal
+// cual están en memoria, alineados a 64 bytes; al cargarlo se proyecta con
+// mmap y los punteros del FlatAST apuntan dentro de la proyección, sin copiar
+// ni convertir nada. Todo es relativo a la fuente (offsets de token), así que
+// el archivo no depende de dónde se cargue.
+//
+// AST_CACHE_VERSION se incrementa con cualquier cambio de formato o de la
+// forma del árbol que produce el parser; las entradas de otra versión, de otra
+// arquitectura o con otra disposición de Token se ignoran.
+// Versión 2: Token incluye el símbolo internado (la tabla de nombres no se
+// guarda; los símbolos solo sirven para comparar nombres entre sí).
+#define AST_CACHE_VERSION 2
+
+typedef struct {
+    // Vista de solo lectura: no se puede ampliar ni pasar a flat_ast_free.
+    FlatAST ast;
+    void *mapping;
+    size_t size;
+} AstCacheEntry;
+
+// Crea el directorio si no existe.
+bool ast_cache_prepare(const char *dir);
+// Proyecta la entrada de la fuente con ese hash y longitud. Devuelve false si
+// no existe o no es válida para este binario; las entradas de este binario
+// truncadas o con un árbol incoherente se borran.
+bool ast_cache_load(const char *dir, uint64_t source_hash, size_t source_length, AstCacheEntry *entry);
+// Escribe la entrada en un temporal y la renombra, así que varios procesos o
+// hilos pueden guardar la misma a la vez sin dejar archivos a medias.
+bool ast_cache_store(const char *dir, uint64_t source_hash, size_t source_length, const FlatAST *ast);
+void ast_cache_release(AstCacheEntry *entry);
+
+#endif // PYCLITE_AST_CACHE_H
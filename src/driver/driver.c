@@ -0,0 +1,584 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "driver.h"
+
+#include "cache/ast_cache.h"
+#include "lexer/structural.h"
+#include "parser/parser.h"
+#include "resolver/resolver.h"
+#include "source/source.h"
+#include "stats/stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void driver_file_list_init(DriverFileList *list) {
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+void driver_file_list_free(DriverFileList *list) {
+    for (size_t i = 0; i < list->count; ++i) {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    driver_file_list_init(list);
+}
+
+static bool file_list_push(DriverFileList *list, char *path) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        char **paths = (char **)realloc(list->paths, capacity * sizeof(char *));
+        if (!paths) {
+            free(path);
+            return false;
+        }
+        list->paths = paths;
+        list->capacity = capacity;
+    }
+    list->paths[list->count++] = path;
+    return true;
+}
+
+static char *path_copy(const char *path) {
+    size_t length = strlen(path) + 1;
+    char *copy = (char *)malloc(length);
+    if (copy) {
+        memcpy(copy, path, length);
+    }
+    return copy;
+}
+
+static char *path_join(const char *dir, const char *name) {
+    size_t dir_length = strlen(dir);
+    size_t name_length = strlen(name);
+    bool slash = dir_length > 0 && dir[dir_length - 1] != '/';
+    char *path = (char *)malloc(dir_length + slash + name_length + 1);
+    if (!path) {
+        return NULL;
+    }
+    memcpy(path, dir, dir_length);
+    if (slash) {
+        path[dir_length] = '/';
+    }
+    memcpy(path + dir_length + slash, name, name_length + 1);
+    return path;
+}
+
+static bool has_pycl_extension(const char *name) {
+    size_t length = strlen(name);
+    return length > 5 && strcmp(name + length - 5, ".pycl") == 0;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool collect_directory(DriverFileList *list, const char *dir) {
+    DIR *handle = opendir(dir);
+    if (!handle) {
+        return false;
+    }
+    DriverFileList names;
+    driver_file_list_init(&names);
+    bool ok = true;
+    struct dirent *entry;
+    while (ok && (entry = readdir(handle)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char *name = path_copy(entry->d_name);
+        ok = name && file_list_push(&names, name);
+    }
+    closedir(handle);
+    if (names.count > 1) {
+        qsort(names.paths, names.count, sizeof(char *), compare_names);
+    }
+    for (size_t i = 0; ok && i < names.count; ++i) {
+        char *path = path_join(dir, names.paths[i]);
+        if (!path) {
+            ok = false;
+            break;
+        }
+        struct stat info;
+        // Los enlaces simbólicos a directorios no se siguen para no caer en ciclos.
+        if (lstat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+            ok = collect_directory(list, path);
+            free(path);
+        } else if (has_pycl_extension(names.paths[i]) && stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+            ok = file_list_push(list, path);
+        } else {
+            free(path);
+        }
+    }
+    driver_file_list_free(&names);
+    return ok;
+}
+
+bool driver_collect(DriverFileList *list, const char *path) {
+    struct stat info;
+    if (strcmp(path, "-") != 0 && stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+        return collect_directory(list, path);
+    }
+    char *copy = path_copy(path);
+    return copy && file_list_push(list, copy);
+}
+
+static void store_cached(const DriverOptions *options, uint64_t hash, const SourceFile *file,
+                         const ASTNode *program, const FlatAST *flat) {
+    if (!program) {
+        ast_cache_store(options->cache_dir, hash, file->length, flat);
+        return;
+    }
+    FlatAST tree;
+    flat_ast_init(&tree);
+    if (flat_ast_append_tree(&tree, program)) {
+        ast_cache_store(options->cache_dir, hash, file->length, &tree);
+    }
+    flat_ast_free(&tree);
+}
+
+static bool count_instruction(ASTNode *instruction, void *ctx) {
+    (void)instruction;
+    ++*(size_t *)ctx;
+    return true;
+}
+
+void driver_result_free(DriverResult *result) {
+    free(result->more_errors);
+    result->more_errors = NULL;
+    result->more_error_count = 0;
+}
+
+static void collect_errors(Parser *parser, DriverResult *result) {
+    result->location = parser_error_location(parser);
+    snprintf(result->message, sizeof(result->message), "%s", parser_error_message(parser));
+    size_t count = parser_error_count(parser);
+    if (count < 2) {
+        return;
+    }
+    result->more_errors = (DriverDiagnostic *)malloc((count - 1) * sizeof(DriverDiagnostic));
+    if (!result->more_errors) {
+        return;
+    }
+    for (size_t i = 1; i < count; ++i) {
+        result->more_errors[i - 1].location = parser_error_location_at(parser, i);
+        result->more_errors[i - 1].message = parser_error_message_at(parser, i);
+    }
+    result->more_error_count = count - 1;
+}
+
+// Devuelve el número de declaraciones, que necesita la inferencia de tipos.
+static size_t resolve_names(Parser *parser, ASTNode *program, const DriverOptions *options, DriverResult *result) {
+    Resolver resolver;
+    resolver_init(&resolver);
+    resolver_set_max_errors(&resolver, options->max_errors);
+    if (!resolver_resolve(&resolver, program, parser_symbols(parser))) {
+        result->status = DRIVER_NAME_ERROR;
+        const ResolverDiagnostic *first = &resolver.errors[0];
+        result->location = lexer_location(&parser->lexer, first->token.offset);
+        snprintf(result->message, sizeof(result->message), "%s", first->message);
+        size_t count = resolver.error_count;
+        result->more_errors = count > 1 ? (DriverDiagnostic *)malloc((count - 1) * sizeof(DriverDiagnostic)) : NULL;
+        if (result->more_errors) {
+            for (size_t i = 1; i < count; ++i) {
+                result->more_errors[i - 1].location = lexer_location(&parser->lexer, resolver.errors[i].token.offset);
+                result->more_errors[i - 1].message = resolver.errors[i].message;
+            }
+            result->more_error_count = count - 1;
+        }
+    }
+    size_t declarations = resolver.declaration_count;
+    resolver_free(&resolver);
+    return declarations;
+}
+
+// Los nombres sin resolver no impiden inferir: quedan como VALUE_DYNAMIC. Sin
+// memoria, el archivo simplemente no suma al informe.
+static void infer_types(Parser *parser, ASTNode *program, size_t declarations, DriverResult *result) {
+    TypeInference types;
+    types_init(&types);
+    if (types_infer(&types, program, declarations, parser->lexer.source)) {
+        result->types = types.summary;
+    }
+    types_free(&types);
+}
+
+// Como con los tipos, sin memoria el archivo queda sin resumen.
+static void optimize(Parser *parser, ASTNode *program, DriverResult *result) {
+    Optimizer optimizer;
+    optimizer_init(&optimizer);
+    if (optimizer_optimize(&optimizer, program, parser->lexer.source)) {
+        result->optimization = optimizer.summary;
+    }
+    optimizer_free(&optimizer);
+}
+
+void driver_compile_file(const char *path, const DriverOptions *options, DriverResult *result) {
+    result->status = DRIVER_OK;
+    result->instruction_count = 0;
+    result->location.line = 0;
+    result->location.column = 0;
+    result->message[0] = '\0';
+    result->more_errors = NULL;
+    result->more_error_count = 0;
+    memset(&result->types, 0, sizeof(result->types));
+    memset(&result->optimization, 0, sizeof(result->optimization));
+
+    STATS_COUNT(files);
+    STATS_TIMER(read_started);
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        result->status = DRIVER_READ_ERROR;
+        return;
+    }
+    STATS_PHASE(STATS_READ, read_started);
+    if (file.length > LEXER_MAX_SOURCE_LENGTH) {
+        result->status = DRIVER_TOO_LARGE;
+        source_release(&file);
+        return;
+    }
+    // Un acierto en la caché evita el lexer y el parser por completo.
+    uint64_t hash = 0;
+    if (options->cache_dir) {
+        hash = source_hash(file.data, file.length);
+        AstCacheEntry cached;
+        // La caché guarda el árbol compacto sin anotar; para resolver hay que parsear.
+        if (!options->resolve && ast_cache_load(options->cache_dir, hash, file.length, &cached)) {
+            // Nodo 0: AST_PROGRAM; nodo 1: su AST_INSTRUCTION_LIST. Un árbol
+            // bien formado pero con otra raíz se trata como un fallo de caché.
+            const FlatAST *flat = &cached.ast;
+            if (flat->count > 1 && flat->kinds[0] == AST_PROGRAM && flat->kinds[1] == AST_INSTRUCTION_LIST) {
+                result->instruction_count = flat_ast_child_count(flat, 1);
+                STATS_COUNT(cache_hits);
+                ast_cache_release(&cached);
+                source_release(&file);
+                return;
+            }
+            ast_cache_release(&cached);
+        }
+    }
+
+    Parser parser;
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    if (options->batch) {
+        STATS_TIMER(lex_started);
+        Lexer lexer;
+        lexer_init(&lexer, file.data, file.length);
+        if (!lexer_tokenize_parallel(&lexer, &tokens, options->parse_threads, options->split_size)) {
+            result->status = DRIVER_OUT_OF_MEMORY;
+            token_buffer_free(&tokens);
+            source_release(&file);
+            return;
+        }
+        STATS_PHASE(STATS_LEX, lex_started);
+        STATS_TOKENS(&tokens);
+        parser_init_tokens(&parser, file.data, file.length, &tokens);
+    } else if (!options->pipeline || !parser_init_pipelined(&parser, file.data, file.length)) {
+        parser_init(&parser, file.data, file.length);
+    }
+    parser_set_arena(&parser, !options->heap_ast);
+    parser_set_threads(&parser, options->parse_threads, options->split_size);
+    parser_set_max_errors(&parser, options->max_errors);
+    ASTNode *program = NULL;
+    FlatAST flat;
+    flat_ast_init(&flat);
+    bool parsed;
+    // Sin --batch el lexer corre dentro del parser y su tiempo cuenta como parseo.
+    STATS_TIMER(parse_started);
+    if (options->stream) {
+        parsed = parser_parse_streaming(&parser, count_instruction, &result->instruction_count);
+    } else if (options->flat_ast) {
+        parsed = parser_parse_flat(&parser, &flat);
+    } else {
+        program = parser_parse(&parser);
+        parsed = program != NULL;
+    }
+    STATS_PHASE(STATS_PARSE, parse_started);
+
+    if (parser_has_error(&parser) || !parsed) {
+        result->status = DRIVER_PARSE_ERROR;
+        collect_errors(&parser, result);
+    } else {
+        if (options->cache_dir && !options->stream) {
+            // Solo se guardan árboles completos y sin errores; --stream no los construye.
+            store_cached(options, hash, &file, program, &flat);
+        }
+        if (options->resolve && program) {
+            STATS_TIMER(resolve_started);
+            size_t declarations = resolve_names(&parser, program, options, result);
+            STATS_PHASE(STATS_RESOLVE, resolve_started);
+            if (options->infer_types) {
+                STATS_TIMER(types_started);
+                infer_types(&parser, program, declarations, result);
+                STATS_PHASE(STATS_TYPES, types_started);
+            }
+            if (options->optimize) {
+                STATS_TIMER(optimize_started);
+                optimize(&parser, program, result);
+                STATS_PHASE(STATS_OPTIMIZE, optimize_started);
+            }
+        }
+    }
+    STATS_TIMER(teardown_started);
+    ast_free(program);
+    flat_ast_free(&flat);
+    parser_free(&parser);
+    token_buffer_free(&tokens);
+    source_release(&file);
+    STATS_PHASE(STATS_TEARDOWN, teardown_started);
+}
+
+// Cada hilo es dueño de un rango contiguo de índices de archivo. El dueño
+// consume por delante, en orden; un hilo sin trabajo roba la mitad trasera del
+// rango de otro. Como no se crean tareas nuevas, un hilo termina en cuanto una
+// pasada completa no encuentra nada que robar.
+typedef struct {
+    pthread_mutex_t lock;
+    size_t head;
+    size_t tail;
+} WorkQueue;
+
+typedef struct {
+    const DriverFileList *files;
+    const DriverOptions *options;
+    DriverResult *results;
+    WorkQueue *queues;
+    size_t worker_count;
+} WorkPool;
+
+typedef struct {
+    WorkPool *pool;
+    size_t id;
+} Worker;
+
+static bool queue_pop(WorkQueue *queue, size_t *index) {
+    pthread_mutex_lock(&queue->lock);
+    bool found = queue->head < queue->tail;
+    if (found) {
+        *index = queue->head++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return found;
+}
+
+static bool queue_steal(WorkPool *pool, size_t thief) {
+    WorkQueue *own = &pool->queues[thief];
+    for (size_t offset = 1; offset < pool->worker_count; ++offset) {
+        WorkQueue *victim = &pool->queues[(thief + offset) % pool->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        size_t available = victim->tail - victim->head;
+        size_t taken = available - available / 2;
+        size_t end = victim->tail;
+        victim->tail -= taken;
+        pthread_mutex_unlock(&victim->lock);
+        if (taken) {
+            pthread_mutex_lock(&own->lock);
+            own->head = end - taken;
+            own->tail = end;
+            pthread_mutex_unlock(&own->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    WorkPool *pool = worker->pool;
+    WorkQueue *own = &pool->queues[worker->id];
+    size_t index;
+    do {
+        while (queue_pop(own, &index)) {
+            driver_compile_file(pool->files->paths[index], pool->options, &pool->results[index]);
+        }
+    } while (queue_steal(pool, worker->id));
+    return NULL;
+}
+
+static size_t driver_job_count(const DriverOptions *options) {
+    if (options->jobs == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        return online > 0 ? (size_t)online : 1;
+    }
+    return options->jobs;
+}
+
+// Ejecuta el pool con worker_count hilos; el hilo llamante hace de trabajador 0.
+static bool run_pool(WorkPool *pool) {
+    size_t workers = pool->worker_count;
+    size_t count = pool->files->count;
+    pool->queues = (WorkQueue *)malloc(workers * sizeof(WorkQueue));
+    Worker *state = (Worker *)malloc(workers * sizeof(Worker));
+    pthread_t *threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    if (!pool->queues || !state || !threads) {
+        free(pool->queues);
+        free(state);
+        free(threads);
+        return false;
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+        pool->queues[i].head = count * i / workers;
+        pool->queues[i].tail = count * (i + 1) / workers;
+        state[i].pool = pool;
+        state[i].id = i;
+    }
+    size_t started = 1;
+    for (; started < workers; ++started) {
+        if (pthread_create(&threads[started], NULL, worker_main, &state[started]) != 0) {
+            break;
+        }
+    }
+    // Si no se pudieron crear todos los hilos, sus rangos quedan para el robo.
+    worker_main(&state[0]);
+    for (size_t i = 1; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+    free(pool->queues);
+    free(state);
+    free(threads);
+    return true;
+}
+
+// kind es "de parseo" o "de nombres".
+static void report_error(const char *kind, const char *path, SourceLocation location, const char *message,
+                         bool single) {
+    if (single) {
+        fprintf(stderr, "Error %s en línea %zu, columna %zu: %s\n", kind, location.line, location.column, message);
+    } else {
+        fprintf(stderr, "Error %s en %s, línea %zu, columna %zu: %s\n",
+                kind, path, location.line, location.column, message);
+    }
+}
+
+static void report_result(const char *path, const DriverResult *result, const DriverOptions *options, bool single) {
+    switch (result->status) {
+        case DRIVER_OK:
+            if (!single) {
+                return;
+            }
+            if (options->stream) {
+                printf("Parseo completado correctamente: %zu instrucciones.\n", result->instruction_count);
+            } else {
+                printf("Parseo completado correctamente.\n");
+            }
+            return;
+        case DRIVER_READ_ERROR:
+            fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+            return;
+        case DRIVER_TOO_LARGE:
+            fprintf(stderr, "El archivo supera el tamaño máximo admitido (4 GiB): %s\n", path);
+            return;
+        case DRIVER_OUT_OF_MEMORY:
+            fprintf(stderr, "Memoria insuficiente para los tokens de: %s\n", path);
+            return;
+        case DRIVER_PARSE_ERROR:
+        case DRIVER_NAME_ERROR: {
+            const char *kind = result->status == DRIVER_PARSE_ERROR ? "de parseo" : "de nombres";
+            report_error(kind, path, result->location, result->message, single);
+            for (size_t i = 0; i < result->more_error_count; ++i) {
+                report_error(kind, path, result->more_errors[i].location, result->more_errors[i].message, single);
+            }
+            return;
+        }
+    }
+}
+
+static double percent(size_t part, size_t total) {
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static void report_types(const DriverFileList *files, const DriverResult *results) {
+    TypeSummary total = {0, 0, 0, 0, 0};
+    for (size_t i = 0; i < files->count; ++i) {
+        total.expressions += results[i].types.expressions;
+        total.typed_expressions += results[i].types.typed_expressions;
+        total.operators += results[i].types.operators;
+        total.typed_operators += results[i].types.typed_operators;
+        total.specializations += results[i].types.specializations;
+    }
+    printf("Tipos: %zu de %zu expresiones con tipo concreto (%.1f%%), %zu de %zu operadores (%.1f%%); "
+           "%zu especializaciones de func.\n",
+           total.typed_expressions, total.expressions, percent(total.typed_expressions, total.expressions),
+           total.typed_operators, total.operators, percent(total.typed_operators, total.operators),
+           total.specializations);
+}
+
+static void report_optimization(const char *path, const OptimizerSummary *summary, bool single) {
+    if (single) {
+        printf("Optimización: ");
+    } else {
+        printf("Optimización de %s: ", path);
+    }
+    printf("%zu de %zu nodos eliminados (%zu expresiones plegadas, %zu llamadas evaluadas, %zu simplificadas, "
+           "%zu instrucciones muertas).\n", summary->removed, summary->nodes, summary->folded, summary->evaluated,
+           summary->simplified, summary->pruned);
+}
+
+size_t driver_run(const DriverFileList *files, const DriverOptions *options) {
+    if (files->count == 0) {
+        return 0;
+    }
+    DriverResult *results = (DriverResult *)malloc(files->count * sizeof(DriverResult));
+    if (!results) {
+        fprintf(stderr, "Memoria insuficiente para %zu archivos.\n", files->count);
+        return files->count;
+    }
+    // Con menos archivos que hilos y --split-size, los sobrantes parsean cada
+    // archivo por regiones.
+    size_t jobs = driver_job_count(options);
+    DriverOptions file_options = *options;
+    file_options.parse_threads = options->split_size && jobs > files->count ? jobs / files->count : 1;
+    WorkPool pool = {files, &file_options, results, NULL, jobs < files->count ? jobs : files->count};
+    if (!run_pool(&pool)) {
+        fprintf(stderr, "Memoria insuficiente para %zu archivos.\n", files->count);
+        free(results);
+        return files->count;
+    }
+
+    size_t failed = driver_report(files, results, options);
+    for (size_t i = 0; i < files->count; ++i) {
+        driver_result_free(&results[i]);
+    }
+    free(results);
+    return failed;
+}
+
+size_t driver_report(const DriverFileList *files, const DriverResult *results, const DriverOptions *options) {
+    bool single = files->count == 1;
+    size_t failed = 0;
+    size_t nodes = 0;
+    size_t removed = 0;
+    for (size_t i = 0; i < files->count; ++i) {
+        report_result(files->paths[i], &results[i], options, single);
+        failed += results[i].status != DRIVER_OK;
+        if (options->optimize && results[i].optimization.nodes) {
+            report_optimization(files->paths[i], &results[i].optimization, single);
+            nodes += results[i].optimization.nodes;
+            removed += results[i].optimization.removed;
+        }
+    }
+    if (options->infer_types) {
+        report_types(files, results);
+    }
+    if (options->optimize && !single) {
+        printf("Optimización: %zu de %zu nodos eliminados en total (%.1f%%).\n", removed, nodes,
+               percent(removed, nodes));
+    }
+    if (!single) {
+        printf("Parseo completado: %zu archivos, %zu con errores.\n", files->count, failed);
+    }
+    return failed;
+}
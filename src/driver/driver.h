@@ -0,0 +1,98 @@
+#ifndef PYCLITE_DRIVER_H
+#define PYCLITE_DRIVER_H
+
+#include "lexer/lexer.h"
+#include "optimizer/optimizer.h"
+#include "types/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    bool heap_ast;
+    bool flat_ast;
+    bool batch;
+    bool stream;
+    bool pipeline;
+    // Hilos de trabajo; 0 usa todos los núcleos disponibles.
+    size_t jobs;
+    // Hilos con los que se analiza (léxica y sintácticamente) cada archivo por
+    // separado. driver_run lo fija repartiendo entre los archivos los hilos que
+    // sobren.
+    size_t parse_threads;
+    // Tamaño mínimo en bytes de cada región de un archivo que se parsea en
+    // paralelo (parser_set_threads) y, con batch, de cada trozo que se tokeniza
+    // en paralelo (lexer_tokenize_parallel). 0, el valor por defecto, no divide
+    // los archivos: los hilos sobrantes no se usan.
+    size_t split_size;
+    // Directorio de la caché de ASTs (ast_cache.h), o NULL para no usarla.
+    const char *cache_dir;
+    // Errores de sintaxis que se reúnen por archivo (parser_set_max_errors).
+    size_t max_errors;
+    // Tras parsear, resuelve los nombres (resolver.h) e informa de sus errores.
+    // Necesita el árbol completo: no se combina con stream ni flat_ast y no lee
+    // la caché.
+    bool resolve;
+    // Tras resolver, infiere los tipos (types.h) e informa de cuántas
+    // expresiones quedan con un tipo concreto. Implica resolve.
+    bool infer_types;
+    // Tras inferir los tipos, pliega constantes y simplifica el árbol
+    // (optimizer.h) e informa de los nodos eliminados en cada archivo. Implica
+    // infer_types.
+    bool optimize;
+} DriverOptions;
+
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t capacity;
+} DriverFileList;
+
+typedef enum {
+    DRIVER_OK,
+    DRIVER_READ_ERROR,
+    DRIVER_TOO_LARGE,
+    DRIVER_OUT_OF_MEMORY,
+    DRIVER_PARSE_ERROR,
+    DRIVER_NAME_ERROR
+} DriverStatus;
+
+typedef struct {
+    SourceLocation location;
+    const char *message;
+} DriverDiagnostic;
+
+typedef struct {
+    DriverStatus status;
+    size_t instruction_count;
+    SourceLocation location;
+    char message[256];
+    // Errores posteriores al primero (que es location y message), o NULL.
+    DriverDiagnostic *more_errors;
+    size_t more_error_count;
+    // Con infer_types.
+    TypeSummary types;
+    // Con optimize; nodes es 0 si no se optimizó.
+    OptimizerSummary optimization;
+} DriverResult;
+
+void driver_file_list_init(DriverFileList *list);
+void driver_file_list_free(DriverFileList *list);
+// Añade un archivo tal cual o, si es un directorio, todos los .pycl que
+// contiene recursivamente, en orden alfabético para que la salida sea estable.
+bool driver_collect(DriverFileList *list, const char *path);
+
+// Libera los diagnósticos adicionales de un resultado.
+void driver_result_free(DriverResult *result);
+
+// Lexea y parsea un único archivo. No toca estado global mutable, así que
+// puede llamarse a la vez desde varios hilos.
+void driver_compile_file(const char *path, const DriverOptions *options, DriverResult *result);
+// Compila todos los archivos en options->jobs hilos y escribe los
+// diagnósticos en el orden de la lista. Devuelve el número de archivos con error.
+size_t driver_run(const DriverFileList *files, const DriverOptions *options);
+// Escribe los diagnósticos de results (uno por archivo, en el orden de la
+// lista) como lo hace driver_run. Devuelve el número de archivos con error.
+size_t driver_report(const DriverFileList *files, const DriverResult *results, const DriverOptions *options);
+
+#endif // PYCLITE_DRIVER_H
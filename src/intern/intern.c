@@ -0,0 +1,145 @@
+#include "intern.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INTERN_INITIAL_SLOTS 256
+
+// De 8 en 8 bytes: los identificadores suelen medir más de una palabra y un
+// hash byte a byte sería la mayor parte del coste de internar.
+static uint32_t intern_hash(const char *name, size_t length) {
+    uint64_t hash = (uint64_t)length * 0x9E3779B97F4A7C15ull;
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, name, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+        name += 8;
+        length -= 8;
+    }
+    if (length) {
+        uint64_t word = 0;
+        memcpy(&word, name, length);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    return (uint32_t)(hash >> 32);
+}
+
+void intern_init(InternTable *table) {
+    table->slots = NULL;
+    table->slot_capacity = 0;
+    table->entries = NULL;
+    table->count = 0;
+    table->entry_capacity = 0;
+    table->names = NULL;
+    table->names_length = 0;
+    table->names_capacity = 0;
+}
+
+void intern_free(InternTable *table) {
+    free(table->slots);
+    free(table->entries);
+    free(table->names);
+    intern_init(table);
+}
+
+// Duplica los huecos y recoloca los símbolos con el hash guardado en su entrada.
+static bool intern_grow_slots(InternTable *table) {
+    size_t capacity = table->slot_capacity ? table->slot_capacity * 2 : INTERN_INITIAL_SLOTS;
+    InternSlot *slots = (InternSlot *)calloc(capacity, sizeof(InternSlot));
+    if (!slots) {
+        return false;
+    }
+    size_t mask = capacity - 1;
+    for (size_t symbol = 1; symbol <= table->count; ++symbol) {
+        uint32_t hash = table->entries[symbol - 1].hash;
+        size_t slot = hash & mask;
+        while (slots[slot].symbol) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot].hash = hash;
+        slots[slot].symbol = (uint32_t)symbol;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->slot_capacity = capacity;
+    return true;
+}
+
+static bool intern_reserve(InternTable *table, size_t length) {
+    // Factor de carga máximo de 1/2.
+    if ((table->count + 1) * 2 > table->slot_capacity && !intern_grow_slots(table)) {
+        return false;
+    }
+    if (table->count == table->entry_capacity) {
+        size_t capacity = table->entry_capacity ? table->entry_capacity * 2 : INTERN_INITIAL_SLOTS / 2;
+        InternEntry *entries = (InternEntry *)realloc(table->entries, capacity * sizeof(InternEntry));
+        if (!entries) {
+            return false;
+        }
+        table->entries = entries;
+        table->entry_capacity = capacity;
+    }
+    if (table->names_length + length > table->names_capacity) {
+        size_t capacity = table->names_capacity ? table->names_capacity * 2 : 4096;
+        while (capacity < table->names_length + length) {
+            capacity *= 2;
+        }
+        char *names = (char *)realloc(table->names, capacity);
+        if (!names) {
+            return false;
+        }
+        table->names = names;
+        table->names_capacity = capacity;
+    }
+    return true;
+}
+
+uint32_t intern_symbol(InternTable *table, const char *name, size_t length) {
+    uint32_t hash = intern_hash(name, length);
+    if (table->slot_capacity) {
+        size_t mask = table->slot_capacity - 1;
+        for (size_t slot = hash & mask; table->slots[slot].symbol; slot = (slot + 1) & mask) {
+            if (table->slots[slot].hash != hash) {
+                continue;
+            }
+            const InternEntry *entry = &table->entries[table->slots[slot].symbol - 1];
+            if (entry->length == length && memcmp(table->names + entry->offset, name, length) == 0) {
+                return table->slots[slot].symbol;
+            }
+        }
+    }
+    if (table->count >= UINT32_MAX || table->names_length + length > UINT32_MAX ||
+        !intern_reserve(table, length)) {
+        return 0;
+    }
+    uint32_t symbol = (uint32_t)++table->count;
+    InternEntry *entry = &table->entries[symbol - 1];
+    entry->offset = (uint32_t)table->names_length;
+    entry->length = (uint32_t)length;
+    entry->hash = hash;
+    memcpy(table->names + table->names_length, name, length);
+    table->names_length += length;
+    // intern_reserve puede haber redimensionado los huecos: se busca de nuevo.
+    size_t mask = table->slot_capacity - 1;
+    size_t slot = hash & mask;
+    while (table->slots[slot].symbol) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot].hash = hash;
+    table->slots[slot].symbol = symbol;
+    return symbol;
+}
+
+size_t intern_count(const InternTable *table) {
+    return table->count;
+}
+
+const char *intern_name(const InternTable *table, uint32_t symbol, size_t *length) {
+    const InternEntry *entry = &table->entries[symbol - 1];
+    *length = entry->length;
+    return table->names + entry->offset;
+}
@@ -0,0 +1,47 @@
+#ifndef PYCLITE_INTERN_H
+#define PYCLITE_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tabla de internado de identificadores: a cada nombre distinto le asigna un
+// símbolo denso de 32 bits (1, 2, 3... en orden de primera aparición; 0 es
+// "sin símbolo"), de modo que comparar nombres es comparar enteros y las
+// tablas de símbolos pueden ser arreglos indexados por símbolo. Los nombres se
+// copian, así que la tabla no depende de la vida del texto de origen.
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+    uint32_t hash;
+} InternEntry;
+
+// El hash va también en el hueco para descartar colisiones sin tocar la
+// entrada ni el nombre.
+typedef struct {
+    uint32_t hash;
+    uint32_t symbol;
+} InternSlot;
+
+typedef struct {
+    // Direccionamiento abierto; symbol es 0 en los huecos libres.
+    InternSlot *slots;
+    size_t slot_capacity;
+    // entries[symbol - 1] describe el nombre dentro de names.
+    InternEntry *entries;
+    size_t count;
+    size_t entry_capacity;
+    char *names;
+    size_t names_length;
+    size_t names_capacity;
+} InternTable;
+
+void intern_init(InternTable *table);
+void intern_free(InternTable *table);
+// Devuelve el símbolo del nombre, añadiéndolo si es nuevo; 0 si no hay memoria.
+uint32_t intern_symbol(InternTable *table, const char *name, size_t length);
+// Los símbolos válidos van de 1 a intern_count.
+size_t intern_count(const InternTable *table);
+// Nombre del símbolo (sin terminador) y su longitud en *length.
+const char *intern_name(const InternTable *table, uint32_t symbol, size_t *length);
+
+#endif // PYCLITE_INTERN_H
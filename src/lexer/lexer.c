@@ -7,27 +7,38 @@
  
  typedef struct {
      const char *keyword;
+     size_t length;
      TokenType type;
  } KeywordEntry;
- 
- static const KeywordEntry KEYWORDS[] = {
-     {"array", TOKEN_KW_ARRAY},
-     {"bool", TOKEN_KW_BOOL},
-     {"char", TOKEN_KW_CHAR},
-     {"cread", TOKEN_KW_CREAD},
-     {"csay", TOKEN_KW_CSAY},
-     {"false", TOKEN_FALSE},
-     {"float", TOKEN_KW_FLOAT},
-     {"for", TOKEN_KW_FOR},
-     {"func", TOKEN_KW_FUNC},
-     {"if", TOKEN_KW_IF},
-     {"in", TOKEN_KW_IN},
-     {"int", TOKEN_KW_INT},
-     {"return", TOKEN_KW_RETURN},
-     {"true", TOKEN_TRUE},
-     {"while", TOKEN_KW_WHILE},
+
+ // Hash perfecto sobre (longitud, primer carácter, último carácter): cada
+ // palabra reservada ocupa una casilla distinta, por lo que basta una única
+ // comparación. Una colisión al añadir palabras la avisa -Woverride-init.
+ #define KEYWORD_SLOT(first, last, length) \
+     (((size_t)(length) + 2u * (unsigned char)(first) + 6u * (unsigned char)(last)) & 31u)
+ #define KEYWORD(first, last, text, token_type) \
+     [KEYWORD_SLOT(first, last, sizeof(text) - 1)] = {text, sizeof(text) - 1, token_type}
+
+ static const KeywordEntry KEYWORDS[32] = {
+     KEYWORD('a', 'y', "array", TOKEN_KW_ARRAY),
+     KEYWORD('b', 'l', "bool", TOKEN_KW_BOOL),
+     KEYWORD('c', 'r', "char", TOKEN_KW_CHAR),
+     KEYWORD('c', 'd', "cread", TOKEN_KW_CREAD),
+     KEYWORD('c', 'y', "csay", TOKEN_KW_CSAY),
+     KEYWORD('f', 'e', "false", TOKEN_FALSE),
+     KEYWORD('f', 't', "float", TOKEN_KW_FLOAT),
+     KEYWORD('f', 'r', "for", TOKEN_KW_FOR),
+     KEYWORD('f', 'c', "func", TOKEN_KW_FUNC),
+     KEYWORD('i', 'f', "if", TOKEN_KW_IF),
+     KEYWORD('i', 'n', "in", TOKEN_KW_IN),
+     KEYWORD('i', 't', "int", TOKEN_KW_INT),
+     KEYWORD('r', 'n', "return", TOKEN_KW_RETURN),
+     KEYWORD('t', 'e', "true", TOKEN_TRUE),
+     KEYWORD('w', 'e', "while", TOKEN_KW_WHILE),
  };
- 
+
+ #undef KEYWORD
+
  static char lexer_peek(const Lexer *lexer) {
      if (lexer->position >= lexer->length) {
          return '\0';
@@ -46,14 +57,7 @@
      if (lexer->position >= lexer->length) {
          return '\0';
      }
-     char c = lexer->source[lexer->position++];
-     if (c == '\n') {
-         lexer->line++;
-         lexer->column = 1;
-     } else {
-         lexer->column++;
-     }
-     return c;
+     return lexer->source[lexer->position++];
  }
  
  static bool is_identifier_start(char c) {
@@ -64,66 +68,44 @@
      return isalnum((unsigned char)c) || c == '_';
  }
  
+ static bool is_blank(char c) {
+     return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+ }
+
  static void skip_whitespace(Lexer *lexer) {
-     while (true) {
-         char c = lexer_peek(lexer);
-         if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
-             lexer_advance(lexer);
-             continue;
+     // Los huecos cortos entre tokens no compensan la llamada al núcleo vectorial.
+     size_t limit = lexer->position + 8 < lexer->length ? lexer->position + 8 : lexer->length;
+     while (lexer->position < limit) {
+         if (!is_blank(lexer->source[lexer->position])) {
+             return;
          }
-         break;
+         lexer->position++;
      }
+     lexer->position = lexer->scan->skip_blanks(lexer->source, lexer->position, lexer->length);
+ }
+ 
+ static void skip_block_comment(Lexer *lexer, char first, char second) {
+     size_t end = lexer->scan->find_pair(lexer->source, lexer->position + 2, lexer->length, first, second);
+     lexer->position = end < lexer->length ? end + 2 : lexer->length;
  }
  
  static void skip_comment(Lexer *lexer) {
      char c = lexer_peek(lexer);
      char next = lexer_peek_next(lexer);
  
-     if (c == '/' && next == '/') {
-         while (c != '\n' && c != '\0') {
-             c = lexer_advance(lexer);
-         }
-         return;
-     }
- 
-     if (c == '$') {
-         while (c != '\n' && c != '\0') {
-             c = lexer_advance(lexer);
-         }
+     if ((c == '/' && next == '/') || c == '$') {
+         size_t newline = scan_find_byte(lexer->source, lexer->position, lexer->length, '\n');
+         lexer->position = newline < lexer->length ? newline + 1 : lexer->length;
          return;
      }
  
      if (c == '/' && next == '*') {
-         lexer_advance(lexer);
-         lexer_advance(lexer);
-         while (true) {
-             if (lexer_peek(lexer) == '\0') {
-                 break;
-             }
-             if (lexer_peek(lexer) == '*' && lexer_peek_next(lexer) == '/') {
-                 lexer_advance(lexer);
-                 lexer_advance(lexer);
-                 break;
-             }
-             lexer_advance(lexer);
-         }
+         skip_block_comment(lexer, '*', '/');
          return;
      }
  
      if (c == '%' && next == '%') {
-         lexer_advance(lexer);
-         lexer_advance(lexer);
-         while (true) {
-             if (lexer_peek(lexer) == '\0') {
-                 break;
-             }
-             if (lexer_peek(lexer) == '%' && lexer_peek_next(lexer) == '%') {
-                 lexer_advance(lexer);
-                 lexer_advance(lexer);
-                 break;
-             }
-             lexer_advance(lexer);
-         }
+         skip_block_comment(lexer, '%', '%');
      }
  }
  
@@ -146,24 +128,106 @@
      }
  }
  
+ static LexerEngine default_engine = LEXER_ENGINE_CLASSIC;
+
+ void lexer_set_default_engine(LexerEngine engine) {
+     default_engine = engine;
+ }
+
  void lexer_init(Lexer *lexer, const char *source, size_t length) {
      lexer->source = source;
      lexer->length = length;
      lexer->position = 0;
-     lexer->line = 1;
-     lexer->column = 1;
+     lexer->scan = scan_kernels();
+     lexer->engine = default_engine;
+     lexer->line_starts = NULL;
+     lexer->line_count = 0;
+ }
+
+ void lexer_init_range(Lexer *lexer, const char *source, size_t begin, size_t end) {
+     lexer_init(lexer, source, end);
+     lexer->position = begin;
+ }
+
+ void lexer_free(Lexer *lexer) {
+     free(lexer->line_starts);
+     lexer->line_starts = NULL;
+     lexer->line_count = 0;
+ }
+
+ const char *lexer_lexeme(const Lexer *lexer, Token token) {
+     return lexer->source + token.offset;
+ }
+
+ static bool build_line_table(Lexer *lexer) {
+     size_t capacity = 64;
+     uint32_t *starts = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+     if (!starts) {
+         return false;
+     }
+     size_t count = 0;
+     starts[count++] = 0;
+     const char *cursor = lexer->source;
+     const char *end = lexer->source + lexer->length;
+     while (cursor < end) {
+         const char *newline = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+         if (!newline) {
+             break;
+         }
+         if (count == capacity) {
+             capacity *= 2;
+             uint32_t *grown = (uint32_t *)realloc(starts, capacity * sizeof(uint32_t));
+             if (!grown) {
+                 free(starts);
+                 return false;
+             }
+             starts = grown;
+         }
+         starts[count++] = (uint32_t)(newline + 1 - lexer->source);
+         cursor = newline + 1;
+     }
+     lexer->line_starts = starts;
+     lexer->line_count = count;
+     return true;
+ }
+
+ SourceLocation lexer_location(Lexer *lexer, size_t offset) {
+     SourceLocation location = {1, offset + 1};
+     if (!lexer->line_starts && !build_line_table(lexer)) {
+         return location;
+     }
+     size_t low = 0;
+     size_t high = lexer->line_count;
+     while (high - low > 1) {
+         size_t mid = low + (high - low) / 2;
+         if (lexer->line_starts[mid] <= offset) {
+             low = mid;
+         } else {
+             high = mid;
+         }
+     }
+     location.line = low + 1;
+     location.column = offset - lexer->line_starts[low] + 1;
+     return location;
  }
  
- static Token make_token(Lexer *lexer, TokenType type, size_t start, size_t length) {
+ static Token make_token(TokenType type, size_t start, size_t length) {
      Token token;
      token.type = type;
-     token.lexeme = lexer->source + start;
-     token.length = length;
-     token.line = lexer->line;
-     token.column = lexer->column - (length ? length - 1 : 0);
+     token.offset = (uint32_t)start;
+     token.length = (uint32_t)length;
+     token.symbol = 0;
      return token;
  }
  
+ static TokenType keyword_lookup(const char *text, size_t length) {
+     const KeywordEntry *entry = &KEYWORDS[KEYWORD_SLOT(text[0], text[length - 1], length)];
+     if (entry->length == length && memcmp(text, entry->keyword, length) == 0) {
+         return entry->type;
+     }
+     return TOKEN_IDENTIFIER;
+ }
+
  static Token token_from_identifier(Lexer *lexer, size_t start) {
      size_t length = 0;
      while (is_identifier_part(lexer_peek(lexer))) {
@@ -171,14 +235,7 @@
      }
      size_t end = lexer->position;
      length = end - start;
- 
-     for (size_t i = 0; i < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); ++i) {
-         const KeywordEntry *entry = &KEYWORDS[i];
-         if (length == strlen(entry->keyword) && strncmp(lexer->source + start, entry->keyword, length) == 0) {
-             return make_token(lexer, entry->type, start, length);
-         }
-     }
-     return make_token(lexer, TOKEN_IDENTIFIER, start, length);
+     return make_token(keyword_lookup(lexer->source + start, length), start, length);
  }
  
  static Token token_from_number(Lexer *lexer, size_t start) {
@@ -193,7 +250,7 @@
          lexer_advance(lexer);
      }
      size_t length = lexer->position - start;
-     return make_token(lexer, TOKEN_NUMBER, start, length);
+     return make_token(TOKEN_NUMBER, start, length);
  }
  
  static Token token_from_string(Lexer *lexer, size_t start, char quote) {
@@ -212,15 +269,15 @@
          lexer_advance(lexer);
      }
      size_t length = lexer->position - start;
-     return make_token(lexer, quote == '"' ? TOKEN_STRING : TOKEN_CHAR, start, length);
+     return make_token(quote == '"' ? TOKEN_STRING : TOKEN_CHAR, start, length);
  }
  
- Token lexer_next_token(Lexer *lexer) {
+ static Token next_token_classic(Lexer *lexer) {
      skip_ignorable(lexer);
      size_t start = lexer->position;
  
      if (start >= lexer->length) {
-         Token token = {TOKEN_EOF, "", 0, lexer->line, lexer->column};
+         Token token = {TOKEN_EOF, (uint32_t)start, 0, 0};
          return token;
      }
  
@@ -242,80 +299,238 @@
          case '+':
              if (lexer_peek(lexer) == '+') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_PLUSPLUS, start, 2);
+                 return make_token(TOKEN_PLUSPLUS, start, 2);
              }
-             return make_token(lexer, TOKEN_PLUS, start, 1);
+             return make_token(TOKEN_PLUS, start, 1);
          case '-':
              if (lexer_peek(lexer) == '-') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_MINUSMINUS, start, 2);
+                 return make_token(TOKEN_MINUSMINUS, start, 2);
              }
-             return make_token(lexer, TOKEN_MINUS, start, 1);
+             return make_token(TOKEN_MINUS, start, 1);
          case '*':
-             return make_token(lexer, TOKEN_STAR, start, 1);
+             return make_token(TOKEN_STAR, start, 1);
          case '/':
-             return make_token(lexer, TOKEN_SLASH, start, 1);
+             return make_token(TOKEN_SLASH, start, 1);
          case '%':
-             return make_token(lexer, TOKEN_PERCENT, start, 1);
+             return make_token(TOKEN_PERCENT, start, 1);
          case '=':
              if (lexer_peek(lexer) == '=') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_EQEQ, start, 2);
+                 return make_token(TOKEN_EQEQ, start, 2);
              }
-             return make_token(lexer, TOKEN_EQ, start, 1);
+             return make_token(TOKEN_EQ, start, 1);
          case '!':
              if (lexer_peek(lexer) == '=') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_BANGEQ, start, 2);
+                 return make_token(TOKEN_BANGEQ, start, 2);
              }
-             return make_token(lexer, TOKEN_BANG, start, 1);
+             return make_token(TOKEN_BANG, start, 1);
          case '<':
              if (lexer_peek(lexer) == '=') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_LTE, start, 2);
+                 return make_token(TOKEN_LTE, start, 2);
              }
-             return make_token(lexer, TOKEN_LT, start, 1);
+             return make_token(TOKEN_LT, start, 1);
          case '>':
              if (lexer_peek(lexer) == '=') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_GTE, start, 2);
+                 return make_token(TOKEN_GTE, start, 2);
              }
-             return make_token(lexer, TOKEN_GT, start, 1);
+             return make_token(TOKEN_GT, start, 1);
          case '&':
              if (lexer_peek(lexer) == '&') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_ANDAND, start, 2);
+                 return make_token(TOKEN_ANDAND, start, 2);
              }
              break;
          case '|':
              if (lexer_peek(lexer) == '|') {
                  lexer_advance(lexer);
-                 return make_token(lexer, TOKEN_OROR, start, 2);
+                 return make_token(TOKEN_OROR, start, 2);
              }
              break;
          case '(':
-             return make_token(lexer, TOKEN_LPAREN, start, 1);
+             return make_token(TOKEN_LPAREN, start, 1);
          case ')':
-             return make_token(lexer, TOKEN_RPAREN, start, 1);
+             return make_token(TOKEN_RPAREN, start, 1);
          case '{':
-             return make_token(lexer, TOKEN_LBRACE, start, 1);
+             return make_token(TOKEN_LBRACE, start, 1);
          case '}':
-             return make_token(lexer, TOKEN_RBRACE, start, 1);
+             return make_token(TOKEN_RBRACE, start, 1);
          case '[':
-             return make_token(lexer, TOKEN_LBRACKET, start, 1);
+             return make_token(TOKEN_LBRACKET, start, 1);
          case ']':
-             return make_token(lexer, TOKEN_RBRACKET, start, 1);
+             return make_token(TOKEN_RBRACKET, start, 1);
          case ',':
-             return make_token(lexer, TOKEN_COMMA, start, 1);
+             return make_token(TOKEN_COMMA, start, 1);
          case ';':
-             return make_token(lexer, TOKEN_SEMICOLON, start, 1);
+             return make_token(TOKEN_SEMICOLON, start, 1);
          case '.':
-             return make_token(lexer, TOKEN_DOT, start, 1);
+             return make_token(TOKEN_DOT, start, 1);
      }
  
-     return make_token(lexer, TOKEN_UNKNOWN, start, 1);
+     return make_token(TOKEN_UNKNOWN, start, 1);
  }
  
+ // Motor dirigido por tablas: una clase por byte decide el tipo de token y los
+ // operadores se resuelven con una transición de un carácter de anticipación.
+ enum {
+     CLASS_OTHER = 0,
+     CLASS_IDENT = 1,
+     CLASS_DIGIT = 2,
+     CLASS_QUOTE = 3,
+     CLASS_PUNCT = 4
+ };
+
+ static const uint8_t CHAR_CLASS[256] = {
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 4, 3, 0, 0, 4, 4, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+     2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 4, 4, 4, 4, 0,
+     0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 0, 4, 0, 1,
+     0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+ };
+
+ typedef struct {
+     uint8_t single;
+     char second;
+     uint8_t pair;
+ } OperatorTransition;
+
+ static const OperatorTransition OPERATORS[256] = {
+     ['+'] = {TOKEN_PLUS, '+', TOKEN_PLUSPLUS},
+     ['-'] = {TOKEN_MINUS, '-', TOKEN_MINUSMINUS},
+     ['*'] = {TOKEN_STAR, 0, 0},
+     ['/'] = {TOKEN_SLASH, 0, 0},
+     ['%'] = {TOKEN_PERCENT, 0, 0},
+     ['='] = {TOKEN_EQ, '=', TOKEN_EQEQ},
+     ['!'] = {TOKEN_BANG, '=', TOKEN_BANGEQ},
+     ['<'] = {TOKEN_LT, '=', TOKEN_LTE},
+     ['>'] = {TOKEN_GT, '=', TOKEN_GTE},
+     ['&'] = {TOKEN_UNKNOWN, '&', TOKEN_ANDAND},
+     ['|'] = {TOKEN_UNKNOWN, '|', TOKEN_OROR},
+     ['('] = {TOKEN_LPAREN, 0, 0},
+     [')'] = {TOKEN_RPAREN, 0, 0},
+     ['{'] = {TOKEN_LBRACE, 0, 0},
+     ['}'] = {TOKEN_RBRACE, 0, 0},
+     ['['] = {TOKEN_LBRACKET, 0, 0},
+     [']'] = {TOKEN_RBRACKET, 0, 0},
+     [','] = {TOKEN_COMMA, 0, 0},
+     [';'] = {TOKEN_SEMICOLON, 0, 0},
+     ['.'] = {TOKEN_DOT, 0, 0},
+ };
+
+ static uint8_t char_class(const Lexer *lexer, size_t position) {
+     return position < lexer->length ? CHAR_CLASS[(unsigned char)lexer->source[position]] : CLASS_OTHER;
+ }
+
+ static Token next_token_dfa(Lexer *lexer) {
+     skip_ignorable(lexer);
+     const char *source = lexer->source;
+     size_t start = lexer->position;
+     if (start >= lexer->length) {
+         return make_token(TOKEN_EOF, start, 0);
+     }
+
+     unsigned char c = (unsigned char)source[start];
+     size_t end = start + 1;
+     switch (CHAR_CLASS[c]) {
+         case CLASS_IDENT:
+             while ((uint8_t)(char_class(lexer, end) - CLASS_IDENT) <= CLASS_DIGIT - CLASS_IDENT) {
+                 end++;
+             }
+             lexer->position = end;
+             return make_token(keyword_lookup(source + start, end - start), start, end - start);
+         case CLASS_DIGIT:
+             while (char_class(lexer, end) == CLASS_DIGIT) {
+                 end++;
+             }
+             if (end < lexer->length && source[end] == '.') {
+                 end++;
+                 while (char_class(lexer, end) == CLASS_DIGIT) {
+                     end++;
+                 }
+             }
+             lexer->position = end;
+             return make_token(TOKEN_NUMBER, start, end - start);
+         case CLASS_QUOTE:
+             lexer->position = end;
+             return token_from_string(lexer, start, (char)c);
+         case CLASS_PUNCT: {
+             const OperatorTransition *op = &OPERATORS[c];
+             if (op->second && end < lexer->length && source[end] == op->second) {
+                 lexer->position = end + 1;
+                 return make_token((TokenType)op->pair, start, 2);
+             }
+             lexer->position = end;
+             return make_token((TokenType)op->single, start, 1);
+         }
+         default:
+             lexer->position = end;
+             return make_token(TOKEN_UNKNOWN, start, 1);
+     }
+ }
+
+ Token lexer_next_token(Lexer *lexer) {
+     if (lexer->engine == LEXER_ENGINE_DFA) {
+         return next_token_dfa(lexer);
+     }
+     return next_token_classic(lexer);
+ }
+
+ void token_buffer_init(TokenBuffer *buffer) {
+     buffer->tokens = NULL;
+     buffer->count = 0;
+     buffer->capacity = 0;
+ }
+
+ void token_buffer_free(TokenBuffer *buffer) {
+     free(buffer->tokens);
+     token_buffer_init(buffer);
+ }
+
+ bool token_buffer_reserve(TokenBuffer *buffer, size_t capacity) {
+     if (capacity <= buffer->capacity) {
+         return true;
+     }
+     Token *grown = (Token *)realloc(buffer->tokens, capacity * sizeof(Token));
+     if (!grown) {
+         return false;
+     }
+     buffer->tokens = grown;
+     buffer->capacity = capacity;
+     return true;
+ }
+
+ bool lexer_tokenize_all(Lexer *lexer, TokenBuffer *buffer) {
+     // Un token cada ~4 bytes es la densidad típica; se crece al doble si no basta.
+     size_t estimate = buffer->count + (lexer->length - lexer->position) / 4 + 16;
+     if (!token_buffer_reserve(buffer, estimate)) {
+         return false;
+     }
+     while (true) {
+         if (buffer->count == buffer->capacity && !token_buffer_reserve(buffer, buffer->capacity * 2)) {
+             return false;
+         }
+         Token token = lexer_next_token(lexer);
+         buffer->tokens[buffer->count++] = token;
+         if (token.type == TOKEN_EOF) {
+             return true;
+         }
+     }
+ }
+
  const char *token_type_str(TokenType type) {
      switch (type) {
  #define TOKEN_NAME(t) case t: return #t;
@@ -3,6 +3,11 @@
 
  #include <stdbool.h>
  #include <stddef.h>
+ #include <stdint.h>
+
+ #include "scan.h"
+
+ #define LEXER_MAX_SOURCE_LENGTH ((size_t)UINT32_MAX)
  
  typedef enum {
      TOKEN_EOF = 0,
@@ -59,24 +64,60 @@
      TOKEN_UNKNOWN
  } TokenType;
  
+ // El lexema es source + offset; la línea y columna se calculan bajo demanda con
+ // lexer_location. symbol es el identificador internado (intern.h) que le
+ // asigna el parser a cada TOKEN_IDENTIFIER; el lexer lo deja a 0.
  typedef struct {
      TokenType type;
-     const char *lexeme;
-     size_t length;
+     uint32_t offset;
+     uint32_t length;
+     uint32_t symbol;
+ } Token;
+
+ typedef struct {
      size_t line;
      size_t column;
- } Token;
- 
+ } SourceLocation;
+
+ typedef struct {
+     Token *tokens;
+     size_t count;
+     size_t capacity;
+ } TokenBuffer;
+
+ typedef enum {
+     LEXER_ENGINE_CLASSIC = 0,
+     LEXER_ENGINE_DFA
+ } LexerEngine;
+
  typedef struct {
      const char *source;
      size_t length;
      size_t position;
-     size_t line;
-     size_t column;
+     const ScanKernels *scan;
+     LexerEngine engine;
+
+     uint32_t *line_starts;
+     size_t line_count;
  } Lexer;
  
+ // Motor usado por los lexers que se inicialicen a partir de ahora; como
+ // scan_set_level, se fija una vez al arrancar.
+ void lexer_set_default_engine(LexerEngine engine);
  void lexer_init(Lexer *lexer, const char *source, size_t length);
+ // Analiza solo [begin, end) de source; los tokens conservan offsets absolutos
+ // y el EOF se emite en end.
+ void lexer_init_range(Lexer *lexer, const char *source, size_t begin, size_t end);
+ void lexer_free(Lexer *lexer);
  Token lexer_next_token(Lexer *lexer);
+ // Analiza todo el resto de la fuente en una sola pasada; el último token del
+ // búfer es siempre TOKEN_EOF. Devuelve false si no hay memoria suficiente.
+ bool lexer_tokenize_all(Lexer *lexer, TokenBuffer *buffer);
+ void token_buffer_init(TokenBuffer *buffer);
+ void token_buffer_free(TokenBuffer *buffer);
+ bool token_buffer_reserve(TokenBuffer *buffer, size_t capacity);
+ const char *lexer_lexeme(const Lexer *lexer, Token token);
+ SourceLocation lexer_location(Lexer *lexer, size_t offset);
  const char *token_type_str(TokenType type);
  
  #endif // PYCLITE_LEXER_H
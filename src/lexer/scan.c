@@ -0,0 +1,227 @@
+#include "scan.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static size_t skip_blanks_scalar(const char *source, size_t from, size_t length) {
+    while (from < length && is_blank(source[from])) {
+        from++;
+    }
+    return from;
+}
+
+static size_t find_pair_scalar(const char *source, size_t from, size_t length, char first, char second) {
+    while (from + 1 < length) {
+        const char *hit = (const char *)memchr(source + from, first, length - from - 1);
+        if (!hit) {
+            break;
+        }
+        from = (size_t)(hit - source);
+        if (source[from + 1] == second) {
+            return from;
+        }
+        from++;
+    }
+    return length;
+}
+
+static void classify_block_scalar(const char *block, ScanBlockMasks *masks) {
+    memset(masks, 0, sizeof(*masks));
+    for (unsigned i = 0; i < SCAN_BLOCK_SIZE; ++i) {
+        uint64_t bit = (uint64_t)1 << i;
+        switch (block[i]) {
+            case '"': masks->double_quote |= bit; break;
+            case '\'': masks->single_quote |= bit; break;
+            case '\\': masks->backslash |= bit; break;
+            case '/': masks->slash |= bit; break;
+            case '*': masks->star |= bit; break;
+            case '$': masks->dollar |= bit; break;
+            case '%': masks->percent |= bit; break;
+            case '\n': masks->newline |= bit; masks->blank |= bit; break;
+            case ' ':
+            case '\t':
+            case '\r': masks->blank |= bit; break;
+            case '\0': masks->nul |= bit; break;
+            default: break;
+        }
+    }
+}
+
+size_t scan_find_byte(const char *source, size_t from, size_t length, char byte) {
+    if (from >= length) {
+        return length;
+    }
+    const char *hit = (const char *)memchr(source + from, byte, length - from);
+    return hit ? (size_t)(hit - source) : length;
+}
+
+#if defined(SCAN_X86) && defined(__SSE2__)
+static size_t skip_blanks_sse2(const char *source, size_t from, size_t length) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (from + 16 <= length) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(source + from));
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, lf)));
+        unsigned mask = ~(unsigned)_mm_movemask_epi8(blank) & 0xFFFFu;
+        if (mask) {
+            return from + (size_t)__builtin_ctz(mask);
+        }
+        from += 16;
+    }
+    return skip_blanks_scalar(source, from, length);
+}
+
+static size_t find_pair_sse2(const char *source, size_t from, size_t length, char first, char second) {
+    const __m128i first_v = _mm_set1_epi8(first);
+    const __m128i second_v = _mm_set1_epi8(second);
+    while (from + 17 <= length) {
+        __m128i current = _mm_loadu_si128((const __m128i *)(source + from));
+        __m128i following = _mm_loadu_si128((const __m128i *)(source + from + 1));
+        __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(current, first_v), _mm_cmpeq_epi8(following, second_v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        if (mask) {
+            return from + (size_t)__builtin_ctz(mask);
+        }
+        from += 16;
+    }
+    return find_pair_scalar(source, from, length, first, second);
+}
+
+static uint64_t match_sse2(const __m128i lanes[4], char byte) {
+    const __m128i needle = _mm_set1_epi8(byte);
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        mask |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(lanes[i], needle)) << (16 * i);
+    }
+    return mask;
+}
+
+static void classify_block_sse2(const char *block, ScanBlockMasks *masks) {
+    __m128i lanes[4];
+    for (unsigned i = 0; i < 4; ++i) {
+        lanes[i] = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+    }
+    masks->double_quote = match_sse2(lanes, '"');
+    masks->single_quote = match_sse2(lanes, '\'');
+    masks->backslash = match_sse2(lanes, '\\');
+    masks->slash = match_sse2(lanes, '/');
+    masks->star = match_sse2(lanes, '*');
+    masks->dollar = match_sse2(lanes, '$');
+    masks->percent = match_sse2(lanes, '%');
+    masks->newline = match_sse2(lanes, '\n');
+    masks->blank = masks->newline | match_sse2(lanes, ' ') | match_sse2(lanes, '\t') | match_sse2(lanes, '\r');
+    masks->nul = match_sse2(lanes, '\0');
+}
+
+static const ScanKernels SSE2_KERNELS = {SCAN_SSE2, skip_blanks_sse2, find_pair_sse2, classify_block_sse2};
+#endif
+
+#if defined(SCAN_X86)
+__attribute__((target("avx2")))
+static size_t skip_blanks_avx2(const char *source, size_t from, size_t length) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    while (from + 32 <= length) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(source + from));
+        __m256i blank = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, lf)));
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(blank);
+        if (mask) {
+            return from + (size_t)__builtin_ctz(mask);
+        }
+        from += 32;
+    }
+    return skip_blanks_scalar(source, from, length);
+}
+
+__attribute__((target("avx2")))
+static size_t find_pair_avx2(const char *source, size_t from, size_t length, char first, char second) {
+    const __m256i first_v = _mm256_set1_epi8(first);
+    const __m256i second_v = _mm256_set1_epi8(second);
+    while (from + 33 <= length) {
+        __m256i current = _mm256_loadu_si256((const __m256i *)(source + from));
+        __m256i following = _mm256_loadu_si256((const __m256i *)(source + from + 1));
+        __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(current, first_v), _mm256_cmpeq_epi8(following, second_v));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(hits);
+        if (mask) {
+            return from + (size_t)__builtin_ctz(mask);
+        }
+        from += 32;
+    }
+    return find_pair_scalar(source, from, length, first, second);
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t match_avx2(__m256i low, __m256i high, char byte) {
+    const __m256i needle = _mm256_set1_epi8(byte);
+    uint64_t low_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle));
+    uint64_t high_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle));
+    return low_mask | high_mask << 32;
+}
+
+__attribute__((target("avx2")))
+static void classify_block_avx2(const char *block, ScanBlockMasks *masks) {
+    __m256i low = _mm256_loadu_si256((const __m256i *)block);
+    __m256i high = _mm256_loadu_si256((const __m256i *)(block + 32));
+    masks->double_quote = match_avx2(low, high, '"');
+    masks->single_quote = match_avx2(low, high, '\'');
+    masks->backslash = match_avx2(low, high, '\\');
+    masks->slash = match_avx2(low, high, '/');
+    masks->star = match_avx2(low, high, '*');
+    masks->dollar = match_avx2(low, high, '$');
+    masks->percent = match_avx2(low, high, '%');
+    masks->newline = match_avx2(low, high, '\n');
+    masks->blank = masks->newline | match_avx2(low, high, ' ') | match_avx2(low, high, '\t') | match_avx2(low, high, '\r');
+    masks->nul = match_avx2(low, high, '\0');
+}
+
+static const ScanKernels AVX2_KERNELS = {SCAN_AVX2, skip_blanks_avx2, find_pair_avx2, classify_block_avx2};
+#endif
+
+static const ScanKernels SCALAR_KERNELS = {SCAN_SCALAR, skip_blanks_scalar, find_pair_scalar, classify_block_scalar};
+
+static const ScanKernels *selected_kernels = NULL;
+
+static const ScanKernels *kernels_for(ScanLevel level) {
+#if defined(SCAN_X86)
+    __builtin_cpu_init();
+    if ((level == SCAN_AUTO || level == SCAN_AVX2) && __builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+#if defined(__SSE2__)
+    if (level != SCAN_SCALAR) {
+        return &SSE2_KERNELS;
+    }
+#endif
+#else
+    (void)level;
+#endif
+    return &SCALAR_KERNELS;
+}
+
+void scan_set_level(ScanLevel level) {
+    selected_kernels = kernels_for(level);
+}
+
+const ScanKernels *scan_kernels(void) {
+    if (!selected_kernels) {
+        selected_kernels = kernels_for(SCAN_AUTO);
+    }
+    return selected_kernels;
+}
@@ -0,0 +1,48 @@
+#ifndef PYCLITE_SCAN_H
+#define PYCLITE_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    SCAN_AUTO = 0,
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanLevel;
+
+#define SCAN_BLOCK_SIZE 64
+
+// Clasificación de SCAN_BLOCK_SIZE bytes consecutivos: el bit i de cada
+// máscara describe block[i]. Es la entrada del índice estructural.
+typedef struct {
+    uint64_t double_quote;
+    uint64_t single_quote;
+    uint64_t backslash;
+    uint64_t slash;
+    uint64_t star;
+    uint64_t dollar;
+    uint64_t percent;
+    uint64_t newline;
+    uint64_t blank;
+    uint64_t nul;
+} ScanBlockMasks;
+
+// Núcleos de búsqueda usados por el lexer para saltar espacios y comentarios.
+// Todos devuelven un índice en [from, length]; length significa "no encontrado".
+// classify_block lee exactamente SCAN_BLOCK_SIZE bytes.
+typedef struct {
+    ScanLevel level;
+    size_t (*skip_blanks)(const char *source, size_t from, size_t length);
+    size_t (*find_pair)(const char *source, size_t from, size_t length, char first, char second);
+    void (*classify_block)(const char *block, ScanBlockMasks *masks);
+} ScanKernels;
+
+size_t scan_find_byte(const char *source, size_t from, size_t length, char byte);
+
+// Debe llamarse antes de empezar a analizar; SCAN_AUTO elige el mejor núcleo
+// disponible en la CPU y un nivel no soportado cae al siguiente inferior.
+void scan_set_level(ScanLevel level);
+const ScanKernels *scan_kernels(void);
+
+#endif // PYCLITE_SCAN_H
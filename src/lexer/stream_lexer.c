@@ -0,0 +1,296 @@
+#include "stream_lexer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_CARRY_STEP 64
+
+void stream_lexer_init(StreamLexer *lexer) {
+    lexer_init(&lexer->chunk, NULL, 0);
+    lexer->chunk_offset = 0;
+    lexer->final = false;
+    lexer->retired = true;
+    lexer->mode = STREAM_MODE_NORMAL;
+    lexer->block_first = '\0';
+    lexer->block_second = '\0';
+    lexer->block_pending = false;
+    lexer->pending_opener = '\0';
+    lexer->pending_offset = 0;
+    lexer->carry = NULL;
+    lexer->carry_length = 0;
+    lexer->carry_capacity = 0;
+    lexer->carry_offset = 0;
+    lexer->carry_location = (SourceLocation){1, 1};
+    lexer->lines_before_chunk = 0;
+    lexer->line_start_before_chunk = 0;
+}
+
+void stream_lexer_free(StreamLexer *lexer) {
+    free(lexer->carry);
+    lexer->carry = NULL;
+    lexer->carry_length = 0;
+    lexer->carry_capacity = 0;
+}
+
+static size_t count_newlines(const char *data, size_t length, size_t *last_newline) {
+    size_t count = 0;
+    size_t position = 0;
+    while (position < length) {
+        const char *newline = (const char *)memchr(data + position, '\n', length - position);
+        if (!newline) {
+            break;
+        }
+        position = (size_t)(newline - data);
+        *last_newline = position;
+        count++;
+        position++;
+    }
+    return count;
+}
+
+// Se llama cuando el fragmento actual está consumido del todo, antes de
+// devolver el control al llamador, que puede reutilizar el búfer.
+static void retire_chunk(StreamLexer *lexer) {
+    if (lexer->retired) {
+        return;
+    }
+    size_t last_newline = SIZE_MAX;
+    lexer->lines_before_chunk += count_newlines(lexer->chunk.source, lexer->chunk.length, &last_newline);
+    if (last_newline != SIZE_MAX) {
+        lexer->line_start_before_chunk = lexer->chunk_offset + last_newline + 1;
+    }
+    lexer->chunk_offset += lexer->chunk.length;
+    lexer_init(&lexer->chunk, NULL, 0);
+    lexer->retired = true;
+}
+
+void stream_lexer_feed(StreamLexer *lexer, const char *data, size_t length, bool final) {
+    retire_chunk(lexer);
+    lexer_init(&lexer->chunk, data, length);
+    lexer->final = final;
+    lexer->retired = false;
+}
+
+SourceLocation stream_lexer_location(const StreamLexer *lexer, size_t offset) {
+    if (offset < lexer->chunk_offset) {
+        size_t last_newline = SIZE_MAX;
+        size_t relative = offset - lexer->carry_offset;
+        size_t lines = count_newlines(lexer->carry, relative, &last_newline);
+        if (lines == 0) {
+            return (SourceLocation){lexer->carry_location.line, lexer->carry_location.column + relative};
+        }
+        return (SourceLocation){lexer->carry_location.line + lines, relative - last_newline};
+    }
+    size_t last_newline = SIZE_MAX;
+    size_t relative = offset - lexer->chunk_offset;
+    size_t lines = count_newlines(lexer->chunk.source, relative, &last_newline);
+    if (lines == 0) {
+        return (SourceLocation){lexer->lines_before_chunk + 1, offset - lexer->line_start_before_chunk + 1};
+    }
+    return (SourceLocation){lexer->lines_before_chunk + lines + 1, relative - last_newline};
+}
+
+static bool carry_append(StreamLexer *lexer, const char *data, size_t length) {
+    if (lexer->carry_length + length > lexer->carry_capacity) {
+        size_t capacity = lexer->carry_capacity ? lexer->carry_capacity : STREAM_CARRY_STEP;
+        while (capacity < lexer->carry_length + length) {
+            capacity *= 2;
+        }
+        char *grown = (char *)realloc(lexer->carry, capacity);
+        if (!grown) {
+            return false;
+        }
+        lexer->carry = grown;
+        lexer->carry_capacity = capacity;
+    }
+    memcpy(lexer->carry + lexer->carry_length, data, length);
+    lexer->carry_length += length;
+    return true;
+}
+
+static bool chunk_exhausted(const StreamLexer *lexer) {
+    return lexer->chunk.position >= lexer->chunk.length;
+}
+
+static StreamStatus request_input(StreamLexer *lexer) {
+    lexer->chunk.position = lexer->chunk.length;
+    retire_chunk(lexer);
+    return STREAM_NEED_INPUT;
+}
+
+static StreamStatus need_input(StreamLexer *lexer, StreamToken *token) {
+    if (!lexer->final) {
+        return request_input(lexer);
+    }
+    token->type = TOKEN_EOF;
+    token->lexeme = "";
+    token->length = 0;
+    token->offset = lexer->chunk_offset + lexer->chunk.length;
+    return STREAM_END;
+}
+
+static StreamStatus emit(StreamToken *token, TokenType type, const char *lexeme, size_t length, size_t offset) {
+    token->type = type;
+    token->lexeme = lexeme;
+    token->length = length;
+    token->offset = offset;
+    return STREAM_TOKEN;
+}
+
+// Completa un token que empezó en un fragmento anterior añadiendo bytes del
+// actual al búfer de arrastre hasta que el lexer lo cierre antes del final.
+static StreamStatus complete_carry(StreamLexer *lexer, StreamToken *token) {
+    Lexer *chunk = &lexer->chunk;
+    size_t step = STREAM_CARRY_STEP;
+    while (true) {
+        size_t available = chunk->length - chunk->position;
+        size_t take = available < step ? available : step;
+        size_t previous = lexer->carry_length;
+        if (take && !carry_append(lexer, chunk->source + chunk->position, take)) {
+            return emit(token, TOKEN_UNKNOWN, lexer->carry, previous, lexer->carry_offset);
+        }
+        Lexer relex;
+        lexer_init(&relex, lexer->carry, lexer->carry_length);
+        Token relexed = lexer_next_token(&relex);
+        size_t end = relexed.offset + relexed.length;
+        bool closed = end < lexer->carry_length;
+        if (closed || (lexer->final && take == available)) {
+            size_t consumed = end > previous ? end - previous : 0;
+            chunk->position += consumed;
+            lexer->carry_length = 0;
+            return emit(token, relexed.type, lexer->carry + relexed.offset, relexed.length, lexer->carry_offset);
+        }
+        chunk->position += take;
+        if (chunk_exhausted(lexer)) {
+            return need_input(lexer, token);
+        }
+        step *= 2;
+    }
+}
+
+// Un '/' o '%' al final de un fragmento puede abrir un comentario; se decide
+// con el primer byte del fragmento siguiente. Devuelve false si tras consumir
+// la apertura hay que seguir analizando.
+static bool resolve_opener(StreamLexer *lexer, StreamToken *token, StreamStatus *status) {
+    Lexer *chunk = &lexer->chunk;
+    char opener = lexer->pending_opener;
+    if (chunk_exhausted(lexer) && !lexer->final) {
+        *status = request_input(lexer);
+        return true;
+    }
+    lexer->pending_opener = '\0';
+    char next = chunk_exhausted(lexer) ? '\0' : chunk->source[chunk->position];
+    if (opener == '/' && next == '/') {
+        lexer->mode = STREAM_MODE_LINE_COMMENT;
+        chunk->position++;
+        return false;
+    }
+    if ((opener == '/' && next == '*') || (opener == '%' && next == '%')) {
+        lexer->mode = STREAM_MODE_BLOCK_COMMENT;
+        lexer->block_first = next;
+        lexer->block_second = opener;
+        lexer->block_pending = false;
+        chunk->position++;
+        return false;
+    }
+    *status = emit(token, opener == '/' ? TOKEN_SLASH : TOKEN_PERCENT, opener == '/' ? "/" : "%", 1,
+                   lexer->pending_offset);
+    return true;
+}
+
+StreamStatus stream_lexer_next(StreamLexer *lexer, StreamToken *token) {
+    Lexer *chunk = &lexer->chunk;
+    while (true) {
+        if (lexer->pending_opener) {
+            StreamStatus status;
+            if (resolve_opener(lexer, token, &status)) {
+                return status;
+            }
+            continue;
+        }
+        if (lexer->carry_length) {
+            if (chunk_exhausted(lexer) && !lexer->final) {
+                return request_input(lexer);
+            }
+            return complete_carry(lexer, token);
+        }
+
+        if (lexer->mode == STREAM_MODE_LINE_COMMENT) {
+            size_t newline = scan_find_byte(chunk->source, chunk->position, chunk->length, '\n');
+            if (newline == chunk->length) {
+                chunk->position = chunk->length;
+                return need_input(lexer, token);
+            }
+            chunk->position = newline + 1;
+            lexer->mode = STREAM_MODE_NORMAL;
+            continue;
+        }
+
+        if (lexer->mode == STREAM_MODE_BLOCK_COMMENT) {
+            size_t from = chunk->position;
+            if (lexer->block_pending && from < chunk->length) {
+                lexer->block_pending = false;
+                if (chunk->source[from] == lexer->block_second) {
+                    chunk->position = from + 1;
+                    lexer->mode = STREAM_MODE_NORMAL;
+                    continue;
+                }
+            }
+            size_t end = chunk->scan->find_pair(chunk->source, from, chunk->length, lexer->block_first,
+                                                lexer->block_second);
+            if (end < chunk->length) {
+                chunk->position = end + 2;
+                lexer->mode = STREAM_MODE_NORMAL;
+                continue;
+            }
+            if (chunk->length > from) {
+                lexer->block_pending = chunk->source[chunk->length - 1] == lexer->block_first;
+            }
+            chunk->position = chunk->length;
+            return need_input(lexer, token);
+        }
+
+        chunk->position = chunk->scan->skip_blanks(chunk->source, chunk->position, chunk->length);
+        if (chunk_exhausted(lexer)) {
+            return need_input(lexer, token);
+        }
+
+        size_t start = chunk->position;
+        char c = chunk->source[start];
+        bool has_next = start + 1 < chunk->length;
+        char next = has_next ? chunk->source[start + 1] : '\0';
+        if (c == '$' || (c == '/' && next == '/')) {
+            chunk->position = start + (c == '$' ? 1 : 2);
+            lexer->mode = STREAM_MODE_LINE_COMMENT;
+            continue;
+        }
+        if ((c == '/' && next == '*') || (c == '%' && next == '%')) {
+            chunk->position = start + 2;
+            lexer->mode = STREAM_MODE_BLOCK_COMMENT;
+            lexer->block_first = next;
+            lexer->block_second = c;
+            lexer->block_pending = false;
+            continue;
+        }
+        if ((c == '/' || c == '%') && !has_next && !lexer->final) {
+            lexer->pending_opener = c;
+            lexer->pending_offset = lexer->chunk_offset + start;
+            lexer->carry_offset = lexer->pending_offset;
+            lexer->carry_location = stream_lexer_location(lexer, lexer->carry_offset);
+            return request_input(lexer);
+        }
+
+        Token raw = lexer_next_token(chunk);
+        size_t end = raw.offset + raw.length;
+        if (end < chunk->length || lexer->final) {
+            return emit(token, raw.type, chunk->source + raw.offset, raw.length, lexer->chunk_offset + raw.offset);
+        }
+        lexer->carry_length = 0;
+        lexer->carry_offset = lexer->chunk_offset + start;
+        lexer->carry_location = stream_lexer_location(lexer, lexer->carry_offset);
+        if (!carry_append(lexer, chunk->source + start, end - start)) {
+            return emit(token, TOKEN_UNKNOWN, chunk->source + start, end - start, lexer->carry_offset);
+        }
+        return request_input(lexer);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef PYCLITE_STREAM_LEXER_H
+#define PYCLITE_STREAM_LEXER_H
+
+#include "lexer/lexer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Lexer reanudable que recibe la fuente por fragmentos. La memoria usada es la
+// del fragmento actual más el lexema más largo que cruce un límite entre
+// fragmentos; solo esos lexemas se copian.
+typedef enum {
+    STREAM_TOKEN,
+    STREAM_NEED_INPUT,
+    STREAM_END
+} StreamStatus;
+
+typedef struct {
+    TokenType type;
+    // Válido hasta la siguiente llamada a stream_lexer_next o stream_lexer_feed.
+    const char *lexeme;
+    size_t length;
+    size_t offset;
+} StreamToken;
+
+typedef enum {
+    STREAM_MODE_NORMAL,
+    STREAM_MODE_LINE_COMMENT,
+    STREAM_MODE_BLOCK_COMMENT
+} StreamMode;
+
+typedef struct {
+    Lexer chunk;
+    size_t chunk_offset;
+    bool final;
+    bool retired;
+
+    StreamMode mode;
+    char block_first;
+    char block_second;
+    bool block_pending;
+    char pending_opener;
+    size_t pending_offset;
+
+    char *carry;
+    size_t carry_length;
+    size_t carry_capacity;
+    size_t carry_offset;
+    SourceLocation carry_location;
+
+    size_t lines_before_chunk;
+    size_t line_start_before_chunk;
+} StreamLexer;
+
+void stream_lexer_init(StreamLexer *lexer);
+void stream_lexer_free(StreamLexer *lexer);
+// El fragmento debe seguir siendo válido hasta que stream_lexer_next devuelva
+// STREAM_NEED_INPUT o STREAM_END; después el llamador puede reutilizar su
+// búfer. final indica que no llegarán más datos.
+void stream_lexer_feed(StreamLexer *lexer, const char *data, size_t length, bool final);
+StreamStatus stream_lexer_next(StreamLexer *lexer, StreamToken *token);
+// Solo para posiciones del fragmento actual o del lexema pendiente de completar.
+SourceLocation stream_lexer_location(const StreamLexer *lexer, size_t offset);
+
+#endif // PYCLITE_STREAM_LEXER_H
@@ -0,0 +1,290 @@
+#include "structural.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+typedef enum {
+    STRUCT_NORMAL,
+    STRUCT_DOUBLE_QUOTE,
+    STRUCT_SINGLE_QUOTE,
+    STRUCT_LINE_COMMENT,
+    STRUCT_STAR_COMMENT,
+    STRUCT_PERCENT_COMMENT
+} StructuralState;
+
+typedef struct {
+    const char *source;
+    size_t end;
+    const ScanKernels *scan;
+    size_t start;
+    uint64_t valid;
+    ScanBlockMasks masks;
+} BlockCursor;
+
+static void cursor_load(BlockCursor *cursor, size_t start) {
+    cursor->start = start;
+    if (cursor->end - start >= SCAN_BLOCK_SIZE) {
+        cursor->valid = ~(uint64_t)0;
+        cursor->scan->classify_block(cursor->source + start, &cursor->masks);
+        return;
+    }
+    // El último bloque se rellena con un byte neutro y se descartan sus bits.
+    char padded[SCAN_BLOCK_SIZE];
+    size_t length = cursor->end - start;
+    memset(padded, 'x', sizeof(padded));
+    memcpy(padded, cursor->source + start, length);
+    cursor->valid = ((uint64_t)1 << length) - 1;
+    cursor->scan->classify_block(padded, &cursor->masks);
+}
+
+static char byte_at(const BlockCursor *cursor, size_t position) {
+    return position < cursor->end ? cursor->source[position] : '\0';
+}
+
+// Bit i de la salida = XOR de los bits 0..i de la entrada: marca los bytes
+// entre una comilla de apertura (incluida) y la de cierre (excluida).
+static uint64_t prefix_xor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+static uint64_t relevant_bits(const ScanBlockMasks *masks, StructuralState state) {
+    switch (state) {
+        case STRUCT_NORMAL:
+            return masks->double_quote | masks->single_quote | masks->slash | masks->dollar | masks->percent;
+        case STRUCT_DOUBLE_QUOTE:
+            return masks->double_quote | masks->backslash | masks->nul;
+        case STRUCT_SINGLE_QUOTE:
+            return masks->single_quote | masks->backslash | masks->nul;
+        case STRUCT_LINE_COMMENT:
+            return masks->newline;
+        case STRUCT_STAR_COMMENT:
+            return masks->star;
+        case STRUCT_PERCENT_COMMENT:
+            return masks->percent;
+    }
+    return 0;
+}
+
+// Procesa el byte relevante en position y devuelve dónde seguir. Reproduce
+// skip_comment y token_from_string del lexer, incluido que un '\0' cierra la
+// cadena sin consumirse y que un comentario de bloque empieza a buscar su
+// cierre dos bytes después de la apertura.
+static size_t step_state(const BlockCursor *cursor, size_t position, StructuralState *state) {
+    char c = cursor->source[position];
+    char next = byte_at(cursor, position + 1);
+    switch (*state) {
+        case STRUCT_NORMAL:
+            if (c == '"') {
+                *state = STRUCT_DOUBLE_QUOTE;
+            } else if (c == '\'') {
+                *state = STRUCT_SINGLE_QUOTE;
+            } else if (c == '$') {
+                *state = STRUCT_LINE_COMMENT;
+            } else if (c == '/' && next == '/') {
+                *state = STRUCT_LINE_COMMENT;
+                return position + 2;
+            } else if (c == '/' && next == '*') {
+                *state = STRUCT_STAR_COMMENT;
+                return position + 2;
+            } else if (c == '%' && next == '%') {
+                *state = STRUCT_PERCENT_COMMENT;
+                return position + 2;
+            }
+            return position + 1;
+        case STRUCT_DOUBLE_QUOTE:
+        case STRUCT_SINGLE_QUOTE:
+            if (c == '\0') {
+                *state = STRUCT_NORMAL;
+                return position;
+            }
+            if (c == '\\') {
+                return next != '\0' ? position + 2 : position + 1;
+            }
+            *state = STRUCT_NORMAL;
+            return position + 1;
+        case STRUCT_LINE_COMMENT:
+            *state = STRUCT_NORMAL;
+            return position + 1;
+        case STRUCT_STAR_COMMENT:
+            if (next == '/') {
+                *state = STRUCT_NORMAL;
+                return position + 2;
+            }
+            return position + 1;
+        case STRUCT_PERCENT_COMMENT:
+            if (next == '%') {
+                *state = STRUCT_NORMAL;
+                return position + 2;
+            }
+            return position + 1;
+    }
+    return position + 1;
+}
+
+// Camino rápido al estilo simdjson: en un bloque sin comillas simples, barras
+// invertidas, '\0' ni aperturas de comentario fuera de cadena, el estado
+// dentro/fuera de cadena sale del prefix-XOR de las comillas dobles sin
+// recorrer byte a byte. Con dos tipos de comilla, escapes y cuatro formas de
+// comentario el prefix-XOR no basta en general; esos bloques los resuelve
+// step_state saltando de bit relevante en bit relevante.
+static bool quote_only_block(const BlockCursor *cursor, StructuralState state, uint64_t *in_string) {
+    const ScanBlockMasks *masks = &cursor->masks;
+    if (masks->single_quote | masks->backslash | (masks->nul & cursor->valid)) {
+        return false;
+    }
+    *in_string = prefix_xor(masks->double_quote) ^ (state == STRUCT_DOUBLE_QUOTE ? ~(uint64_t)0 : 0);
+    char after = byte_at(cursor, cursor->start + SCAN_BLOCK_SIZE);
+    uint64_t slash_next = (masks->slash | masks->star) >> 1 | (uint64_t)(after == '/' || after == '*') << 63;
+    uint64_t percent_next = masks->percent >> 1 | (uint64_t)(after == '%') << 63;
+    uint64_t openers = masks->dollar | (masks->slash & slash_next) | (masks->percent & percent_next);
+    return (openers & ~*in_string & cursor->valid) == 0;
+}
+
+size_t lexer_find_boundaries(const char *source, size_t begin, size_t end, size_t *boundaries, size_t max_boundaries) {
+    BlockCursor cursor = {source, end, scan_kernels(), SIZE_MAX, 0, {0}};
+    size_t found = 0;
+    size_t step = (end - begin) / (max_boundaries + 1);
+    size_t target = begin + step;
+    StructuralState state = STRUCT_NORMAL;
+    size_t position = begin;
+    while (position < end && found < max_boundaries) {
+        size_t block = begin + (position - begin) / SCAN_BLOCK_SIZE * SCAN_BLOCK_SIZE;
+        if (block != cursor.start) {
+            cursor_load(&cursor, block);
+        }
+        unsigned offset = (unsigned)(position - block);
+        uint64_t remaining = (~(uint64_t)0 << offset) & cursor.valid;
+        uint64_t past_target = target <= block ? ~(uint64_t)0
+                               : target - block >= SCAN_BLOCK_SIZE ? 0
+                               : ~(uint64_t)0 << (target - block);
+
+        uint64_t in_string;
+        if (offset == 0 && (state == STRUCT_NORMAL || state == STRUCT_DOUBLE_QUOTE) &&
+            quote_only_block(&cursor, state, &in_string)) {
+            uint64_t candidates = cursor.masks.blank & ~in_string & remaining & past_target;
+            if (candidates) {
+                boundaries[found++] = block + (size_t)__builtin_ctzll(candidates);
+                target = begin + step * (found + 1);
+                position = boundaries[found - 1] + 1;
+                state = STRUCT_NORMAL;
+                continue;
+            }
+            if (__builtin_popcountll(cursor.masks.double_quote & cursor.valid) & 1) {
+                state = state == STRUCT_NORMAL ? STRUCT_DOUBLE_QUOTE : STRUCT_NORMAL;
+            }
+            position = block + SCAN_BLOCK_SIZE;
+            continue;
+        }
+
+        uint64_t relevant = relevant_bits(&cursor.masks, state) & remaining;
+        if (state == STRUCT_NORMAL) {
+            uint64_t before = relevant ? (relevant & -relevant) - 1 : ~(uint64_t)0;
+            uint64_t candidates = cursor.masks.blank & remaining & before & past_target;
+            if (candidates) {
+                boundaries[found++] = block + (size_t)__builtin_ctzll(candidates);
+                target = begin + step * (found + 1);
+                position = boundaries[found - 1] + 1;
+                continue;
+            }
+        }
+        if (!relevant) {
+            position = block + SCAN_BLOCK_SIZE;
+            continue;
+        }
+        position = step_state(&cursor, block + (size_t)__builtin_ctzll(relevant), &state);
+    }
+    return found;
+}
+
+typedef struct {
+    Lexer lexer;
+    TokenBuffer *tokens;
+    TokenBuffer local;
+    bool ok;
+} LexChunk;
+
+static void *lex_chunk(void *arg) {
+    LexChunk *chunk = (LexChunk *)arg;
+    chunk->ok = lexer_tokenize_all(&chunk->lexer, chunk->tokens);
+    return NULL;
+}
+
+bool lexer_tokenize_parallel(Lexer *lexer, TokenBuffer *buffer, size_t threads, size_t min_chunk_size) {
+    size_t begin = lexer->position;
+    size_t end = lexer->length;
+    size_t chunks = min_chunk_size ? threads : 1;
+    if (min_chunk_size && (end - begin) / min_chunk_size < chunks) {
+        chunks = (end - begin) / min_chunk_size;
+    }
+    size_t *boundaries = chunks > 1 ? (size_t *)malloc((chunks - 1) * sizeof(size_t)) : NULL;
+    if (boundaries) {
+        chunks = lexer_find_boundaries(lexer->source, begin, end, boundaries, chunks - 1) + 1;
+    }
+    LexChunk *parts = boundaries && chunks > 1 ? (LexChunk *)calloc(chunks, sizeof(LexChunk)) : NULL;
+    pthread_t *handles = parts ? (pthread_t *)malloc(chunks * sizeof(pthread_t)) : NULL;
+    bool *started = handles ? (bool *)calloc(chunks, sizeof(bool)) : NULL;
+    if (!started) {
+        free(boundaries);
+        free(parts);
+        free(handles);
+        return lexer_tokenize_all(lexer, buffer);
+    }
+
+    // El primer trozo escribe directamente en buffer; el resto se copia detrás.
+    for (size_t i = 0; i < chunks; ++i) {
+        size_t chunk_begin = i == 0 ? begin : boundaries[i - 1];
+        size_t chunk_end = i + 1 == chunks ? end : boundaries[i];
+        lexer_init_range(&parts[i].lexer, lexer->source, chunk_begin, chunk_end);
+        parts[i].lexer.engine = lexer->engine;
+        parts[i].lexer.scan = lexer->scan;
+        token_buffer_init(&parts[i].local);
+        parts[i].tokens = i == 0 ? buffer : &parts[i].local;
+    }
+    free(boundaries);
+    for (size_t i = 1; i < chunks; ++i) {
+        started[i] = pthread_create(&handles[i], NULL, lex_chunk, &parts[i]) == 0;
+    }
+    lex_chunk(&parts[0]);
+    for (size_t i = 1; i < chunks; ++i) {
+        if (started[i]) {
+            pthread_join(handles[i], NULL);
+        } else {
+            lex_chunk(&parts[i]);
+        }
+    }
+    free(handles);
+    free(started);
+
+    // Cada trozo acaba en su propio TOKEN_EOF; solo se conserva el del último.
+    bool ok = parts[0].ok;
+    size_t total = buffer->count;
+    for (size_t i = 1; i < chunks && ok; ++i) {
+        ok = parts[i].ok;
+        total += parts[i].local.count - 1;
+    }
+    ok = ok && token_buffer_reserve(buffer, total);
+    if (ok) {
+        buffer->count--;
+        for (size_t i = 1; i < chunks; ++i) {
+            size_t count = parts[i].local.count - (i + 1 < chunks);
+            memcpy(buffer->tokens + buffer->count, parts[i].local.tokens, count * sizeof(Token));
+            buffer->count += count;
+        }
+    }
+    for (size_t i = 0; i < chunks; ++i) {
+        token_buffer_free(&parts[i].local);
+        lexer_free(&parts[i].lexer);
+    }
+    free(parts);
+    lexer->position = end;
+    return ok;
+}
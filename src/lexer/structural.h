@@ -0,0 +1,23 @@
+#ifndef PYCLITE_STRUCTURAL_H
+#define PYCLITE_STRUCTURAL_H
+
+#include "lexer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Índice estructural: recorre [begin, end) por bloques de 64 bytes clasificados
+// con los núcleos vectoriales de scan.h y busca hasta max_boundaries puntos de
+// corte, el primero tras cada fracción 1/(max_boundaries+1) del rango. Un punto
+// de corte es un espacio en blanco fuera de cadenas y comentarios: el lexer
+// nunca tiene un token abierto ahí, así que cada trozo se puede analizar por
+// separado. Devuelve cuántos encontró, en orden creciente.
+size_t lexer_find_boundaries(const char *source, size_t begin, size_t end, size_t *boundaries, size_t max_boundaries);
+
+// Como lexer_tokenize_all, pero reparte el resto de la fuente en trozos de al
+// menos min_chunk_size bytes separados por lexer_find_boundaries y los analiza
+// en threads hilos; con min_chunk_size 0 no divide. Los tokens resultantes son
+// idénticos a los del análisis en serie.
+bool lexer_tokenize_parallel(Lexer *lexer, TokenBuffer *buffer, size_t threads, size_t min_chunk_size);
+
+#endif // PYCLITE_STRUCTURAL_H
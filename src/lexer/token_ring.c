@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "token_ring.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+// Potencia de dos: 16 Ki tokens son 192 KiB, cabe en la L2 compartida.
+#define TOKEN_RING_CAPACITY 16384
+#define TOKEN_RING_MASK (TOKEN_RING_CAPACITY - 1)
+// Los índices compartidos se publican cada TOKEN_RING_BATCH tokens para que
+// la línea de caché de head y tail no rebote entre núcleos en cada token.
+#define TOKEN_RING_BATCH 256
+#define TOKEN_RING_CACHE_LINE 64
+
+struct TokenRing {
+    // Compartido: cada índice en su propia línea de caché.
+    alignas(TOKEN_RING_CACHE_LINE) atomic_size_t head;
+    alignas(TOKEN_RING_CACHE_LINE) atomic_size_t tail;
+    alignas(TOKEN_RING_CACHE_LINE) atomic_bool stop;
+    atomic_bool done;
+
+    // Solo el productor.
+    alignas(TOKEN_RING_CACHE_LINE) Lexer lexer;
+    size_t producer_tail;
+
+    // Solo el consumidor.
+    alignas(TOKEN_RING_CACHE_LINE) size_t read_index;
+    size_t consumer_head;
+    bool finished;
+    Token eof;
+    pthread_t thread;
+
+    alignas(TOKEN_RING_CACHE_LINE) Token slots[TOKEN_RING_CAPACITY];
+};
+
+// Con un solo núcleo, girar en vacío solo retrasa al otro hilo: tras unas
+// pocas vueltas se cede la CPU.
+static void ring_wait(unsigned *spins) {
+    if (++*spins < 64) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+        return;
+    }
+    sched_yield();
+}
+
+static void *ring_produce(void *arg) {
+    TokenRing *ring = (TokenRing *)arg;
+    size_t write = 0;
+    size_t published = 0;
+    while (true) {
+        if (write - ring->producer_tail == TOKEN_RING_CAPACITY) {
+            // Publicar antes de esperar: el consumidor puede estar esperando
+            // precisamente estos tokens.
+            atomic_store_explicit(&ring->head, write, memory_order_release);
+            published = write;
+            unsigned spins = 0;
+            while ((ring->producer_tail = atomic_load_explicit(&ring->tail, memory_order_acquire)) +
+                       TOKEN_RING_CAPACITY == write) {
+                if (atomic_load_explicit(&ring->stop, memory_order_relaxed)) {
+                    return NULL;
+                }
+                ring_wait(&spins);
+            }
+        }
+        Token token = lexer_next_token(&ring->lexer);
+        ring->slots[write & TOKEN_RING_MASK] = token;
+        write++;
+        if (token.type == TOKEN_EOF) {
+            atomic_store_explicit(&ring->head, write, memory_order_release);
+            atomic_store_explicit(&ring->done, true, memory_order_release);
+            return NULL;
+        }
+        if (write - published >= TOKEN_RING_BATCH) {
+            atomic_store_explicit(&ring->head, write, memory_order_release);
+            published = write;
+            if (atomic_load_explicit(&ring->stop, memory_order_relaxed)) {
+                return NULL;
+            }
+        }
+    }
+}
+
+TokenRing *token_ring_start(const char *source, size_t length) {
+    size_t size = (sizeof(TokenRing) + TOKEN_RING_CACHE_LINE - 1) & ~(size_t)(TOKEN_RING_CACHE_LINE - 1);
+    TokenRing *ring = (TokenRing *)aligned_alloc(TOKEN_RING_CACHE_LINE, size);
+    if (!ring) {
+        return NULL;
+    }
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->stop, false);
+    atomic_init(&ring->done, false);
+    lexer_init(&ring->lexer, source, length);
+    ring->producer_tail = 0;
+    ring->read_index = 0;
+    ring->consumer_head = 0;
+    ring->finished = false;
+    if (pthread_create(&ring->thread, NULL, ring_produce, ring) != 0) {
+        lexer_free(&ring->lexer);
+        free(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+// Espera a que haya al menos index + 1 tokens publicados. Devuelve false si el
+// productor terminó antes (el último publicado es entonces el TOKEN_EOF).
+static bool ring_wait_for(TokenRing *ring, size_t index) {
+    if (index < ring->consumer_head) {
+        return true;
+    }
+    // Liberar lo ya consumido antes de esperar, o el productor podría estar
+    // bloqueado con el anillo lleno esperando este mismo tail.
+    atomic_store_explicit(&ring->tail, ring->read_index, memory_order_release);
+    unsigned spins = 0;
+    while (true) {
+        bool done = atomic_load_explicit(&ring->done, memory_order_acquire);
+        ring->consumer_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (index < ring->consumer_head) {
+            return true;
+        }
+        if (done) {
+            return false;
+        }
+        ring_wait(&spins);
+    }
+}
+
+Token token_ring_next(TokenRing *ring) {
+    if (ring->finished) {
+        return ring->eof;
+    }
+    size_t read = ring->read_index;
+    ring_wait_for(ring, read);
+    Token token = ring->slots[read & TOKEN_RING_MASK];
+    ring->read_index = read + 1;
+    if (ring->read_index % TOKEN_RING_BATCH == 0) {
+        atomic_store_explicit(&ring->tail, ring->read_index, memory_order_release);
+    }
+    if (token.type == TOKEN_EOF) {
+        ring->finished = true;
+        ring->eof = token;
+    }
+    return token;
+}
+
+Token token_ring_peek(TokenRing *ring, size_t distance) {
+    if (ring->finished) {
+        return ring->eof;
+    }
+    if (distance >= TOKEN_RING_CAPACITY) {
+        distance = TOKEN_RING_CAPACITY - 1;
+    }
+    size_t index = ring->read_index + distance;
+    if (!ring_wait_for(ring, index)) {
+        index = ring->consumer_head - 1;
+    }
+    return ring->slots[index & TOKEN_RING_MASK];
+}
+
+void token_ring_free(TokenRing *ring) {
+    if (!ring) {
+        return;
+    }
+    atomic_store_explicit(&ring->stop, true, memory_order_relaxed);
+    pthread_join(ring->thread, NULL);
+    lexer_free(&ring->lexer);
+    free(ring);
+}
@@ -0,0 +1,25 @@
+#ifndef PYCLITE_TOKEN_RING_H
+#define PYCLITE_TOKEN_RING_H
+
+#include "lexer.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Anillo de un productor y un consumidor sin cerrojos: un hilo propio ejecuta
+// el lexer y publica los tokens por lotes; el hilo del parser los consume.
+typedef struct TokenRing TokenRing;
+
+// Arranca el hilo productor sobre [0, length) de source. Devuelve NULL si no
+// hay memoria o no se pudo crear el hilo.
+TokenRing *token_ring_start(const char *source, size_t length);
+// Siguiente token; tras el TOKEN_EOF sigue devolviéndolo sin esperar.
+Token token_ring_next(TokenRing *ring);
+// Token distance posiciones por delante del siguiente sin consumirlo (0 es el
+// que devolvería token_ring_next). Las distancias mayores que la capacidad
+// del anillo se recortan.
+Token token_ring_peek(TokenRing *ring, size_t distance);
+// Detiene el productor aunque no haya llegado al final y libera el anillo.
+void token_ring_free(TokenRing *ring);
+
+#endif // PYCLITE_TOKEN_RING_H
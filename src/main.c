@@ -1,65 +1,237 @@
-#include "parser/parser.h"
+#include "cache/ast_cache.h"
+#include "driver/driver.h"
+#include "lexer/stream_lexer.h"
+#include "server/server.h"
+#include "stats/stats.h"
 
  #include <stdio.h>
  #include <stdlib.h>
+ #include <string.h>
 
- static char *read_file(const char *path, size_t *out_size) {
-     FILE *file = fopen(path, "rb");
-     if (!file) {
-         return NULL;
-     }
-     fseek(file, 0, SEEK_END);
-     long size = ftell(file);
-     fseek(file, 0, SEEK_SET);
+ #define STREAM_CHUNK_SIZE (64 * 1024)
+ #define DEFAULT_MAX_ERRORS 20
 
-     if (size < 0) {
-         fclose(file);
-         return NULL;
+ static int stream_lex(const char *path) {
+     FILE *input = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+     if (!input) {
+         fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+         return 1;
      }
-
-     char *buffer = (char *)malloc((size_t)size + 1);
-     if (!buffer) {
-         fclose(file);
-         return NULL;
+     static char chunk[STREAM_CHUNK_SIZE];
+     StreamLexer lexer;
+     stream_lexer_init(&lexer);
+     StreamToken token;
+     size_t token_count = 0;
+     int status = 0;
+     while (true) {
+         StreamStatus result = stream_lexer_next(&lexer, &token);
+         if (result == STREAM_NEED_INPUT) {
+             size_t read = fread(chunk, 1, sizeof(chunk), input);
+             stream_lexer_feed(&lexer, chunk, read, read < sizeof(chunk));
+             continue;
+         }
+         if (result == STREAM_END) {
+             break;
+         }
+         token_count++;
+         if (token.type == TOKEN_UNKNOWN) {
+             SourceLocation location = stream_lexer_location(&lexer, token.offset);
+             fprintf(stderr, "Error léxico en línea %zu, columna %zu: carácter no reconocido '%.*s'.\n",
+                     location.line, location.column, (int)token.length, token.lexeme);
+             status = 1;
+             break;
+         }
+     }
+     if (ferror(input)) {
+         fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+         status = 1;
+     }
+     if (input != stdin) {
+         fclose(input);
      }
+     stream_lexer_free(&lexer);
+     if (status == 0) {
+         printf("Análisis léxico completado: %zu tokens.\n", token_count + 1);
+     }
+     return status;
+ }
 
-     size_t read = fread(buffer, 1, (size_t)size, file);
-     fclose(file);
-     buffer[read] = '\0';
-     if (out_size) {
-         *out_size = read;
+ // Cuenta no negativa de -j N, -jN, --jobs=N (0 son todos los núcleos),
+ // --max-errors=N (0 es sin límite) y --split-size=N (0 no divide).
+ static bool parse_count(const char *text, size_t *count) {
+     char *end;
+     unsigned long value = strtoul(text, &end, 10);
+     if (*text == '\0' || *end != '\0' || *text == '-') {
+         return false;
      }
-     return buffer;
+     *count = (size_t)value;
+     return true;
  }
 
- int main(int argc, char **argv) {
-     if (argc < 2) {
-         fprintf(stderr, "Uso: %s <archivo.pycl>\n", argv[0]);
+ static int run_client(const char *socket_path, bool stop, const DriverFileList *files, const DriverOptions *options) {
+     if (stop) {
+         if (!server_stop(socket_path)) {
+             fprintf(stderr, "No hay ningún servidor escuchando en %s\n", socket_path);
+             return 1;
+         }
+         return 0;
+     }
+     for (size_t i = 0; i < files->count; ++i) {
+         if (strcmp(files->paths[i], "-") == 0) {
+             fprintf(stderr, "La entrada estándar no se puede enviar al servidor.\n");
+             return 1;
+         }
+     }
+     DriverResult *results = (DriverResult *)malloc(files->count * sizeof(DriverResult));
+     if (!results) {
+         fprintf(stderr, "Memoria insuficiente para %zu archivos.\n", files->count);
          return 1;
      }
-
-     size_t source_size = 0;
-     char *source = read_file(argv[1], &source_size);
-     if (!source) {
-         fprintf(stderr, "No se pudo leer el archivo: %s\n", argv[1]);
+     if (!server_check(socket_path, files, options->max_errors, results)) {
+         fprintf(stderr, "No se pudo comunicar con el servidor en %s\n", socket_path);
+         free(results);
          return 1;
      }
+     int status = driver_report(files, results, options) ? 1 : 0;
+     for (size_t i = 0; i < files->count; ++i) {
+         driver_result_free(&results[i]);
+     }
+     free(results);
+     return status;
+ }
 
-     Parser parser;
-     parser_init(&parser, source, source_size);
-     ASTNode *program = parser_parse(&parser);
-
-     if (parser_has_error(&parser) || !program) {
-         Token error_token = parser_error_token(&parser);
-         fprintf(stderr, "Error de parseo en línea %zu, columna %zu: %s\n",
-                 error_token.line, error_token.column, parser_error_message(&parser));
-         free(source);
+ static int write_stats(const char *path, double wall_seconds) {
+     FILE *output = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+     if (!output) {
+         fprintf(stderr, "No se pudo escribir el archivo: %s\n", path);
+         return 1;
+     }
+     stats_report(output, wall_seconds);
+     if (output != stdout && fclose(output) != 0) {
+         fprintf(stderr, "No se pudo escribir el archivo: %s\n", path);
          return 1;
      }
-
-     printf("Parseo completado correctamente.\n");
-     ast_free(program);
-     free(source);
      return 0;
  }
 
+ int main(int argc, char **argv) {
+     DriverOptions options = {.jobs = 1, .parse_threads = 1, .max_errors = DEFAULT_MAX_ERRORS};
+     DriverFileList files;
+     driver_file_list_init(&files);
+     bool lex_only = false;
+     bool usage = false;
+     const char *serve = NULL;
+     const char *connect = NULL;
+     bool stop = false;
+     const char *stats = NULL;
+     ScanLevel scan_level = SCAN_AUTO;
+     for (int i = 1; i < argc && !usage; ++i) {
+         if (strcmp(argv[i], "--heap-ast") == 0) {
+             options.heap_ast = true;
+         } else if (strcmp(argv[i], "--flat-ast") == 0) {
+             options.flat_ast = true;
+         } else if (strcmp(argv[i], "--batch") == 0) {
+             options.batch = true;
+         } else if (strcmp(argv[i], "--pipeline") == 0) {
+             options.pipeline = true;
+         } else if (strcmp(argv[i], "--stream") == 0) {
+             options.stream = true;
+         } else if (strcmp(argv[i], "--resolve") == 0) {
+             options.resolve = true;
+         } else if (strcmp(argv[i], "--types") == 0) {
+             options.resolve = true;
+             options.infer_types = true;
+         } else if (strcmp(argv[i], "-O") == 0) {
+             options.resolve = true;
+             options.infer_types = true;
+             options.optimize = true;
+         } else if (strcmp(argv[i], "--lex-only") == 0) {
+             lex_only = true;
+         } else if (strncmp(argv[i], "--cache=", 8) == 0) {
+             options.cache_dir = argv[i] + 8;
+         } else if (strncmp(argv[i], "--serve=", 8) == 0) {
+             serve = argv[i] + 8;
+         } else if (strncmp(argv[i], "--connect=", 10) == 0) {
+             connect = argv[i] + 10;
+         } else if (strcmp(argv[i], "--stop") == 0) {
+             stop = true;
+         } else if (strcmp(argv[i], "--stats") == 0) {
+             stats = "-";
+         } else if (strncmp(argv[i], "--stats=", 8) == 0) {
+             stats = argv[i] + 8;
+         } else if (strcmp(argv[i], "--lexer=dfa") == 0) {
+             lexer_set_default_engine(LEXER_ENGINE_DFA);
+         } else if (strcmp(argv[i], "--lexer=classic") == 0) {
+             lexer_set_default_engine(LEXER_ENGINE_CLASSIC);
+         } else if (strcmp(argv[i], "--scan=scalar") == 0) {
+             scan_level = SCAN_SCALAR;
+         } else if (strcmp(argv[i], "--scan=sse2") == 0) {
+             scan_level = SCAN_SSE2;
+         } else if (strcmp(argv[i], "--scan=avx2") == 0) {
+             scan_level = SCAN_AVX2;
+         } else if (strcmp(argv[i], "-j") == 0) {
+             usage = i + 1 == argc || !parse_count(argv[++i], &options.jobs);
+         } else if (strncmp(argv[i], "-j", 2) == 0 && strcmp(argv[i], "-") != 0) {
+             usage = !parse_count(argv[i] + 2, &options.jobs);
+         } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+             usage = !parse_count(argv[i] + 7, &options.jobs);
+         } else if (strncmp(argv[i], "--split-size=", 13) == 0) {
+             usage = !parse_count(argv[i] + 13, &options.split_size);
+         } else if (strncmp(argv[i], "--max-errors=", 13) == 0) {
+             usage = !parse_count(argv[i] + 13, &options.max_errors);
+         } else if (!driver_collect(&files, argv[i])) {
+             fprintf(stderr, "No se pudo leer el directorio: %s\n", argv[i]);
+             driver_file_list_free(&files);
+             return 1;
+         }
+     }
+     bool needs_files = !serve && !(connect && stop);
+     if (usage || (needs_files && files.count == 0) || (stop && !connect)) {
+         fprintf(stderr, "Uso: %s [--heap-ast] [--flat-ast] [--batch] [--pipeline] [--stream] [--resolve] [--types] [-O] [--lex-only] [--lexer=classic|dfa] [--scan=scalar|sse2|avx2] [-j N] [--split-size=BYTES] [--max-errors=N] [--cache=DIR] [--stats[=ARCHIVO]] [--connect=SOCKET] <archivo.pycl|directorio>...\n"
+                         "     %s --serve=SOCKET\n"
+                         "     %s --connect=SOCKET --stop\n", argv[0], argv[0], argv[0]);
+         driver_file_list_free(&files);
+         return 1;
+     }
+     if (options.resolve && (options.stream || options.flat_ast || connect)) {
+         fprintf(stderr, "--resolve, --types y -O necesitan el árbol completo: no se pueden combinar con "
+                         "--stream, --flat-ast ni --connect.\n");
+         driver_file_list_free(&files);
+         return 1;
+     }
+     if (stats && !stats_enabled()) {
+         fprintf(stderr, "Este binario se compiló sin estadísticas; recompila con make STATS=1 para usar --stats.\n");
+         driver_file_list_free(&files);
+         return 1;
+     }
+     // Para medir el análisis léxico aparte, --stats tokeniza cada archivo
+     // entero antes de parsearlo, como --batch.
+     if (stats) {
+         options.batch = true;
+     }
+     if (options.cache_dir && !ast_cache_prepare(options.cache_dir)) {
+         fprintf(stderr, "No se pudo crear el directorio de caché: %s\n", options.cache_dir);
+         driver_file_list_free(&files);
+         return 1;
+     }
+     // Los kernels de escaneo se eligen una sola vez, antes de arrancar hilos.
+     scan_set_level(scan_level);
+     int status = 0;
+     if (serve) {
+         status = server_run(serve);
+     } else if (connect) {
+         status = run_client(connect, stop, &files, &options);
+     } else if (lex_only) {
+         for (size_t i = 0; i < files.count; ++i) {
+             status |= stream_lex(files.paths[i]);
+         }
+     } else {
+         double started = stats_now();
+         status = driver_run(&files, &options) ? 1 : 0;
+         if (stats) {
+             status |= write_stats(stats, stats_now() - started);
+         }
+     }
+     driver_file_list_free(&files);
+     return status;
+ }
@@ -0,0 +1,1061 @@
+#include "optimizer.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Los literales reales más largos no se pliegan.
+#define OPTIMIZER_MAX_NUMBER_LENGTH 64
+// Nodos que puede recorrer la evaluación de una llamada y, entre todas, los
+// de cada archivo: una base fija más unos cuantos por cada nodo del árbol.
+#define OPTIMIZER_CALL_FUEL 100000
+#define OPTIMIZER_FILE_FUEL 1000000
+#define OPTIMIZER_FUEL_PER_NODE 16
+// Anidamiento de expresiones, instrucciones y llamadas que admite el
+// intérprete, que es recursivo.
+#define OPTIMIZER_MAX_NESTING 1024
+// parent de las llamadas a func que no están dentro de otra evaluada.
+#define OPTIMIZER_OUTSIDE UINT32_MAX
+
+struct OptimizerFrame {
+    // Hueco del árbol donde cuelga el nodo, para poder sustituirlo.
+    ASTNode **slot;
+    // Nodo cuyos hijos son los operandos: el propio nodo o el AST_ARG_LIST de
+    // una llamada; NULL si no tiene.
+    ASTNode *operands;
+    uint32_t next;
+    // Algún operando ya optimizado tiene efectos.
+    bool effects;
+};
+
+// Valor de un literal numérico, char o bool; los tres últimos van en integer.
+typedef struct {
+    ValueType type;
+    int64_t integer;
+    double real;
+} OptimizerValue;
+
+struct OptimizerActivation {
+    // Llamada en curso de la func que contiene a esta, de la que se leen las
+    // variables de fuera; OPTIMIZER_OUTSIDE si no se está evaluando.
+    uint32_t parent;
+    // Primer hueco de su marco en slots.
+    size_t base;
+};
+
+struct OptimizerSlot {
+    // VALUE_UNKNOWN mientras no tenga valor.
+    OptimizerValue value;
+    // Tipo con que se declaró; VALUE_UNKNOWN en los parámetros, que no llevan.
+    ValueType declared;
+};
+
+static bool optimizer_statements(Optimizer *optimizer, ASTNode *list);
+static bool optimizer_eval(Optimizer *optimizer, uint32_t activation, const ASTNode *node, OptimizerValue *value);
+static bool optimizer_run(Optimizer *optimizer, uint32_t activation, const ASTNode *list, bool *returned,
+                          OptimizerValue *result);
+static bool optimizer_execute(Optimizer *optimizer, uint32_t activation, const ASTNode *node, bool *returned,
+                              OptimizerValue *result);
+
+void optimizer_init(Optimizer *optimizer) {
+    memset(&optimizer->summary, 0, sizeof(optimizer->summary));
+    optimizer->source = NULL;
+    optimizer->frames = NULL;
+    optimizer->frame_count = 0;
+    optimizer->frame_capacity = 0;
+    optimizer->pending = NULL;
+    optimizer->pending_capacity = 0;
+    optimizer->dead = NULL;
+    optimizer->dead_count = 0;
+    optimizer->dead_capacity = 0;
+    optimizer->functions = NULL;
+    optimizer->redefined = NULL;
+    optimizer->declaration_capacity = 0;
+    optimizer->activations = NULL;
+    optimizer->activation_count = 0;
+    optimizer->activation_capacity = 0;
+    optimizer->slots = NULL;
+    optimizer->slot_count = 0;
+    optimizer->slot_capacity = 0;
+    optimizer->fuel = 0;
+    optimizer->budget = 0;
+    optimizer->nesting = 0;
+}
+
+void optimizer_free(Optimizer *optimizer) {
+    free(optimizer->frames);
+    free(optimizer->pending);
+    free(optimizer->dead);
+    free(optimizer->functions);
+    free(optimizer->redefined);
+    free(optimizer->activations);
+    free(optimizer->slots);
+    optimizer_init(optimizer);
+}
+
+static bool optimizer_is_integer(ValueType type) {
+    return type == VALUE_INT || type == VALUE_CHAR || type == VALUE_BOOL;
+}
+
+static bool optimizer_is_scalar(ValueType type) {
+    return optimizer_is_integer(type) || type == VALUE_FLOAT;
+}
+
+static bool optimizer_is_concrete(ValueType type) {
+    return type != VALUE_UNKNOWN && type != VALUE_DYNAMIC;
+}
+
+static double optimizer_real(OptimizerValue value) {
+    return value.type == VALUE_FLOAT ? value.real : (double)value.integer;
+}
+
+static bool optimizer_truth(OptimizerValue value) {
+    return value.type == VALUE_FLOAT ? value.real != 0.0 : value.integer != 0;
+}
+
+// Cero positivo: x - 0 es x incluso con x = -0.0, pero x - (-0.0) no.
+static bool optimizer_is_zero(OptimizerValue value) {
+    return value.type == VALUE_FLOAT ? value.real == 0.0 && !signbit(value.real) : value.integer == 0;
+}
+
+static bool optimizer_is_one(OptimizerValue value) {
+    return value.type == VALUE_FLOAT ? value.real == 1.0 : value.integer == 1;
+}
+
+static bool optimizer_number(const char *text, uint32_t length, OptimizerValue *value) {
+    if (!memchr(text, '.', length)) {
+        int64_t integer = 0;
+        for (uint32_t i = 0; i < length; ++i) {
+            int digit = text[i] - '0';
+            if (integer > (INT64_MAX - digit) / 10) {
+                return false;
+            }
+            integer = integer * 10 + digit;
+        }
+        value->type = VALUE_INT;
+        value->integer = integer;
+        return true;
+    }
+    char buffer[OPTIMIZER_MAX_NUMBER_LENGTH];
+    if (length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    char *end;
+    value->type = VALUE_FLOAT;
+    value->real = strtod(buffer, &end);
+    return end == buffer + length && isfinite(value->real);
+}
+
+// Valor de node si es un literal numérico, char o bool.
+static bool optimizer_value(const Optimizer *optimizer, const ASTNode *node, OptimizerValue *value) {
+    if (node->type != AST_LITERAL) {
+        return false;
+    }
+    if (node->token.length == 0) {
+        value->type = node->value_type;
+        value->integer = node->value_type == VALUE_FLOAT ? 0 : node->integer;
+        value->real = node->value_type == VALUE_FLOAT ? node->real : 0.0;
+        return optimizer_is_scalar(value->type);
+    }
+    const char *text = optimizer->source + node->token.offset;
+    value->real = 0.0;
+    switch (node->token.type) {
+        case TOKEN_TRUE:
+        case TOKEN_FALSE:
+            value->type = VALUE_BOOL;
+            value->integer = node->token.type == TOKEN_TRUE;
+            return true;
+        case TOKEN_CHAR:
+            // Solo 'x': las secuencias de escape no se interpretan aquí.
+            if (node->token.length != 3 || text[1] == '\\' || text[2] != '\'') {
+                return false;
+            }
+            value->type = VALUE_CHAR;
+            value->integer = (unsigned char)text[1];
+            return true;
+        case TOKEN_NUMBER:
+            return optimizer_number(text, node->token.length, value);
+        default:
+            return false;
+    }
+}
+
+// Contenido de un literal de cadena sin secuencias de escape.
+static bool optimizer_string(const Optimizer *optimizer, const ASTNode *node, const char **text, uint32_t *length) {
+    if (node->type != AST_LITERAL || node->token.type != TOKEN_STRING || node->token.length < 2) {
+        return false;
+    }
+    const char *lexeme = optimizer->source + node->token.offset;
+    if (lexeme[node->token.length - 1] != '"' || memchr(lexeme, '\\', node->token.length)) {
+        return false;
+    }
+    *text = lexeme + 1;
+    *length = node->token.length - 2;
+    return true;
+}
+
+static bool optimizer_integer_arithmetic(TokenType op, int64_t a, int64_t b, int64_t *result) {
+    switch (op) {
+        case TOKEN_PLUS:
+            if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+                return false;
+            }
+            *result = a + b;
+            return true;
+        case TOKEN_MINUS:
+            if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {
+                return false;
+            }
+            *result = a - b;
+            return true;
+        case TOKEN_STAR:
+            if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+                      : (b > 0 ? a < INT64_MIN / b : a != 0 && b < INT64_MAX / a)) {
+                return false;
+            }
+            *result = a * b;
+            return true;
+        case TOKEN_SLASH:
+        case TOKEN_PERCENT:
+            if (b == 0 || (a == INT64_MIN && b == -1)) {
+                return false;
+            }
+            *result = op == TOKEN_SLASH ? a / b : a % b;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Mismas reglas de tipos que types_binary.
+static bool optimizer_binary(TokenType op, OptimizerValue left, OptimizerValue right, OptimizerValue *result) {
+    bool integer = optimizer_is_integer(left.type) && optimizer_is_integer(right.type);
+    result->integer = 0;
+    result->real = 0.0;
+    switch (op) {
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+        case TOKEN_STAR:
+        case TOKEN_SLASH:
+        case TOKEN_PERCENT: {
+            if (integer) {
+                result->type = VALUE_INT;
+                return optimizer_integer_arithmetic(op, left.integer, right.integer, &result->integer);
+            }
+            if (op == TOKEN_PERCENT) {
+                return false;
+            }
+            double a = optimizer_real(left);
+            double b = optimizer_real(right);
+            result->type = VALUE_FLOAT;
+            result->real = op == TOKEN_PLUS ? a + b : op == TOKEN_MINUS ? a - b : op == TOKEN_STAR ? a * b : a / b;
+            return isfinite(result->real);
+        }
+        case TOKEN_EQEQ:
+        case TOKEN_BANGEQ:
+        case TOKEN_LT:
+        case TOKEN_LTE:
+        case TOKEN_GT:
+        case TOKEN_GTE: {
+            int order;
+            if (integer) {
+                order = (left.integer > right.integer) - (left.integer < right.integer);
+            } else {
+                double a = optimizer_real(left);
+                double b = optimizer_real(right);
+                order = (a > b) - (a < b);
+            }
+            bool holds = op == TOKEN_EQEQ ? order == 0 : op == TOKEN_BANGEQ ? order != 0 :
+                         op == TOKEN_LT ? order < 0 : op == TOKEN_LTE ? order <= 0 :
+                         op == TOKEN_GT ? order > 0 : order >= 0;
+            result->type = VALUE_BOOL;
+            result->integer = holds;
+            return true;
+        }
+        case TOKEN_ANDAND:
+        case TOKEN_OROR:
+            result->type = VALUE_BOOL;
+            result->integer = op == TOKEN_ANDAND ? optimizer_truth(left) && optimizer_truth(right)
+                                                 : optimizer_truth(left) || optimizer_truth(right);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool optimizer_unary(TokenType op, OptimizerValue operand, OptimizerValue *result) {
+    result->integer = 0;
+    result->real = 0.0;
+    switch (op) {
+        case TOKEN_MINUS:
+            if (operand.type == VALUE_FLOAT) {
+                result->type = VALUE_FLOAT;
+                result->real = -operand.real;
+                return true;
+            }
+            result->type = VALUE_INT;
+            result->integer = -operand.integer;
+            return operand.integer != INT64_MIN;
+        case TOKEN_BANG:
+            result->type = VALUE_BOOL;
+            result->integer = !optimizer_truth(operand);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static OptimizerValue optimizer_bool(bool truth) {
+    OptimizerValue value = {VALUE_BOOL, truth, 0.0};
+    return value;
+}
+
+// Convierte node, una AST_EXPRESSION o una AST_CALL, en el literal value.
+static void optimizer_literal(ASTNode *node, OptimizerValue value) {
+    for (uint32_t i = 0; i < node->child_count; ++i) {
+        ast_free(node->children[i]);
+    }
+    if (!node->arena) {
+        free(node->children);
+    }
+    node->type = AST_LITERAL;
+    if (value.type == VALUE_BOOL) {
+        node->token.type = value.integer ? TOKEN_TRUE : TOKEN_FALSE;
+    } else {
+        node->token.type = value.type == VALUE_CHAR ? TOKEN_CHAR : TOKEN_NUMBER;
+    }
+    node->token.length = 0;
+    node->token.symbol = 0;
+    node->value_type = value.type;
+    if (value.type == VALUE_FLOAT) {
+        node->real = value.real;
+    } else {
+        node->integer = value.integer;
+    }
+    node->children = NULL;
+    node->child_count = 0;
+    node->child_capacity = 0;
+}
+
+static void optimizer_fold(Optimizer *optimizer, ASTNode *node, OptimizerValue value) {
+    optimizer_literal(node, value);
+    optimizer->summary.folded++;
+}
+
+// Sustituye el nodo de slot por el hijo index de owner, que es él mismo o uno
+// de sus descendientes.
+static void optimizer_replace(Optimizer *optimizer, ASTNode **slot, ASTNode *owner, uint32_t index) {
+    ASTNode *node = *slot;
+    *slot = owner->children[index];
+    owner->children[index] = NULL;
+    ast_free(node);
+    optimizer->summary.simplified++;
+}
+
+// false && e, e && true, x * 1... con uno de los operandos constante. Devuelve
+// true si cambió el árbol.
+static bool optimizer_simplify(Optimizer *optimizer, ASTNode **slot, bool effects) {
+    ASTNode *node = *slot;
+    ASTNode *left = node->children[0];
+    ASTNode *right = node->children[1];
+    TokenType op = node->token.type;
+    OptimizerValue value;
+    bool constant_left = optimizer_value(optimizer, left, &value);
+    if (!constant_left && !optimizer_value(optimizer, right, &value)) {
+        return false;
+    }
+    ASTNode *other = constant_left ? right : left;
+    uint32_t other_index = constant_left ? 1 : 0;
+    if (op == TOKEN_ANDAND || op == TOKEN_OROR) {
+        // El valor que decide: falso para &&, cierto para ||.
+        bool decisive = op == TOKEN_OROR;
+        if (optimizer_truth(value) != decisive) {
+            if (other->value_type != VALUE_BOOL) {
+                return false;
+            }
+            optimizer_replace(optimizer, slot, node, other_index);
+            return true;
+        }
+        // Por la izquierda, el otro operando ni se evalúa.
+        if (!constant_left && (effects || !optimizer_is_scalar(other->value_type))) {
+            return false;
+        }
+        optimizer_fold(optimizer, node, optimizer_bool(decisive));
+        return true;
+    }
+    ValueType type = node->value_type;
+    if ((type != VALUE_INT && type != VALUE_FLOAT) || other->value_type != type) {
+        return false;
+    }
+    bool identity = false;
+    switch (op) {
+        case TOKEN_PLUS:
+            identity = type == VALUE_INT && optimizer_is_zero(value);
+            break;
+        case TOKEN_MINUS:
+            identity = !constant_left && optimizer_is_zero(value);
+            break;
+        case TOKEN_STAR:
+            identity = optimizer_is_one(value);
+            break;
+        case TOKEN_SLASH:
+            identity = !constant_left && optimizer_is_one(value);
+            break;
+        default:
+            break;
+    }
+    if (identity) {
+        optimizer_replace(optimizer, slot, node, other_index);
+    }
+    return identity;
+}
+
+// Optimiza la AST_EXPRESSION de slot, cuyos operandos ya lo están, y devuelve
+// si lo que queda en slot tiene efectos. effects dice si los tienen los
+// operandos.
+static bool optimizer_rewrite(Optimizer *optimizer, ASTNode **slot, bool effects) {
+    ASTNode *node = *slot;
+    TokenType op = node->token.type;
+    OptimizerValue left;
+    OptimizerValue right;
+    OptimizerValue result;
+    if (node->child_count == 2) {
+        const char *left_text;
+        const char *right_text;
+        uint32_t left_length;
+        uint32_t right_length;
+        if (optimizer_value(optimizer, node->children[0], &left) &&
+            optimizer_value(optimizer, node->children[1], &right)) {
+            if (optimizer_binary(op, left, right, &result)) {
+                optimizer_fold(optimizer, node, result);
+                return false;
+            }
+        } else if ((op == TOKEN_EQEQ || op == TOKEN_BANGEQ) &&
+                   optimizer_string(optimizer, node->children[0], &left_text, &left_length) &&
+                   optimizer_string(optimizer, node->children[1], &right_text, &right_length)) {
+            bool equal = left_length == right_length && memcmp(left_text, right_text, left_length) == 0;
+            optimizer_fold(optimizer, node, optimizer_bool(equal == (op == TOKEN_EQEQ)));
+            return false;
+        } else if (optimizer_simplify(optimizer, slot, effects)) {
+            // El operando que queda no tiene más efectos que los de los dos.
+            return (*slot)->type == AST_LITERAL ? false : effects;
+        }
+    } else if (node->child_count == 1) {
+        ASTNode *operand = node->children[0];
+        if (optimizer_value(optimizer, operand, &left)) {
+            if (optimizer_unary(op, left, &result)) {
+                optimizer_fold(optimizer, node, result);
+                return false;
+            }
+        } else if (op == TOKEN_BANG && operand->type == AST_EXPRESSION && operand->token.type == TOKEN_BANG &&
+                   operand->child_count == 1 && operand->children[0]->value_type == VALUE_BOOL) {
+            optimizer_replace(optimizer, slot, operand, 0);
+            return effects;
+        }
+    }
+    return effects || op == TOKEN_PLUSPLUS || op == TOKEN_MINUSMINUS || op == TOKEN_SLASH ||
+           op == TOKEN_PERCENT || !optimizer_is_concrete(node->value_type);
+}
+
+// Intérprete de las llamadas a func con argumentos constantes. Es recursivo,
+// con el anidamiento acotado por OPTIMIZER_MAX_NESTING; cualquier cosa que no
+// sepa evaluar con certeza lo hace devolver false y la llamada se queda.
+
+// Func a la que llama callee si siempre es la misma.
+static const ASTNode *optimizer_function(const Optimizer *optimizer, const ASTNode *callee) {
+    if (callee->type != AST_IDENTIFIER || callee->declaration >= optimizer->declaration_capacity ||
+        optimizer->redefined[callee->declaration]) {
+        return NULL;
+    }
+    return optimizer->functions[callee->declaration];
+}
+
+// Llamada en curso que queda depth funciones hacia fuera de activation.
+static uint32_t optimizer_outer(const Optimizer *optimizer, uint32_t activation, uint32_t depth) {
+    while (depth-- > 0 && activation != OPTIMIZER_OUTSIDE) {
+        activation = optimizer->activations[activation].parent;
+    }
+    return activation;
+}
+
+// Hueco de la variable identifier, o NULL si no es de una llamada evaluada. El
+// puntero deja de valer en cuanto se abre otro marco.
+static OptimizerSlot *optimizer_variable(Optimizer *optimizer, uint32_t activation, const ASTNode *identifier) {
+    if (identifier->type != AST_IDENTIFIER || identifier->slot == AST_NO_SLOT) {
+        return NULL;
+    }
+    uint32_t owner = optimizer_outer(optimizer, activation, identifier->depth);
+    if (owner == OPTIMIZER_OUTSIDE) {
+        return NULL;
+    }
+    return &optimizer->slots[optimizer->activations[owner].base + identifier->slot];
+}
+
+static bool optimizer_declared(TokenType keyword, ValueType *type) {
+    switch (keyword) {
+        case TOKEN_KW_INT:
+            *type = VALUE_INT;
+            return true;
+        case TOKEN_KW_FLOAT:
+            *type = VALUE_FLOAT;
+            return true;
+        case TOKEN_KW_CHAR:
+            *type = VALUE_CHAR;
+            return true;
+        case TOKEN_KW_BOOL:
+            *type = VALUE_BOOL;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Guarda value en slot si su tipo declarado lo representa sin cambiarlo: un
+// char o un bool en un int, y un entero de hasta 53 bits en un float.
+static bool optimizer_store(OptimizerSlot *slot, OptimizerValue value) {
+    ValueType declared = slot->declared;
+    if (declared != VALUE_UNKNOWN && value.type != declared) {
+        if (!optimizer_is_integer(value.type) || (declared != VALUE_INT && declared != VALUE_FLOAT)) {
+            return false;
+        }
+        if (declared == VALUE_FLOAT) {
+            if (value.integer > (INT64_C(1) << 53) || value.integer < -(INT64_C(1) << 53)) {
+                return false;
+            }
+            value.real = (double)value.integer;
+            value.integer = 0;
+        }
+        value.type = declared;
+    }
+    slot->value = value;
+    return true;
+}
+
+// Cada nodo evaluado gasta una unidad de combustible y un nivel de anidamiento,
+// que se devuelve con optimizer_leave.
+static bool optimizer_enter(Optimizer *optimizer) {
+    if (optimizer->fuel == 0 || optimizer->nesting == OPTIMIZER_MAX_NESTING) {
+        return false;
+    }
+    optimizer->fuel--;
+    optimizer->nesting++;
+    return true;
+}
+
+static bool optimizer_leave(Optimizer *optimizer, bool ok) {
+    optimizer->nesting--;
+    return ok;
+}
+
+// Abre una llamada desde parent con un marco de count huecos sin valor.
+static bool optimizer_activate(Optimizer *optimizer, uint32_t parent, uint32_t count, uint32_t *activation) {
+    if (optimizer->activation_count == optimizer->activation_capacity) {
+        size_t capacity = optimizer->activation_capacity ? optimizer->activation_capacity * 2 : 64;
+        OptimizerActivation *activations =
+            (OptimizerActivation *)realloc(optimizer->activations, capacity * sizeof(OptimizerActivation));
+        if (!activations) {
+            return false;
+        }
+        optimizer->activations = activations;
+        optimizer->activation_capacity = capacity;
+    }
+    if (optimizer->slot_capacity - optimizer->slot_count < count) {
+        size_t capacity = optimizer->slot_capacity * 2 + count;
+        OptimizerSlot *slots = (OptimizerSlot *)realloc(optimizer->slots, capacity * sizeof(OptimizerSlot));
+        if (!slots) {
+            return false;
+        }
+        optimizer->slots = slots;
+        optimizer->slot_capacity = capacity;
+    }
+    OptimizerActivation *opened = &optimizer->activations[optimizer->activation_count];
+    opened->parent = parent;
+    opened->base = optimizer->slot_count;
+    for (uint32_t i = 0; i < count; ++i) {
+        optimizer->slots[opened->base + i].value.type = VALUE_UNKNOWN;
+        optimizer->slots[opened->base + i].declared = VALUE_UNKNOWN;
+    }
+    optimizer->slot_count += count;
+    *activation = (uint32_t)optimizer->activation_count++;
+    return true;
+}
+
+static void optimizer_deactivate(Optimizer *optimizer, uint32_t activation) {
+    optimizer->slot_count = optimizer->activations[activation].base;
+    optimizer->activation_count = activation;
+}
+
+// Evalúa la llamada node desde activation; result es VALUE_VOID si la func
+// termina sin return.
+static bool optimizer_call(Optimizer *optimizer, uint32_t activation, const ASTNode *node, OptimizerValue *result) {
+    if (node->token.type == TOKEN_KW_CSAY || node->token.type == TOKEN_KW_CREAD || node->child_count < 2) {
+        return false;
+    }
+    const ASTNode *callee = node->children[0];
+    const ASTNode *args = node->children[1];
+    const ASTNode *function = optimizer_function(optimizer, callee);
+    // Hijos: nombre, parámetros, cuerpo y return opcional.
+    if (!function || function->children[1]->child_count != args->child_count) {
+        return false;
+    }
+    const ASTNode *params = function->children[1];
+    uint32_t callee_activation;
+    if (!optimizer_activate(optimizer, optimizer_outer(optimizer, activation, callee->depth), function->frame_size,
+                            &callee_activation)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < args->child_count; ++i) {
+        OptimizerValue value;
+        if (!optimizer_eval(optimizer, activation, args->children[i], &value)) {
+            return false;
+        }
+        OptimizerSlot *param = optimizer_variable(optimizer, callee_activation, params->children[i]);
+        if (!param) {
+            return false;
+        }
+        param->value = value;
+    }
+    bool returned = false;
+    if (!optimizer_run(optimizer, callee_activation, function->children[2], &returned, result)) {
+        return false;
+    }
+    if (!returned && function->child_count > 3 &&
+        !optimizer_execute(optimizer, callee_activation, function->children[3], &returned, result)) {
+        return false;
+    }
+    if (!returned) {
+        result->type = VALUE_VOID;
+    }
+    optimizer_deactivate(optimizer, callee_activation);
+    return true;
+}
+
+static bool optimizer_eval(Optimizer *optimizer, uint32_t activation, const ASTNode *node, OptimizerValue *value) {
+    if (!optimizer_enter(optimizer)) {
+        return false;
+    }
+    switch (node->type) {
+        case AST_LITERAL:
+            return optimizer_leave(optimizer, optimizer_value(optimizer, node, value));
+        case AST_IDENTIFIER: {
+            OptimizerSlot *slot = optimizer_variable(optimizer, activation, node);
+            if (!slot || slot->value.type == VALUE_UNKNOWN) {
+                return optimizer_leave(optimizer, false);
+            }
+            *value = slot->value;
+            return optimizer_leave(optimizer, true);
+        }
+        case AST_CALL:
+            return optimizer_leave(optimizer, optimizer_call(optimizer, activation, node, value) &&
+                                                  value->type != VALUE_VOID);
+        case AST_EXPRESSION:
+            break;
+        default:
+            return optimizer_leave(optimizer, false);
+    }
+    // ++ y -- cambian la variable: no se evalúan.
+    TokenType op = node->token.type;
+    OptimizerValue left;
+    OptimizerValue right;
+    if (node->child_count == 1) {
+        return optimizer_leave(optimizer, op != TOKEN_PLUSPLUS && op != TOKEN_MINUSMINUS &&
+                                              optimizer_eval(optimizer, activation, node->children[0], &left) &&
+                                              optimizer_unary(op, left, value));
+    }
+    if (node->child_count != 2 || !optimizer_eval(optimizer, activation, node->children[0], &left)) {
+        return optimizer_leave(optimizer, false);
+    }
+    if (op == TOKEN_ANDAND || op == TOKEN_OROR) {
+        bool decisive = op == TOKEN_OROR;
+        if (optimizer_truth(left) != decisive) {
+            if (!optimizer_eval(optimizer, activation, node->children[1], &right)) {
+                return optimizer_leave(optimizer, false);
+            }
+            decisive = optimizer_truth(right);
+        }
+        *value = optimizer_bool(decisive);
+        return optimizer_leave(optimizer, true);
+    }
+    return optimizer_leave(optimizer, optimizer_eval(optimizer, activation, node->children[1], &right) &&
+                                          optimizer_binary(op, left, right, value));
+}
+
+// Ejecuta la instrucción node en la llamada activation. Si es un return (o lo
+// tiene dentro), pone returned a true y deja su valor en result.
+static bool optimizer_execute(Optimizer *optimizer, uint32_t activation, const ASTNode *node, bool *returned,
+                              OptimizerValue *result) {
+    OptimizerValue value;
+    switch (node->type) {
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT: {
+            ValueType declared = VALUE_UNKNOWN;
+            if ((node->type == AST_DECLARATION && !optimizer_declared(node->token.type, &declared)) ||
+                !optimizer_eval(optimizer, activation, node->children[1], &value)) {
+                return false;
+            }
+            OptimizerSlot *slot = optimizer_variable(optimizer, activation, node->children[0]);
+            if (!slot) {
+                return false;
+            }
+            if (node->type == AST_DECLARATION) {
+                slot->declared = declared;
+            }
+            return optimizer_store(slot, value);
+        }
+        case AST_IF:
+        case AST_WHILE:
+            do {
+                if (!optimizer_eval(optimizer, activation, node->children[0], &value)) {
+                    return false;
+                }
+                if (!optimizer_truth(value)) {
+                    return true;
+                }
+                if (!optimizer_run(optimizer, activation, node->children[1], returned, result)) {
+                    return false;
+                }
+            } while (node->type == AST_WHILE && !*returned);
+            return true;
+        case AST_RETURN:
+            *returned = optimizer_eval(optimizer, activation, node->children[0], result);
+            return *returned;
+        case AST_EXPRESSION:
+            return optimizer_eval(optimizer, activation, node->children[0], &value);
+        case AST_CALL:
+            return optimizer_call(optimizer, activation, node, &value);
+        case AST_FUNCTION:
+        case AST_COMMENT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool optimizer_run(Optimizer *optimizer, uint32_t activation, const ASTNode *list, bool *returned,
+                          OptimizerValue *result) {
+    if (!optimizer_enter(optimizer)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < list->child_count && !*returned; ++i) {
+        if (!optimizer_execute(optimizer, activation, list->children[i], returned, result)) {
+            return optimizer_leave(optimizer, false);
+        }
+    }
+    return optimizer_leave(optimizer, true);
+}
+
+// Intenta evaluar la llamada de slot, ya optimizada, si todos sus argumentos
+// son constantes: si devuelve un valor, la convierte en ese literal. Devuelve
+// si lo que queda en slot tiene efectos.
+static bool optimizer_evaluate(Optimizer *optimizer, ASTNode **slot) {
+    ASTNode *node = *slot;
+    if (node->token.type == TOKEN_KW_CSAY || node->token.type == TOKEN_KW_CREAD || node->child_count < 2 ||
+        optimizer->budget == 0 || !optimizer_function(optimizer, node->children[0])) {
+        return true;
+    }
+    OptimizerValue value;
+    const ASTNode *args = node->children[1];
+    for (uint32_t i = 0; i < args->child_count; ++i) {
+        if (!optimizer_value(optimizer, args->children[i], &value)) {
+            return true;
+        }
+    }
+    size_t fuel = optimizer->budget < OPTIMIZER_CALL_FUEL ? optimizer->budget : OPTIMIZER_CALL_FUEL;
+    optimizer->fuel = fuel;
+    optimizer->nesting = 0;
+    optimizer->activation_count = 0;
+    optimizer->slot_count = 0;
+    bool evaluated = optimizer_call(optimizer, OPTIMIZER_OUTSIDE, node, &value);
+    optimizer->budget -= fuel - optimizer->fuel;
+    if (!evaluated) {
+        return true;
+    }
+    if (value.type != VALUE_VOID) {
+        optimizer_literal(node, value);
+    }
+    optimizer->summary.evaluated++;
+    return false;
+}
+
+// Las hojas se resuelven en el acto y suman sus efectos al marco de arriba; el
+// resto abre un marco.
+static bool optimizer_push(Optimizer *optimizer, ASTNode **slot, size_t base, bool *effects) {
+    ASTNode *node = *slot;
+    if (node->type == AST_LITERAL || node->type == AST_IDENTIFIER) {
+        bool leaf = node->type == AST_IDENTIFIER && !optimizer_is_concrete(node->value_type);
+        if (optimizer->frame_count > base) {
+            optimizer->frames[optimizer->frame_count - 1].effects |= leaf;
+        } else {
+            *effects = leaf;
+        }
+        return true;
+    }
+    if (optimizer->frame_count == optimizer->frame_capacity) {
+        size_t capacity = optimizer->frame_capacity ? optimizer->frame_capacity * 2 : 64;
+        OptimizerFrame *frames = (OptimizerFrame *)realloc(optimizer->frames, capacity * sizeof(OptimizerFrame));
+        if (!frames) {
+            return false;
+        }
+        optimizer->frames = frames;
+        optimizer->frame_capacity = capacity;
+    }
+    OptimizerFrame *frame = &optimizer->frames[optimizer->frame_count++];
+    frame->slot = slot;
+    frame->operands = NULL;
+    frame->next = 0;
+    frame->effects = false;
+    if (node->type == AST_EXPRESSION || node->type == AST_ARRAY_LITERAL) {
+        frame->operands = node;
+    } else if (node->type == AST_CALL) {
+        // csay y cread: argumentos y destino; las demás: nombre y argumentos.
+        uint32_t index = node->token.type == TOKEN_KW_CSAY || node->token.type == TOKEN_KW_CREAD ? 0 : 1;
+        frame->operands = index < node->child_count ? node->children[index] : NULL;
+    }
+    return true;
+}
+
+// Postorden con pila propia: cada nodo se optimiza cuando ya lo están sus
+// operandos. effects dice si lo que queda en root tiene efectos.
+static bool optimizer_expression(Optimizer *optimizer, ASTNode **root, bool *effects) {
+    size_t base = optimizer->frame_count;
+    if (!optimizer_push(optimizer, root, base, effects)) {
+        return false;
+    }
+    while (optimizer->frame_count > base) {
+        OptimizerFrame *frame = &optimizer->frames[optimizer->frame_count - 1];
+        if (frame->operands && frame->next < frame->operands->child_count) {
+            ASTNode **slot = &frame->operands->children[frame->next++];
+            if (*slot && !optimizer_push(optimizer, slot, base, effects)) {
+                return false;
+            }
+            continue;
+        }
+        OptimizerFrame finished = *frame;
+        optimizer->frame_count--;
+        ASTNode *node = *finished.slot;
+        bool node_effects;
+        if (node->type == AST_EXPRESSION) {
+            node_effects = optimizer_rewrite(optimizer, finished.slot, finished.effects);
+        } else if (node->type == AST_CALL) {
+            node_effects = optimizer_evaluate(optimizer, finished.slot);
+        } else {
+            node_effects = finished.effects || !optimizer_is_concrete(node->value_type);
+        }
+        if (optimizer->frame_count > base) {
+            optimizer->frames[optimizer->frame_count - 1].effects |= node_effects;
+        } else {
+            *effects = node_effects;
+        }
+    }
+    return true;
+}
+
+static bool optimizer_is_false(const Optimizer *optimizer, const ASTNode *condition) {
+    OptimizerValue value;
+    return optimizer_value(optimizer, condition, &value) && !optimizer_truth(value);
+}
+
+// Optimiza la instrucción de slot; dead dice si hay que quitarla de su lista.
+static bool optimizer_statement(Optimizer *optimizer, ASTNode **slot, bool *dead) {
+    ASTNode *node = *slot;
+    bool effects;
+    *dead = false;
+    switch (node->type) {
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+            return optimizer_expression(optimizer, &node->children[1], &effects);
+        case AST_IF:
+        case AST_WHILE:
+            if (!optimizer_expression(optimizer, &node->children[0], &effects)) {
+                return false;
+            }
+            *dead = optimizer_is_false(optimizer, node->children[0]);
+            return *dead || optimizer_statements(optimizer, node->children[1]);
+        case AST_FOR:
+            return optimizer_statements(optimizer, node->children[2]);
+        case AST_FUNCTION:
+            // Hijos: nombre, parámetros, cuerpo y return opcional.
+            return optimizer_statements(optimizer, node->children[2]) &&
+                   (node->child_count < 4 || optimizer_statement(optimizer, &node->children[3], dead));
+        case AST_RETURN:
+            return optimizer_expression(optimizer, &node->children[0], &effects);
+        case AST_EXPRESSION:
+            if (!optimizer_expression(optimizer, &node->children[0], &effects)) {
+                return false;
+            }
+            *dead = !effects;
+            return true;
+        case AST_CALL:
+            if (!optimizer_expression(optimizer, slot, &effects)) {
+                return false;
+            }
+            *dead = !effects;
+            return true;
+        default:
+            return true;
+    }
+}
+
+static bool optimizer_statements(Optimizer *optimizer, ASTNode *list) {
+    size_t base = optimizer->dead_count;
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        bool dead;
+        if (!optimizer_statement(optimizer, &list->children[i], &dead)) {
+            return false;
+        }
+        if (!dead) {
+            continue;
+        }
+        if (optimizer->dead_count == optimizer->dead_capacity) {
+            size_t capacity = optimizer->dead_capacity ? optimizer->dead_capacity * 2 : 64;
+            ASTNode **statements = (ASTNode **)realloc(optimizer->dead, capacity * sizeof(ASTNode *));
+            if (!statements) {
+                return false;
+            }
+            optimizer->dead = statements;
+            optimizer->dead_capacity = capacity;
+        }
+        optimizer->dead[optimizer->dead_count++] = list->children[i];
+    }
+    // Las muertas van en el mismo orden que en la lista.
+    size_t next = base;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        if (next < optimizer->dead_count && list->children[i] == optimizer->dead[next]) {
+            ast_free(list->children[i]);
+            next++;
+        } else {
+            list->children[kept++] = list->children[i];
+        }
+    }
+    list->child_count = kept;
+    optimizer->summary.pruned += next - base;
+    optimizer->dead_count = base;
+    return true;
+}
+
+// Apunta que la declaración de identifier es la func function, o que recibe
+// otra cosa si function es NULL.
+static bool optimizer_note(Optimizer *optimizer, const ASTNode *identifier, const ASTNode *function) {
+    if (!identifier || identifier->type != AST_IDENTIFIER || identifier->declaration == AST_NO_DECLARATION) {
+        return true;
+    }
+    uint32_t declaration = identifier->declaration;
+    if (declaration >= optimizer->declaration_capacity) {
+        size_t capacity = optimizer->declaration_capacity * 2 + declaration + 1;
+        const ASTNode **functions =
+            (const ASTNode **)realloc((void *)optimizer->functions, capacity * sizeof(const ASTNode *));
+        if (!functions) {
+            return false;
+        }
+        optimizer->functions = functions;
+        bool *redefined = (bool *)realloc(optimizer->redefined, capacity * sizeof(bool));
+        if (!redefined) {
+            return false;
+        }
+        optimizer->redefined = redefined;
+        for (size_t i = optimizer->declaration_capacity; i < capacity; ++i) {
+            optimizer->functions[i] = NULL;
+            optimizer->redefined[i] = false;
+        }
+        optimizer->declaration_capacity = capacity;
+    }
+    if (function && !optimizer->functions[declaration]) {
+        optimizer->functions[declaration] = function;
+    } else {
+        optimizer->redefined[declaration] = true;
+    }
+    return true;
+}
+
+// Apunta la func que declara node o las variables a las que escribe.
+static bool optimizer_scan(Optimizer *optimizer, const ASTNode *node) {
+    switch (node->type) {
+        case AST_FUNCTION:
+            return optimizer_note(optimizer, node->children[0], node);
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+        case AST_FOR:
+            return optimizer_note(optimizer, node->children[0], NULL);
+        case AST_PARAM_LIST:
+            for (uint32_t i = 0; i < node->child_count; ++i) {
+                if (!optimizer_note(optimizer, node->children[i], NULL)) {
+                    return false;
+                }
+            }
+            return true;
+        case AST_CALL:
+            return node->token.type != TOKEN_KW_CREAD || node->child_count < 2 ||
+                   optimizer_note(optimizer, node->children[1], NULL);
+        case AST_EXPRESSION:
+            return (node->token.type != TOKEN_PLUSPLUS && node->token.type != TOKEN_MINUSMINUS) ||
+                   node->child_count != 1 || optimizer_note(optimizer, node->children[0], NULL);
+        default:
+            return true;
+    }
+}
+
+// Nodos de root y sus descendientes, o 0 si no hubo memoria. Con scan, además
+// llena functions y redefined.
+static size_t optimizer_count(Optimizer *optimizer, ASTNode *root, bool scan) {
+    size_t count = 0;
+    size_t depth = 0;
+    if (optimizer->pending_capacity == 0) {
+        optimizer->pending = (ASTNode **)malloc(64 * sizeof(ASTNode *));
+        if (!optimizer->pending) {
+            return 0;
+        }
+        optimizer->pending_capacity = 64;
+    }
+    optimizer->pending[depth++] = root;
+    while (depth > 0) {
+        ASTNode *node = optimizer->pending[--depth];
+        count++;
+        if (scan && !optimizer_scan(optimizer, node)) {
+            return 0;
+        }
+        if (optimizer->pending_capacity - depth < node->child_count) {
+            size_t capacity = optimizer->pending_capacity * 2 + node->child_count;
+            ASTNode **pending = (ASTNode **)realloc(optimizer->pending, capacity * sizeof(ASTNode *));
+            if (!pending) {
+                return 0;
+            }
+            optimizer->pending = pending;
+            optimizer->pending_capacity = capacity;
+        }
+        for (uint32_t i = 0; i < node->child_count; ++i) {
+            if (node->children[i]) {
+                optimizer->pending[depth++] = node->children[i];
+            }
+        }
+    }
+    return count;
+}
+
+bool optimizer_optimize(Optimizer *optimizer, ASTNode *program, const char *source) {
+    memset(&optimizer->summary, 0, sizeof(optimizer->summary));
+    optimizer->source = source;
+    optimizer->frame_count = 0;
+    optimizer->dead_count = 0;
+    for (size_t i = 0; i < optimizer->declaration_capacity; ++i) {
+        optimizer->functions[i] = NULL;
+        optimizer->redefined[i] = false;
+    }
+    optimizer->summary.nodes = optimizer_count(optimizer, program, true);
+    if (optimizer->summary.nodes == 0) {
+        return false;
+    }
+    optimizer->budget = OPTIMIZER_FILE_FUEL + optimizer->summary.nodes * OPTIMIZER_FUEL_PER_NODE;
+    if (program->child_count > 0 && !optimizer_statements(optimizer, program->children[0])) {
+        return false;
+    }
+    size_t remaining = optimizer_count(optimizer, program, false);
+    if (remaining == 0) {
+        return false;
+    }
+    optimizer->summary.removed = optimizer->summary.nodes - remaining;
+    return true;
+}
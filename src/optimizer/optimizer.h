@@ -0,0 +1,105 @@
+#ifndef PYCLITE_OPTIMIZER_H
+#define PYCLITE_OPTIMIZER_H
+
+#include "ast/ast.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Plegado de constantes y simplificación algebraica sobre un árbol ya anotado
+// por la inferencia de tipos (types.h); es la última fase, porque los literales
+// que crea no tienen lexema.
+//
+// Las operaciones entre literales numéricos, char y bool se calculan como en C:
+// enteros de 64 bits que al dividir truncan hacia cero, y double en cuanto un
+// operando es float. Lo que en ejecución fallaría se deja tal cual: división o
+// resto entre cero, desbordamientos y reales no finitos. Entre cadenas solo se
+// pliegan == y != de literales sin secuencias de escape.
+//
+// Las identidades se aplican solo si los tipos garantizan el mismo valor: x + 0
+// y 0 + x con x int; x - 0, x * 1, 1 * x y x / 1 con x int o float (en float,
+// x + 0 convierte -0.0 en 0.0); !!b, true && b, b && true, false || b y
+// b || false con b bool. false && e y true || e se quedan en el literal; e &&
+// false y e || true, solo si e no tiene efectos.
+//
+// Una expresión no tiene efectos si no llama a nada, no usa ++, --, / ni % (que
+// pueden fallar) y todas sus partes tienen un tipo concreto. Las que van sueltas
+// como instrucción se eliminan, igual que los if y while cuya condición es una
+// constante falsa.
+//
+// Las llamadas a func cuyos argumentos son todos constantes se evalúan en
+// compilación con un intérprete de los enteros, reales, char y bool: la llamada
+// se convierte en el literal que devuelve, o desaparece si es una instrucción.
+// La evaluación se abandona, y la llamada se queda, si la func (o las que llama)
+// usa csay o cread, lee o escribe variables de fuera de las llamadas evaluadas,
+// usa ++, --, cadenas o arreglos, hace algo que fallaría al ejecutarse o agota
+// su combustible: OPTIMIZER_CALL_FUEL nodos por llamada y, entre todas,
+// OPTIMIZER_FILE_FUEL más OPTIMIZER_FUEL_PER_NODE por cada nodo del archivo,
+// para que -O siga siendo lineal.
+//
+// Cada plegado convierte la AST_EXPRESSION o la AST_CALL en un AST_LITERAL con
+// token.length 0 (el token sigue apuntando al operador o al paréntesis de la
+// llamada) y el valor en integer o real.
+
+typedef struct {
+    // Nodos del árbol antes de optimizar y cuántos de ellos ya no están.
+    size_t nodes;
+    size_t removed;
+    // Expresiones reducidas a un literal.
+    size_t folded;
+    // Llamadas a func evaluadas en compilación.
+    size_t evaluated;
+    // Identidades aplicadas.
+    size_t simplified;
+    // if, while y expresiones sueltas eliminados.
+    size_t pruned;
+} OptimizerSummary;
+
+typedef struct OptimizerFrame OptimizerFrame;
+typedef struct OptimizerActivation OptimizerActivation;
+typedef struct OptimizerSlot OptimizerSlot;
+
+typedef struct {
+    OptimizerSummary summary;
+
+    // Texto del archivo, para leer el valor de los literales.
+    const char *source;
+    // Recorrido iterativo de las expresiones, que pueden anidarse sin límite.
+    OptimizerFrame *frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    // Pila para contar los nodos del árbol.
+    ASTNode **pending;
+    size_t pending_capacity;
+    // Instrucciones muertas de las listas que se están recorriendo; se quitan
+    // al terminar cada lista, que así sigue entera si el intérprete la ejecuta.
+    ASTNode **dead;
+    size_t dead_count;
+    size_t dead_capacity;
+
+    // Por número de declaración, la func que declara; NULL si no es una func o
+    // si también se declara o se asigna otra cosa con ese número.
+    const ASTNode **functions;
+    bool *redefined;
+    size_t declaration_capacity;
+    // Llamadas en curso del intérprete y los huecos de sus marcos.
+    OptimizerActivation *activations;
+    size_t activation_count;
+    size_t activation_capacity;
+    OptimizerSlot *slots;
+    size_t slot_count;
+    size_t slot_capacity;
+    // Nodos que aún puede evaluar la llamada en curso y el archivo.
+    size_t fuel;
+    size_t budget;
+    size_t nesting;
+} Optimizer;
+
+void optimizer_init(Optimizer *optimizer);
+void optimizer_free(Optimizer *optimizer);
+// Optimiza program, ya anotado por types_infer, y deja el resumen en summary.
+// Los nodos que quedan fuera se liberan si no son de un arena. Devuelve false
+// si no hubo memoria; el árbol sigue siendo válido, pero summary no está completo.
+bool optimizer_optimize(Optimizer *optimizer, ASTNode *program, const char *source);
+
+#endif // PYCLITE_OPTIMIZER_H
@@ -0,0 +1,361 @@
+#include "incremental.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void document_error(ParserDocument *doc, Token token, const char *message) {
+    doc->had_error = true;
+    doc->error_token = token;
+    snprintf(doc->error_message, sizeof(doc->error_message), "%s", message);
+}
+
+static bool document_reserve(ParserDocument *doc, size_t length) {
+    if (length < doc->capacity) {
+        return true;
+    }
+    size_t capacity = doc->capacity ? doc->capacity : 4096;
+    while (capacity <= length) {
+        capacity *= 2;
+    }
+    char *source = (char *)realloc(doc->source, capacity);
+    if (!source) {
+        return false;
+    }
+    doc->source = source;
+    doc->capacity = capacity;
+    return true;
+}
+
+// Primer índice cuyo inicio es >= offset.
+static size_t find_start(const ParserDocument *doc, size_t offset) {
+    size_t low = 0;
+    size_t high = doc->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (doc->starts[mid] < offset) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void shift_offsets_recursive(ASTNode *node, int64_t shift) {
+    node->token.offset = (uint32_t)((int64_t)node->token.offset + shift);
+    for (size_t i = 0; i < node->child_count; ++i) {
+        shift_offsets_recursive(node->children[i], shift);
+    }
+}
+
+// Iterativo, como ast_free: una instrucción reutilizada puede anidar tanto
+// como admita el heap y se desplaza al pedir el árbol, fuera del parser.
+static void shift_offsets(ASTNode *node, int64_t shift) {
+    size_t capacity = 64;
+    size_t depth = 0;
+    ASTNode **stack = (ASTNode **)malloc(capacity * sizeof(ASTNode *));
+    if (!stack) {
+        shift_offsets_recursive(node, shift);
+        return;
+    }
+    stack[depth++] = node;
+    while (depth > 0) {
+        ASTNode *current = stack[--depth];
+        current->token.offset = (uint32_t)((int64_t)current->token.offset + shift);
+        for (size_t i = 0; i < current->child_count; ++i) {
+            if (depth == capacity) {
+                ASTNode **grown = (ASTNode **)realloc(stack, capacity * 2 * sizeof(ASTNode *));
+                if (!grown) {
+                    shift_offsets_recursive(current->children[i], shift);
+                    continue;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth++] = current->children[i];
+        }
+    }
+    free(stack);
+}
+
+typedef struct {
+    ASTNode **nodes;
+    uint32_t *starts;
+    size_t count;
+    size_t capacity;
+} FreshInstructions;
+
+static bool fresh_push(FreshInstructions *fresh, ASTNode *node, uint32_t start) {
+    if (fresh->count == fresh->capacity) {
+        size_t capacity = fresh->capacity ? fresh->capacity * 2 : 8;
+        ASTNode **nodes = (ASTNode **)realloc(fresh->nodes, capacity * sizeof(ASTNode *));
+        if (nodes) {
+            fresh->nodes = nodes;
+        }
+        uint32_t *starts = (uint32_t *)realloc(fresh->starts, capacity * sizeof(uint32_t));
+        if (starts) {
+            fresh->starts = starts;
+        }
+        if (!nodes || !starts) {
+            return false;
+        }
+        fresh->capacity = capacity;
+    }
+    fresh->nodes[fresh->count] = node;
+    fresh->starts[fresh->count] = start;
+    fresh->count++;
+    return true;
+}
+
+static void fresh_free(FreshInstructions *fresh, bool free_nodes) {
+    for (size_t i = 0; free_nodes && i < fresh->count; ++i) {
+        ast_free(fresh->nodes[i]);
+    }
+    free(fresh->nodes);
+    free(fresh->starts);
+}
+
+// Sustituye las instrucciones [first, resume) por las nuevas; las siguientes
+// se conservan con sus offsets desplazados delta.
+static bool document_splice(ParserDocument *doc, size_t first, size_t resume, FreshInstructions *fresh,
+                            int64_t delta, Token first_token) {
+    if (!doc->program) {
+        doc->program = ast_create(AST_PROGRAM, first_token);
+        ASTNode *list = ast_create(AST_INSTRUCTION_LIST, first_token);
+        if (!doc->program || !list) {
+            ast_free(doc->program);
+            ast_free(list);
+            doc->program = NULL;
+            return false;
+        }
+        ast_add_child(doc->program, list);
+    }
+    ASTNode *list = doc->program->children[0];
+    size_t kept = doc->count - resume;
+    size_t count = first + fresh->count + kept;
+    size_t capacity = count ? count : 1;
+    ASTNode **children = (ASTNode **)malloc(capacity * sizeof(ASTNode *));
+    uint32_t *starts = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    int64_t *shifts = (int64_t *)malloc(capacity * sizeof(int64_t));
+    if (!children || !starts || !shifts) {
+        free(children);
+        free(starts);
+        free(shifts);
+        return false;
+    }
+
+    if (first) {
+        memcpy(children, list->children, first * sizeof(ASTNode *));
+        memcpy(starts, doc->starts, first * sizeof(uint32_t));
+        memcpy(shifts, doc->shifts, first * sizeof(int64_t));
+    }
+    if (fresh->count) {
+        memcpy(children + first, fresh->nodes, fresh->count * sizeof(ASTNode *));
+        memcpy(starts + first, fresh->starts, fresh->count * sizeof(uint32_t));
+        memset(shifts + first, 0, fresh->count * sizeof(int64_t));
+    }
+    for (size_t i = 0; i < kept; ++i) {
+        size_t from = resume + i;
+        size_t to = first + fresh->count + i;
+        children[to] = list->children[from];
+        starts[to] = (uint32_t)((int64_t)doc->starts[from] + delta);
+        shifts[to] = doc->shifts[from] + delta;
+    }
+    for (size_t i = first; i < resume; ++i) {
+        ast_free(list->children[i]);
+    }
+
+    free(list->children);
+    free(doc->starts);
+    free(doc->shifts);
+    list->children = children;
+    list->child_count = (uint32_t)count;
+    list->child_capacity = (uint32_t)capacity;
+    doc->starts = starts;
+    doc->shifts = shifts;
+    doc->count = count;
+    if (first == 0) {
+        doc->program->token = first_token;
+        list->token = first_token;
+    }
+    return true;
+}
+
+static bool document_reparse(ParserDocument *doc) {
+    int64_t delta = (int64_t)doc->dirty_new_end - (int64_t)doc->dirty_old_end;
+    // Se repite también la instrucción anterior a la zona cambiada: una
+    // edición pegada a su final puede alterar su último token.
+    size_t first = find_start(doc, doc->dirty_begin);
+    first = first ? first - 1 : 0;
+    size_t begin = first ? doc->starts[first] : 0;
+
+    Parser parser;
+    parser_init_range(&parser, doc->source, begin, doc->length);
+    parser_set_symbols(&parser, &doc->symbols);
+    parser_set_arena(&parser, false);
+    Token first_token = parser.current;
+    FreshInstructions fresh = {NULL, NULL, 0, 0};
+    size_t resume = doc->count;
+    bool ok = true;
+    while (parser.current.type != TOKEN_EOF) {
+        Token start = parser.current;
+        // Pasada la zona cambiada, el texto es idéntico al anterior: si aquí
+        // empezaba una instrucción, lo que sigue se puede reutilizar tal cual.
+        if (start.offset >= doc->dirty_new_end) {
+            size_t old = (size_t)((int64_t)start.offset - delta);
+            size_t index = find_start(doc, old);
+            if (index < doc->count && doc->starts[index] == old) {
+                resume = index;
+                break;
+            }
+        }
+        ASTNode *instr = parser_parse_instruction(&parser);
+        if (!instr) {
+            if (parser_has_error(&parser)) {
+                document_error(doc, parser_error_token(&parser), parser_error_message(&parser));
+            } else {
+                document_error(doc, start, "Memoria insuficiente para el AST.");
+            }
+            ok = false;
+            break;
+        }
+        if (!fresh_push(&fresh, instr, start.offset)) {
+            ast_free(instr);
+            document_error(doc, start, "Memoria insuficiente para el AST.");
+            ok = false;
+            break;
+        }
+    }
+    doc->reparsed = fresh.count;
+    parser_free(&parser);
+
+    if (ok && !document_splice(doc, first, resume, &fresh, delta, first_token)) {
+        document_error(doc, first_token, "Memoria insuficiente para el AST.");
+        ok = false;
+    }
+    fresh_free(&fresh, !ok);
+    if (ok) {
+        doc->dirty = false;
+        doc->had_error = false;
+        doc->error_message[0] = '\0';
+    }
+    return ok;
+}
+
+bool parser_document_init(ParserDocument *doc, const char *source, size_t length) {
+    doc->source = NULL;
+    doc->length = 0;
+    doc->capacity = 0;
+    doc->program = NULL;
+    doc->starts = NULL;
+    doc->shifts = NULL;
+    doc->count = 0;
+    intern_init(&doc->symbols);
+    doc->dirty = false;
+    doc->dirty_begin = 0;
+    doc->dirty_old_end = 0;
+    doc->dirty_new_end = 0;
+    doc->had_error = false;
+    doc->error_message[0] = '\0';
+    doc->error_token = (Token){TOKEN_EOF, 0, 0, 0};
+    doc->reparsed = 0;
+    return parser_document_edit(doc, 0, 0, source, length);
+}
+
+bool parser_document_edit(ParserDocument *doc, size_t offset, size_t removed, const char *text,
+                          size_t text_length) {
+    if (offset > doc->length) {
+        offset = doc->length;
+    }
+    if (removed > doc->length - offset) {
+        removed = doc->length - offset;
+    }
+    size_t length = doc->length - removed + text_length;
+    Token at = {TOKEN_EOF, (uint32_t)offset, 0, 0};
+    if (length > LEXER_MAX_SOURCE_LENGTH) {
+        document_error(doc, at, "El documento supera el tamaño máximo.");
+        return false;
+    }
+    if (!document_reserve(doc, length)) {
+        document_error(doc, at, "Memoria insuficiente para el documento.");
+        return false;
+    }
+    size_t edit_end = offset + removed;
+    memmove(doc->source + offset + text_length, doc->source + edit_end, doc->length - edit_end);
+    if (text_length) {
+        memcpy(doc->source + offset, text, text_length);
+    }
+    doc->source[length] = '\0';
+
+    // Une la edición con la zona aún pendiente de un parseo fallido; todo se
+    // calcula en coordenadas del texto anterior a esta edición.
+    size_t end = edit_end;
+    if (doc->dirty) {
+        if (doc->dirty_begin < offset) {
+            offset = doc->dirty_begin;
+        }
+        if (end < doc->dirty_new_end) {
+            end = doc->dirty_new_end;
+        }
+        doc->dirty_old_end += end - doc->dirty_new_end;
+    } else {
+        doc->dirty_old_end = end;
+    }
+    doc->dirty = true;
+    doc->dirty_begin = offset;
+    doc->dirty_new_end = end + text_length - removed;
+    doc->length = length;
+    return document_reparse(doc);
+}
+
+ASTNode *parser_document_instruction(ParserDocument *doc, size_t index) {
+    if (doc->had_error || !doc->program || index >= doc->count) {
+        return NULL;
+    }
+    ASTNode *instr = doc->program->children[0]->children[index];
+    if (doc->shifts[index]) {
+        shift_offsets(instr, doc->shifts[index]);
+        doc->shifts[index] = 0;
+    }
+    return instr;
+}
+
+ASTNode *parser_document_program(ParserDocument *doc) {
+    if (doc->had_error || !doc->program) {
+        return NULL;
+    }
+    for (size_t i = 0; i < doc->count; ++i) {
+        parser_document_instruction(doc, i);
+    }
+    return doc->program;
+}
+
+bool parser_document_has_error(const ParserDocument *doc) {
+    return doc->had_error;
+}
+
+const char *parser_document_error_message(const ParserDocument *doc) {
+    return doc->error_message;
+}
+
+SourceLocation parser_document_error_location(const ParserDocument *doc) {
+    Lexer lexer;
+    lexer_init(&lexer, doc->source, doc->length);
+    SourceLocation location = lexer_location(&lexer, doc->error_token.offset);
+    lexer_free(&lexer);
+    return location;
+}
+
+void parser_document_free(ParserDocument *doc) {
+    ast_free(doc->program);
+    free(doc->starts);
+    free(doc->shifts);
+    free(doc->source);
+    intern_free(&doc->symbols);
+    doc->program = NULL;
+    doc->starts = NULL;
+    doc->shifts = NULL;
+    doc->source = NULL;
+    doc->count = 0;
+}
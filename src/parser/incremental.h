@@ -0,0 +1,65 @@
+#ifndef PYCLITE_INCREMENTAL_H
+#define PYCLITE_INCREMENTAL_H
+
+#include "parser/parser.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Documento editable que conserva su AST entre ediciones. Cada edición vuelve
+// a analizar solo las instrucciones de nivel superior que toca y, en cuanto el
+// parser llega al inicio de una instrucción anterior que quedó intacta, reusa
+// el resto del árbol desplazando sus offsets.
+typedef struct {
+    char *source;
+    size_t length;
+    size_t capacity;
+
+    // AST en memoria dinámica (sin arena) del último parseo correcto. Por cada
+    // instrucción de nivel superior se guarda el offset de su primer token y
+    // cuánto hay que sumar a los offsets de su subárbol: esa corrección se
+    // aplica al pedir el árbol, no en cada edición.
+    ASTNode *program;
+    uint32_t *starts;
+    int64_t *shifts;
+    size_t count;
+    // Compartida por todos los reanálisis, para que los símbolos de las
+    // instrucciones reutilizadas sigan valiendo junto a los de las nuevas.
+    InternTable symbols;
+
+    // Zona cambiada desde el último parseo correcto: [dirty_begin,
+    // dirty_old_end) del texto de entonces es ahora [dirty_begin,
+    // dirty_new_end). Las ediciones que dejan errores se acumulan aquí.
+    bool dirty;
+    size_t dirty_begin;
+    size_t dirty_old_end;
+    size_t dirty_new_end;
+
+    bool had_error;
+    char error_message[256];
+    Token error_token;
+    // Instrucciones de nivel superior analizadas de nuevo en la última edición.
+    size_t reparsed;
+} ParserDocument;
+
+// Copia source y lo analiza entero. Devuelve true si no hay errores; en
+// cualquier caso el documento queda listo para editarse y debe liberarse.
+bool parser_document_init(ParserDocument *doc, const char *source, size_t length);
+// Sustituye removed bytes a partir de offset por text[0, text_length) y
+// actualiza el AST. Devuelve true si el documento resultante no tiene errores;
+// los diagnósticos son los mismos que daría un parseo completo del texto.
+bool parser_document_edit(ParserDocument *doc, size_t offset, size_t removed, const char *text,
+                          size_t text_length);
+// Árbol del texto actual con todos los offsets al día, o NULL si hay errores.
+// Pertenece al documento.
+ASTNode *parser_document_program(ParserDocument *doc);
+// Instrucción de nivel superior index con sus offsets al día; solo corrige ese
+// subárbol, para quien no necesita el árbol entero tras cada edición.
+ASTNode *parser_document_instruction(ParserDocument *doc, size_t index);
+bool parser_document_has_error(const ParserDocument *doc);
+const char *parser_document_error_message(const ParserDocument *doc);
+SourceLocation parser_document_error_location(const ParserDocument *doc);
+void parser_document_free(ParserDocument *doc);
+
+#endif // PYCLITE_INCREMENTAL_H
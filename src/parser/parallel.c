@@ -0,0 +1,287 @@
+#include "parallel.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// Bytes que el pre-escaneo tiene que mirar; el resto se salta sin más.
+static const bool SPLIT_INTERESTING[256] = {
+    ['{'] = true, ['}'] = true, ['"'] = true, ['\''] = true,
+    ['/'] = true, ['$'] = true, ['%'] = true, ['f'] = true,
+};
+
+static size_t find_pair(const char *source, size_t from, size_t end, char first, char second) {
+    while (from + 1 < end) {
+        const char *hit = (const char *)memchr(source + from, first, end - from - 1);
+        if (!hit) {
+            break;
+        }
+        from = (size_t)(hit - source);
+        if (source[from + 1] == second) {
+            return from + 2;
+        }
+        ++from;
+    }
+    return end;
+}
+
+static size_t skip_line(const char *source, size_t i, size_t end) {
+    const char *newline = (const char *)memchr(source + i, '\n', end - i);
+    return newline ? (size_t)(newline - source) + 1 : end;
+}
+
+static size_t skip_string(const char *source, size_t i, size_t end, char quote) {
+    while (i < end && source[i] != '\0') {
+        if (source[i] == quote) {
+            return i + 1;
+        }
+        if (source[i] == '\\' && i + 1 < end && source[i + 1] != '\0') {
+            ++i;
+        }
+        ++i;
+    }
+    return i;
+}
+
+// Replica las reglas del lexer para comentarios y cadenas, de modo que todo
+// offset devuelto es el inicio de un token `func` real: fuera de ellos, una
+// `f` precedida y seguida de caracteres que no son de identificador empieza
+// un token. Si aun así un corte cae a mitad de una instrucción, la región
+// anterior termina con un error y parser_parse_parallel recurre al parseo en
+// serie.
+size_t parser_find_splits(const char *source, size_t begin, size_t end, size_t *splits, size_t max_splits) {
+    size_t found = 0;
+    size_t step = (end - begin) / (max_splits + 1);
+    size_t target = begin + step;
+    long depth = 0;
+    size_t i = begin;
+    while (found < max_splits) {
+        while (i < end && !SPLIT_INTERESTING[(unsigned char)source[i]]) {
+            ++i;
+        }
+        if (i >= end) {
+            break;
+        }
+        char c = source[i];
+        char next = i + 1 < end ? source[i + 1] : '\0';
+        switch (c) {
+            case '{':
+                ++depth;
+                ++i;
+                break;
+            case '}':
+                --depth;
+                ++i;
+                break;
+            case '"':
+            case '\'':
+                i = skip_string(source, i + 1, end, c);
+                break;
+            case '$':
+                i = skip_line(source, i, end);
+                break;
+            case '/':
+                if (next == '/') {
+                    i = skip_line(source, i, end);
+                } else if (next == '*') {
+                    i = find_pair(source, i + 2, end, '*', '/');
+                } else {
+                    ++i;
+                }
+                break;
+            case '%':
+                i = next == '%' ? find_pair(source, i + 2, end, '%', '%') : i + 1;
+                break;
+            default:
+                if (depth == 0 && i >= target && end - i >= 4 && memcmp(source + i, "func", 4) == 0 &&
+                    (i == begin || !is_word_char(source[i - 1])) &&
+                    (end - i == 4 || !is_word_char(source[i + 4]))) {
+                    splits[found++] = i;
+                    target = begin + step * (found + 1);
+                }
+                ++i;
+                break;
+        }
+    }
+    return found;
+}
+
+struct ParseRegion {
+    Parser parser;
+    const char *source;
+    size_t begin;
+    size_t end;
+    bool use_arena;
+    ASTNode *program;
+};
+
+static void *parse_region(void *arg) {
+    ParseRegion *region = (ParseRegion *)arg;
+    parser_init_range(&region->parser, region->source, region->begin, region->end);
+    parser_set_arena(&region->parser, region->use_arena);
+    region->program = parser_parse(&region->parser);
+    return NULL;
+}
+
+// Cada región interna en su propia tabla. Pasar sus nombres a la del parser
+// en orden de región da los mismos símbolos que el parseo en serie, porque
+// este también los numera por orden de primera aparición; luego se reescriben
+// los tokens de la región con esa correspondencia.
+static bool region_merge_symbols(Parser *parser, ParseRegion *region) {
+    const InternTable *local = &region->parser.own_symbols;
+    size_t count = intern_count(local);
+    uint32_t *remap = (uint32_t *)malloc((count + 1) * sizeof(uint32_t));
+    if (!remap) {
+        return false;
+    }
+    remap[0] = 0;
+    bool identity = true;
+    for (uint32_t symbol = 1; symbol <= count; ++symbol) {
+        size_t length;
+        const char *name = intern_name(local, symbol, &length);
+        remap[symbol] = intern_symbol(parser->symbols, name, length);
+        if (remap[symbol] == 0) {
+            free(remap);
+            return false;
+        }
+        identity = identity && remap[symbol] == symbol;
+    }
+    bool ok = true;
+    if (!identity) {
+        size_t capacity = 64;
+        size_t depth = 0;
+        ASTNode **stack = (ASTNode **)malloc(capacity * sizeof(ASTNode *));
+        ok = stack != NULL;
+        if (ok) {
+            stack[depth++] = region->program;
+        }
+        while (ok && depth > 0) {
+            ASTNode *node = stack[--depth];
+            node->token.symbol = remap[node->token.symbol];
+            if (depth + node->child_count > capacity) {
+                while (depth + node->child_count > capacity) {
+                    capacity *= 2;
+                }
+                ASTNode **grown = (ASTNode **)realloc(stack, capacity * sizeof(ASTNode *));
+                if (!grown) {
+                    ok = false;
+                    break;
+                }
+                stack = grown;
+            }
+            for (size_t i = 0; i < node->child_count; ++i) {
+                if (node->children[i]) {
+                    stack[depth++] = node->children[i];
+                }
+            }
+        }
+        free(stack);
+        region->parser.current.symbol = remap[region->parser.current.symbol];
+        region->parser.next.symbol = remap[region->parser.next.symbol];
+    }
+    free(remap);
+    return ok;
+}
+
+ASTNode *parser_parse_parallel(Parser *parser) {
+    if (parser->threads < 2 || parser->min_region_size == 0 || parser->tokens || parser->ring || parser->had_error || parser->regions) {
+        return NULL;
+    }
+    const char *source = parser->lexer.source;
+    size_t begin = parser->current.offset;
+    size_t end = parser->lexer.length;
+    size_t regions = parser->threads;
+    if ((end - begin) / parser->min_region_size < regions) {
+        regions = (end - begin) / parser->min_region_size;
+    }
+    if (regions < 2) {
+        return NULL;
+    }
+
+    size_t *splits = (size_t *)malloc((regions - 1) * sizeof(size_t));
+    if (!splits) {
+        return NULL;
+    }
+    regions = parser_find_splits(source, begin, end, splits, regions - 1) + 1;
+    ParseRegion *parts = regions > 1 ? (ParseRegion *)calloc(regions, sizeof(ParseRegion)) : NULL;
+    pthread_t *threads = parts ? (pthread_t *)malloc(regions * sizeof(pthread_t)) : NULL;
+    bool *started = threads ? (bool *)calloc(regions, sizeof(bool)) : NULL;
+    if (!started) {
+        free(splits);
+        free(parts);
+        free(threads);
+        return NULL;
+    }
+    for (size_t i = 0; i < regions; ++i) {
+        parts[i].source = source;
+        parts[i].begin = i == 0 ? begin : splits[i - 1];
+        parts[i].end = i + 1 == regions ? end : splits[i];
+        parts[i].use_arena = parser->use_arena;
+    }
+    free(splits);
+
+    for (size_t i = 1; i < regions; ++i) {
+        started[i] = pthread_create(&threads[i], NULL, parse_region, &parts[i]) == 0;
+    }
+    parse_region(&parts[0]);
+    for (size_t i = 1; i < regions; ++i) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            parse_region(&parts[i]);
+        }
+    }
+    free(threads);
+    free(started);
+
+    bool ok = true;
+    for (size_t i = 0; i < regions; ++i) {
+        ok = ok && parts[i].program && !parser_has_error(&parts[i].parser);
+    }
+    for (size_t i = 0; ok && i < regions; ++i) {
+        ok = region_merge_symbols(parser, &parts[i]);
+    }
+    ASTNode *program = NULL;
+    if (ok) {
+        // El AST_PROGRAM y la lista de la primera región son los mismos nodos
+        // que crearía el parseo en serie; el resto de regiones aportan sus hijos.
+        program = parts[0].program;
+        ASTNode *list = program->children[0];
+        for (size_t i = 1; i < regions; ++i) {
+            ASTNode *part = parts[i].program->children[0];
+            for (size_t c = 0; c < part->child_count; ++c) {
+                ast_add_child(list, part->children[c]);
+            }
+            part->child_count = 0;
+            ast_free(parts[i].program);
+        }
+        parser->current = parts[regions - 1].parser.current;
+        parser->next = parts[regions - 1].parser.next;
+        parser->lexer.position = end;
+    } else {
+        for (size_t i = 0; i < regions; ++i) {
+            ast_free(parts[i].program);
+        }
+    }
+    parser->regions = parts;
+    parser->region_count = regions;
+    if (!program || !parser->use_arena) {
+        parser_free_regions(parser);
+    }
+    return program;
+}
+
+void parser_free_regions(Parser *parser) {
+    for (size_t i = 0; i < parser->region_count; ++i) {
+        parser_free(&parser->regions[i].parser);
+    }
+    free(parser->regions);
+    parser->regions = NULL;
+    parser->region_count = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef PYCLITE_PARALLEL_H
+#define PYCLITE_PARALLEL_H
+
+#include "parser/parser.h"
+
+#include <stddef.h>
+
+// Busca hasta max_splits puntos de corte en [begin, end): cada uno es el
+// offset de un `func` de nivel superior (profundidad de llaves 0, fuera de
+// cadenas y comentarios), el primero tras cada fracción 1/(max_splits+1)
+// del rango. Devuelve cuántos encontró, en orden creciente.
+size_t parser_find_splits(const char *source, size_t begin, size_t end, size_t *splits, size_t max_splits);
+
+// Parsea el resto del programa en parser->threads hilos, uno por región, y
+// une las instrucciones en orden. Devuelve NULL si no merece la pena dividir
+// o si alguna región falla; el parser queda intacto y el llamante debe hacer
+// el parseo en serie, que es el que produce los diagnósticos.
+ASTNode *parser_parse_parallel(Parser *parser);
+void parser_free_regions(Parser *parser);
+
+#endif // PYCLITE_PARALLEL_H
@@ -1,5 +1,7 @@
 #include "parser.h"
 
+#include "parallel.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,35 +25,205 @@ static ASTNode *parse_expression_statement(Parser *parser);
 static ASTNode *parse_array_literal(Parser *parser);
 
 static void parser_error(Parser *parser, Token token, const char *message) {
-    if (parser->had_error) {
+    if (parser->panic_mode) {
         return;
     }
-    parser->had_error = true;
-    parser->error_token = token;
-    snprintf(parser->error_message, sizeof(parser->error_message), "%s", message);
+    parser->panic_mode = true;
+    if (!parser->had_error) {
+        parser->had_error = true;
+        parser->error_token = token;
+        snprintf(parser->error_message, sizeof(parser->error_message), "%s", message);
+        parser->error_count = 1;
+        return;
+    }
+    if (parser->error_count - 1 == parser->error_capacity) {
+        size_t capacity = parser->error_capacity ? parser->error_capacity * 2 : 8;
+        ParserDiagnostic *errors = (ParserDiagnostic *)realloc(parser->errors, capacity * sizeof(ParserDiagnostic));
+        if (!errors) {
+            // Sin memoria para más diagnósticos, la recuperación termina aquí.
+            parser->max_errors = parser->error_count;
+            return;
+        }
+        parser->errors = errors;
+        parser->error_capacity = capacity;
+    }
+    parser->errors[parser->error_count - 1] = (ParserDiagnostic){token, message};
+    parser->error_count++;
+}
+
+// Asigna su símbolo a un identificador recién leído.
+static void parser_intern(Parser *parser, Token *token) {
+    if (token->type != TOKEN_IDENTIFIER) {
+        return;
+    }
+    token->symbol = intern_symbol(parser->symbols, parser->lexer.source + token->offset, token->length);
+    if (token->symbol == 0) {
+        parser_error(parser, *token, "Memoria insuficiente para los símbolos.");
+    }
+}
+
+static void parser_init_state(Parser *parser) {
+    parser->had_error = false;
+    parser->error_message[0] = '\0';
+    parser->error_token = parser->current;
+    parser->panic_mode = false;
+    parser->errors = NULL;
+    parser->error_count = 0;
+    parser->error_capacity = 0;
+    parser->max_errors = 1;
+    ast_arena_init(&parser->arena);
+    parser->use_arena = true;
+    parser->threads = 1;
+    parser->min_region_size = 0;
+    parser->regions = NULL;
+    parser->region_count = 0;
+    parser->expr_frames = NULL;
+    parser->expr_frame_capacity = 0;
+    parser->expr_operands = NULL;
+    parser->expr_operand_capacity = 0;
+    intern_init(&parser->own_symbols);
+    parser->symbols = &parser->own_symbols;
+    parser_intern(parser, &parser->current);
+    parser_intern(parser, &parser->next);
 }
 
 void parser_init(Parser *parser, const char *source, size_t length) {
     lexer_init(&parser->lexer, source, length);
+    parser->tokens = NULL;
+    parser->next_index = 0;
+    parser->ring = NULL;
     parser->current = lexer_next_token(&parser->lexer);
     parser->next = lexer_next_token(&parser->lexer);
-    parser->had_error = false;
-    parser->error_message[0] = '\0';
-    parser->error_token = parser->current;
+    parser_init_state(parser);
+}
+
+bool parser_init_pipelined(Parser *parser, const char *source, size_t length) {
+    // El lexer propio solo se usa para traducir offsets a línea y columna.
+    lexer_init(&parser->lexer, source, length);
+    parser->tokens = NULL;
+    parser->next_index = 0;
+    parser->ring = token_ring_start(source, length);
+    if (!parser->ring) {
+        lexer_free(&parser->lexer);
+        return false;
+    }
+    parser->current = token_ring_next(parser->ring);
+    parser->next = token_ring_next(parser->ring);
+    parser_init_state(parser);
+    return true;
+}
+
+void parser_init_range(Parser *parser, const char *source, size_t begin, size_t end) {
+    lexer_init_range(&parser->lexer, source, begin, end);
+    parser->tokens = NULL;
+    parser->next_index = 0;
+    parser->ring = NULL;
+    parser->current = lexer_next_token(&parser->lexer);
+    parser->next = lexer_next_token(&parser->lexer);
+    parser_init_state(parser);
+}
+
+static Token parser_buffered_token(const Parser *parser, size_t index) {
+    const TokenBuffer *tokens = parser->tokens;
+    return tokens->tokens[index < tokens->count ? index : tokens->count - 1];
+}
+
+void parser_init_tokens(Parser *parser, const char *source, size_t length, const TokenBuffer *tokens) {
+    lexer_init(&parser->lexer, source, length);
+    parser->tokens = tokens;
+    parser->next_index = 1;
+    parser->ring = NULL;
+    parser->current = parser_buffered_token(parser, 0);
+    parser->next = parser_buffered_token(parser, 1);
+    parser_init_state(parser);
+}
+
+void parser_set_arena(Parser *parser, bool enabled) {
+    parser->use_arena = enabled;
+}
+
+void parser_set_threads(Parser *parser, size_t threads, size_t min_region_size) {
+    parser->threads = threads;
+    parser->min_region_size = min_region_size;
+}
+
+void parser_set_max_errors(Parser *parser, size_t max_errors) {
+    parser->max_errors = max_errors;
+}
+
+void parser_set_symbols(Parser *parser, InternTable *table) {
+    parser->symbols = table;
+    parser_intern(parser, &parser->current);
+    parser_intern(parser, &parser->next);
+}
+
+const InternTable *parser_symbols(const Parser *parser) {
+    return parser->symbols;
+}
+
+void parser_free(Parser *parser) {
+    parser_free_regions(parser);
+    token_ring_free(parser->ring);
+    parser->ring = NULL;
+    free(parser->expr_frames);
+    free(parser->expr_operands);
+    parser->expr_frames = NULL;
+    parser->expr_operands = NULL;
+    free(parser->errors);
+    parser->errors = NULL;
+    parser->error_capacity = 0;
+    intern_free(&parser->own_symbols);
+    parser->symbols = &parser->own_symbols;
+    ast_arena_free(&parser->arena);
+    lexer_free(&parser->lexer);
+}
+
+static ASTNode *parser_node(Parser *parser, ASTNodeType type, Token token) {
+    if (parser->use_arena) {
+        return ast_arena_create(&parser->arena, type, token);
+    }
+    return ast_create(type, token);
 }
 
 static void parser_advance(Parser *parser) {
     parser->current = parser->next;
-    parser->next = lexer_next_token(&parser->lexer);
+    if (parser->tokens) {
+        parser->next = parser_buffered_token(parser, ++parser->next_index);
+    } else if (parser->ring) {
+        parser->next = token_ring_next(parser->ring);
+    } else {
+        parser->next = lexer_next_token(&parser->lexer);
+    }
+    parser_intern(parser, &parser->next);
+}
+
+Token parser_peek(const Parser *parser, size_t distance) {
+    if (distance == 0) {
+        return parser->current;
+    }
+    if (parser->tokens) {
+        return parser_buffered_token(parser, parser->next_index + distance - 1);
+    }
+    // El anillo empieza en el token que sigue a next.
+    if (parser->ring) {
+        return distance == 1 ? parser->next : token_ring_peek(parser->ring, distance - 2);
+    }
+    Lexer lookahead = parser->lexer;
+    Token token = parser->next;
+    for (size_t i = 1; i < distance && token.type != TOKEN_EOF; ++i) {
+        token = lexer_next_token(&lookahead);
+    }
+    return token;
 }
 
 static bool parser_check(const Parser *parser, TokenType type) {
     return parser->current.type == type;
 }
 
+// En modo pánico no avanza: la sincronización parte del punto del error.
 static Token parser_consume(Parser *parser, TokenType type, const char *message) {
     Token token = parser->current;
-    if (parser->current.type == type) {
+    if (parser->current.type == type && !parser->panic_mode) {
         parser_advance(parser);
         return token;
     }
@@ -67,16 +239,84 @@ static bool parser_match(Parser *parser, TokenType type) {
     return false;
 }
 
+// Tras el error de una instrucción que empezaba en start, salta hasta un punto
+// desde el que pueda empezar otra: pasado un ';', ante la palabra clave de una
+// instrucción o ante un '}' (que se consume fuera de los bloques, donde no
+// cierra nada). Los bloques que se abran mientras tanto se saltan enteros,
+// porque son el cuerpo de la instrucción que falló. Si esta no llegó a
+// consumir ningún token, se salta al menos uno para no volver a fallar en el
+// mismo sitio. Devuelve false si ya no quedan errores por reunir y el análisis
+// debe detenerse.
+static bool parser_synchronize(Parser *parser, size_t start, bool stop_on_rbrace) {
+    if (parser->max_errors != 0 && parser->error_count >= parser->max_errors) {
+        return false;
+    }
+    if (parser->current.offset == start && !parser_check(parser, TOKEN_EOF)) {
+        parser_advance(parser);
+    }
+    size_t depth = 0;
+    bool synchronized = false;
+    while (!synchronized && !parser_check(parser, TOKEN_EOF)) {
+        switch (parser->current.type) {
+            case TOKEN_LBRACE:
+                depth++;
+                parser_advance(parser);
+                break;
+            case TOKEN_RBRACE:
+                if (depth > 0) {
+                    synchronized = --depth == 0;
+                    parser_advance(parser);
+                } else {
+                    if (!stop_on_rbrace) {
+                        parser_advance(parser);
+                    }
+                    synchronized = true;
+                }
+                break;
+            case TOKEN_SEMICOLON:
+                parser_advance(parser);
+                synchronized = depth == 0;
+                break;
+            case TOKEN_KW_INT:
+            case TOKEN_KW_FLOAT:
+            case TOKEN_KW_CHAR:
+            case TOKEN_KW_BOOL:
+            case TOKEN_KW_ARRAY:
+            case TOKEN_KW_IF:
+            case TOKEN_KW_FOR:
+            case TOKEN_KW_WHILE:
+            case TOKEN_KW_FUNC:
+            case TOKEN_KW_RETURN:
+            case TOKEN_KW_CSAY:
+            case TOKEN_KW_CREAD:
+                synchronized = depth == 0;
+                if (!synchronized) {
+                    parser_advance(parser);
+                }
+                break;
+            default:
+                parser_advance(parser);
+                break;
+        }
+    }
+    parser->panic_mode = false;
+    return true;
+}
+
 static ASTNode *parse_identifier_node(Parser *parser) {
     Token token = parser_consume(parser, TOKEN_IDENTIFIER, "Se esperaba un identificador.");
-    if (parser->had_error) {
+    if (parser->panic_mode) {
         return NULL;
     }
-    return ast_create(AST_IDENTIFIER, token);
+    return parser_node(parser, AST_IDENTIFIER, token);
 }
 
 ASTNode *parser_parse(Parser *parser) {
-    ASTNode *program = ast_create(AST_PROGRAM, parser->current);
+    ASTNode *parallel = parser_parse_parallel(parser);
+    if (parallel) {
+        return parallel;
+    }
+    ASTNode *program = parser_node(parser, AST_PROGRAM, parser->current);
     ASTNode *instructions = parse_instruction_list(parser, false);
     if (!instructions) {
         ast_free(program);
@@ -85,10 +325,78 @@ ASTNode *parser_parse(Parser *parser) {
     ast_add_child(program, instructions);
     if (!parser->had_error && parser->current.type != TOKEN_EOF) {
         parser_error(parser, parser->current, "Fin inesperado del programa.");
+    }
+    if (parser->had_error) {
         ast_free(program);
         return NULL;
     }
-    return parser->had_error ? NULL : program;
+    return program;
+}
+
+bool parser_parse_streaming(Parser *parser, ParserInstructionFn callback, void *ctx) {
+    while (!parser_check(parser, TOKEN_EOF)) {
+        size_t start = parser->current.offset;
+        ASTNode *instr = parse_instruction(parser);
+        bool keep_going;
+        if (!instr || parser->panic_mode) {
+            ast_free(instr);
+            instr = NULL;
+            keep_going = parser_synchronize(parser, start, false);
+        } else {
+            // Tras un error ya no se entregan instrucciones: solo se buscan más.
+            keep_going = parser->had_error || callback(instr, ctx);
+        }
+        ast_free(instr);
+        if (parser->use_arena) {
+            ast_arena_reset(&parser->arena);
+        }
+        if (!keep_going) {
+            return false;
+        }
+    }
+    return !parser->had_error;
+}
+
+ASTNode *parser_parse_instruction(Parser *parser) {
+    ASTNode *instr = parse_instruction(parser);
+    if (parser->panic_mode) {
+        ast_free(instr);
+        return NULL;
+    }
+    return instr;
+}
+
+typedef struct {
+    FlatAST *out;
+    bool out_of_memory;
+} FlatAppend;
+
+static bool parser_append_flat(ASTNode *instruction, void *ctx) {
+    FlatAppend *append = (FlatAppend *)ctx;
+    if (!flat_ast_append_tree(append->out, instruction)) {
+        append->out_of_memory = true;
+        return false;
+    }
+    return true;
+}
+
+bool parser_parse_flat(Parser *parser, FlatAST *out) {
+    uint32_t program = flat_ast_push(out, AST_PROGRAM, parser->current);
+    uint32_t instructions = flat_ast_push(out, AST_INSTRUCTION_LIST, parser->current);
+    if (program == FLAT_AST_NONE || instructions == FLAT_AST_NONE) {
+        parser_error(parser, parser->current, "Memoria insuficiente para el AST.");
+        return false;
+    }
+    FlatAppend append = {out, false};
+    if (!parser_parse_streaming(parser, parser_append_flat, &append)) {
+        if (append.out_of_memory) {
+            parser_error(parser, parser->current, "Memoria insuficiente para el AST.");
+        }
+        return false;
+    }
+    flat_ast_close(out, instructions);
+    flat_ast_close(out, program);
+    return true;
 }
 
 bool parser_has_error(const Parser *parser) {
@@ -103,14 +411,41 @@ Token parser_error_token(const Parser *parser) {
     return parser->error_token;
 }
 
+SourceLocation parser_error_location(Parser *parser) {
+    return lexer_location(&parser->lexer, parser->error_token.offset);
+}
+
+size_t parser_error_count(const Parser *parser) {
+    return parser->error_count;
+}
+
+const char *parser_error_message_at(const Parser *parser, size_t index) {
+    return index == 0 ? parser->error_message : parser->errors[index - 1].message;
+}
+
+SourceLocation parser_error_location_at(Parser *parser, size_t index) {
+    Token token = index == 0 ? parser->error_token : parser->errors[index - 1].token;
+    return lexer_location(&parser->lexer, token.offset);
+}
+
 static ASTNode *parse_instruction_list(Parser *parser, bool stop_on_rbrace) {
-    ASTNode *list = ast_create(AST_INSTRUCTION_LIST, parser->current);
+    // El cuerpo de una instrucción que ya falló no se analiza: recuperarse
+    // dentro de él sacaría al parser del modo pánico fuera de lugar.
+    if (parser->panic_mode) {
+        return NULL;
+    }
+    ASTNode *list = parser_node(parser, AST_INSTRUCTION_LIST, parser->current);
     while (!parser_check(parser, TOKEN_EOF)) {
         if (stop_on_rbrace && parser_check(parser, TOKEN_RBRACE)) {
             break;
         }
+        size_t start = parser->current.offset;
         ASTNode *instr = parse_instruction(parser);
-        if (!instr) {
+        if (!instr || parser->panic_mode) {
+            ast_free(instr);
+            if (parser_synchronize(parser, start, stop_on_rbrace)) {
+                continue;
+            }
             ast_free(list);
             return NULL;
         }
@@ -154,21 +489,21 @@ static ASTNode *parse_instruction(Parser *parser) {
 static ASTNode *parse_declaration(Parser *parser) {
     Token type_token = parser->current;
     parser_advance(parser);
-    ASTNode *node = ast_create(AST_DECLARATION, type_token);
+    ASTNode *node = parser_node(parser, AST_DECLARATION, type_token);
     ASTNode *identifier = parse_identifier_node(parser);
     if (!identifier) {
         ast_free(node);
         return NULL;
     }
     parser_consume(parser, TOKEN_EQ, "Se esperaba '=' en la declaración.");
-    if (parser->had_error) {
+    if (parser->panic_mode) {
         ast_free(node);
         ast_free(identifier);
         return NULL;
     }
     ASTNode *expr = parse_expression(parser);
     parser_consume(parser, TOKEN_SEMICOLON, "Se esperaba ';' al final de la declaración.");
-    if (parser->had_error || !expr) {
+    if (parser->panic_mode || !expr) {
         ast_free(node);
         ast_free(identifier);
         ast_free(expr);
@@ -182,12 +517,12 @@ static ASTNode *parse_declaration(Parser *parser) {
 static ASTNode *parse_array_declaration(Parser *parser) {
     Token array_token = parser->current;
     parser_advance(parser);
-    ASTNode *node = ast_create(AST_DECLARATION, array_token);
+    ASTNode *node = parser_node(parser, AST_DECLARATION, array_token);
     ASTNode *identifier = parse_identifier_node(parser);
     parser_consume(parser, TOKEN_EQ, "Se esperaba '=' en la declaración de arreglo.");
     ASTNode *array_literal = parse_array_literal(parser);
     parser_consume(parser, TOKEN_SEMICOLON, "Se esperaba ';' tras la declaración de arreglo.");
-    if (parser->had_error || !identifier || !array_literal) {
+    if (parser->panic_mode || !identifier || !array_literal) {
         ast_free(node);
         ast_free(identifier);
         ast_free(array_literal);
@@ -203,12 +538,12 @@ static ASTNode *parse_assignment(Parser *parser) {
     parser_consume(parser, TOKEN_EQ, "Se esperaba '=' en la asignación.");
     ASTNode *expr = parse_expression(parser);
     parser_consume(parser, TOKEN_SEMICOLON, "Se esperaba ';' tras la asignación.");
-    if (parser->had_error || !identifier || !expr) {
+    if (parser->panic_mode || !identifier || !expr) {
         ast_free(identifier);
         ast_free(expr);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_ASSIGNMENT, identifier->token);
+    ASTNode *node = parser_node(parser, AST_ASSIGNMENT, identifier->token);
     ast_add_child(node, identifier);
     ast_add_child(node, expr);
     return node;
@@ -223,12 +558,12 @@ static ASTNode *parse_if(Parser *parser) {
     parser_consume(parser, TOKEN_LBRACE, "Se esperaba '{' para iniciar el bloque del if.");
     ASTNode *body = parse_instruction_list(parser, true);
     parser_consume(parser, TOKEN_RBRACE, "Se esperaba '}' al cerrar el bloque del if.");
-    if (parser->had_error || !condition || !body) {
+    if (parser->panic_mode || !condition || !body) {
         ast_free(condition);
         ast_free(body);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_IF, if_token);
+    ASTNode *node = parser_node(parser, AST_IF, if_token);
     ast_add_child(node, condition);
     ast_add_child(node, body);
     return node;
@@ -245,13 +580,13 @@ static ASTNode *parse_for(Parser *parser) {
     parser_consume(parser, TOKEN_LBRACE, "Se esperaba '{' para el cuerpo del for.");
     ASTNode *body = parse_instruction_list(parser, true);
     parser_consume(parser, TOKEN_RBRACE, "Se esperaba '}' al cerrar el for.");
-    if (parser->had_error || !iterator || !iterable || !body) {
+    if (parser->panic_mode || !iterator || !iterable || !body) {
         ast_free(iterator);
         ast_free(iterable);
         ast_free(body);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_FOR, for_token);
+    ASTNode *node = parser_node(parser, AST_FOR, for_token);
     ast_add_child(node, iterator);
     ast_add_child(node, iterable);
     ast_add_child(node, body);
@@ -267,19 +602,19 @@ static ASTNode *parse_while(Parser *parser) {
     parser_consume(parser, TOKEN_LBRACE, "Se esperaba '{' para el cuerpo del while.");
     ASTNode *body = parse_instruction_list(parser, true);
     parser_consume(parser, TOKEN_RBRACE, "Se esperaba '}' al cerrar el while.");
-    if (parser->had_error || !condition || !body) {
+    if (parser->panic_mode || !condition || !body) {
         ast_free(condition);
         ast_free(body);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_WHILE, while_token);
+    ASTNode *node = parser_node(parser, AST_WHILE, while_token);
     ast_add_child(node, condition);
     ast_add_child(node, body);
     return node;
 }
 
 static ASTNode *parse_parameter_list(Parser *parser) {
-    ASTNode *params = ast_create(AST_PARAM_LIST, parser->current);
+    ASTNode *params = parser_node(parser, AST_PARAM_LIST, parser->current);
     if (parser->current.type == TOKEN_RPAREN) {
         return params;
     }
@@ -311,14 +646,14 @@ static ASTNode *parse_function(Parser *parser) {
         maybe_return = parse_return(parser);
     }
     parser_consume(parser, TOKEN_RBRACE, "Se esperaba '}' al cerrar la función.");
-    if (parser->had_error || !name || !params || !body) {
+    if (parser->panic_mode || !name || !params || !body) {
         ast_free(name);
         ast_free(params);
         ast_free(body);
         ast_free(maybe_return);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_FUNCTION, func_token);
+    ASTNode *node = parser_node(parser, AST_FUNCTION, func_token);
     ast_add_child(node, name);
     ast_add_child(node, params);
     ast_add_child(node, body);
@@ -333,17 +668,17 @@ static ASTNode *parse_return(Parser *parser) {
     parser_advance(parser);
     ASTNode *expr = parse_expression(parser);
     parser_consume(parser, TOKEN_SEMICOLON, "Se esperaba ';' tras return.");
-    if (parser->had_error || !expr) {
+    if (parser->panic_mode || !expr) {
         ast_free(expr);
         return NULL;
     }
-    ASTNode *node = ast_create(AST_RETURN, return_token);
+    ASTNode *node = parser_node(parser, AST_RETURN, return_token);
     ast_add_child(node, expr);
     return node;
 }
 
 static ASTNode *parse_argument_list(Parser *parser) {
-    ASTNode *args = ast_create(AST_ARG_LIST, parser->current);
+    ASTNode *args = parser_node(parser, AST_ARG_LIST, parser->current);
     if (parser_check(parser, TOKEN_RPAREN)) {
         return args;
     }
@@ -366,12 +701,12 @@ static ASTNode *parse_call(Parser *parser, ASTNode *callee) {
     parser_consume(parser, TOKEN_LPAREN, "Se esperaba '(' en la llamada.");
     ASTNode *args = parse_argument_list(parser);
     parser_consume(parser, TOKEN_RPAREN, "Se esperaba ')' al cerrar la llamada.");
-    if (parser->had_error || !callee || !args) {
+    if (parser->panic_mode || !callee || !args) {
         ast_free(callee);
         ast_free(args);
         return NULL;
     }
-    ASTNode *call = ast_create(AST_CALL, call_token);
+    ASTNode *call = parser_node(parser, AST_CALL, call_token);
     ast_add_child(call, callee);
     ast_add_child(call, args);
     return call;
@@ -389,7 +724,7 @@ static ASTNode *parse_special_call(Parser *parser, Token keyword) {
     parser_consume(parser, TOKEN_LPAREN, "Se esperaba '(' tras llamada especial.");
     ASTNode *args = parse_argument_list(parser);
     parser_consume(parser, TOKEN_RPAREN, "Se esperaba ')' en la llamada especial.");
-    ASTNode *call = ast_create(AST_CALL, keyword);
+    ASTNode *call = parser_node(parser, AST_CALL, keyword);
     ast_add_child(call, args);
     if (keyword.type == TOKEN_KW_CREAD) {
         ASTNode *destination = parse_identifier_node(parser);
@@ -402,162 +737,312 @@ static ASTNode *parse_special_call(Parser *parser, Token keyword) {
 static ASTNode *parse_expression_statement(Parser *parser) {
     ASTNode *expr = parse_expression(parser);
     parser_consume(parser, TOKEN_SEMICOLON, "Se esperaba ';' tras la expresión.");
-    if (parser->had_error || !expr) {
+    if (parser->panic_mode || !expr) {
         ast_free(expr);
         return NULL;
     }
-    ASTNode *wrapper = ast_create(AST_EXPRESSION, expr->token);
+    ASTNode *wrapper = parser_node(parser, AST_EXPRESSION, expr->token);
     ast_add_child(wrapper, expr);
     return wrapper;
 }
 
-static ASTNode *parse_primary(Parser *parser);
-static ASTNode *parse_unary(Parser *parser);
-static ASTNode *parse_mul(Parser *parser);
-static ASTNode *parse_add(Parser *parser);
-static ASTNode *parse_rel(Parser *parser);
-static ASTNode *parse_eq(Parser *parser);
-static ASTNode *parse_and(Parser *parser);
-static ASTNode *parse_or(Parser *parser);
+// Parser de expresiones por precedencia con pilas explícitas en el heap: la
+// profundidad de anidamiento no consume pila de C. Produce exactamente los
+// mismos nodos que la gramática recursiva
+//
+//   or      := and ('||' and)*
+//   and     := eq ('&&' eq)*
+//   eq      := rel (('==' | '!=') rel)*
+//   rel     := add (('<' | '<=' | '>' | '>=') add)*
+//   add     := mul (('+' | '-') mul)*
+//   mul     := unary (('*' | '/' | '%') unary)*
+//   unary   := ('-' | '!' | '++' | '--') unary | primary
+//   primary := literal | IDENT | IDENT '(' args? ')' | '(' or ')' | '[' (or (',' or)*)? ']'
+//
+// y el mismo primer error. Los paréntesis, las llamadas y los arreglos abren
+// un marco barrera en la pila de operadores; al cerrarse, su contenido queda
+// como un único operando.
 
-static ASTNode *parse_expression(Parser *parser) {
-    return parse_or(parser);
-}
+typedef enum {
+    EXPR_FRAME_BINARY,
+    EXPR_FRAME_UNARY,
+    EXPR_FRAME_GROUP,
+    EXPR_FRAME_CALL,
+    EXPR_FRAME_ARRAY
+} ExprFrameKind;
 
-static ASTNode *parse_or(Parser *parser) {
-    ASTNode *left = parse_and(parser);
-    while (parser_check(parser, TOKEN_OROR)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_and(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, left);
-        ast_add_child(node, right);
-        left = node;
+struct ExprFrame {
+    ExprFrameKind kind;
+    unsigned precedence;
+    // Operador, o el '(' de una llamada.
+    Token token;
+    // Llamada: callee y AST_ARG_LIST; arreglo: el AST_ARRAY_LITERAL.
+    ASTNode *node;
+    ASTNode *list;
+};
+
+// Precedencia de los operadores binarios; 0 si el token no lo es. Todos
+// asocian por la izquierda y los unarios ligan más fuerte que cualquiera.
+static const unsigned char BINARY_PRECEDENCE[TOKEN_UNKNOWN + 1] = {
+    [TOKEN_OROR] = 1,
+    [TOKEN_ANDAND] = 2,
+    [TOKEN_EQEQ] = 3, [TOKEN_BANGEQ] = 3,
+    [TOKEN_LT] = 4, [TOKEN_LTE] = 4, [TOKEN_GT] = 4, [TOKEN_GTE] = 4,
+    [TOKEN_PLUS] = 5, [TOKEN_MINUS] = 5,
+    [TOKEN_STAR] = 6, [TOKEN_SLASH] = 6, [TOKEN_PERCENT] = 6,
+};
+
+typedef struct {
+    size_t frames;
+    size_t operands;
+} ExprStack;
+
+static bool expr_push_frame(Parser *parser, ExprStack *stack, ExprFrame frame) {
+    if (stack->frames == parser->expr_frame_capacity) {
+        size_t capacity = parser->expr_frame_capacity ? parser->expr_frame_capacity * 2 : 64;
+        ExprFrame *frames = (ExprFrame *)realloc(parser->expr_frames, capacity * sizeof(ExprFrame));
+        if (!frames) {
+            return false;
+        }
+        parser->expr_frames = frames;
+        parser->expr_frame_capacity = capacity;
     }
-    return left;
+    parser->expr_frames[stack->frames++] = frame;
+    return true;
 }
 
-static ASTNode *parse_and(Parser *parser) {
-    ASTNode *left = parse_eq(parser);
-    while (parser_check(parser, TOKEN_ANDAND)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_eq(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, left);
-        ast_add_child(node, right);
-        left = node;
+static bool expr_push_operand(Parser *parser, ExprStack *stack, ASTNode *operand) {
+    if (!operand) {
+        return false;
+    }
+    if (stack->operands == parser->expr_operand_capacity) {
+        size_t capacity = parser->expr_operand_capacity ? parser->expr_operand_capacity * 2 : 64;
+        ASTNode **operands = (ASTNode **)realloc(parser->expr_operands, capacity * sizeof(ASTNode *));
+        if (!operands) {
+            return false;
+        }
+        parser->expr_operands = operands;
+        parser->expr_operand_capacity = capacity;
     }
-    return left;
+    parser->expr_operands[stack->operands++] = operand;
+    return true;
 }
 
-static ASTNode *parse_eq(Parser *parser) {
-    ASTNode *left = parse_rel(parser);
-    while (parser_check(parser, TOKEN_EQEQ) || parser_check(parser, TOKEN_BANGEQ)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_rel(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, left);
-        ast_add_child(node, right);
-        left = node;
-    }
-    return left;
+static ASTNode *expr_pop_operand(Parser *parser, ExprStack *stack) {
+    return parser->expr_operands[--stack->operands];
 }
 
-static ASTNode *parse_rel(Parser *parser) {
-    ASTNode *left = parse_add(parser);
-    while (parser_check(parser, TOKEN_LT) || parser_check(parser, TOKEN_LTE) ||
-           parser_check(parser, TOKEN_GT) || parser_check(parser, TOKEN_GTE)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_add(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
+// Aplica el operador de la cima a sus operandos.
+static bool expr_reduce(Parser *parser, ExprStack *stack) {
+    ExprFrame *frame = &parser->expr_frames[--stack->frames];
+    ASTNode *node = parser_node(parser, AST_EXPRESSION, frame->token);
+    if (!node) {
+        return false;
+    }
+    if (frame->kind == EXPR_FRAME_BINARY) {
+        ASTNode *right = expr_pop_operand(parser, stack);
+        ASTNode *left = expr_pop_operand(parser, stack);
         ast_add_child(node, left);
         ast_add_child(node, right);
-        left = node;
+    } else {
+        ast_add_child(node, expr_pop_operand(parser, stack));
     }
-    return left;
+    return expr_push_operand(parser, stack, node);
 }
 
-static ASTNode *parse_add(Parser *parser) {
-    ASTNode *left = parse_mul(parser);
-    while (parser_check(parser, TOKEN_PLUS) || parser_check(parser, TOKEN_MINUS)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_mul(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, left);
-        ast_add_child(node, right);
-        left = node;
-    }
-    return left;
+static bool expr_is_operator(const ExprFrame *frame) {
+    return frame->kind == EXPR_FRAME_BINARY || frame->kind == EXPR_FRAME_UNARY;
 }
 
-static ASTNode *parse_mul(Parser *parser) {
-    ASTNode *left = parse_unary(parser);
-    while (parser_check(parser, TOKEN_STAR) || parser_check(parser, TOKEN_SLASH) || parser_check(parser, TOKEN_PERCENT)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *right = parse_unary(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, left);
-        ast_add_child(node, right);
-        left = node;
-    }
-    return left;
+static ASTNode *expr_call(Parser *parser, Token call_token, ASTNode *callee, ASTNode *args) {
+    ASTNode *call = parser_node(parser, AST_CALL, call_token);
+    ast_add_child(call, callee);
+    ast_add_child(call, args);
+    return call;
 }
 
-static ASTNode *parse_unary(Parser *parser) {
-    if (parser_check(parser, TOKEN_MINUS) || parser_check(parser, TOKEN_BANG) ||
-        parser_check(parser, TOKEN_PLUSPLUS) || parser_check(parser, TOKEN_MINUSMINUS)) {
-        Token op = parser->current;
-        parser_advance(parser);
-        ASTNode *expr = parse_unary(parser);
-        ASTNode *node = ast_create(AST_EXPRESSION, op);
-        ast_add_child(node, expr);
-        return node;
+// Libera lo que quedó a medias en las pilas (solo hace falta sin arena).
+static ASTNode *expr_fail(Parser *parser, ExprStack *stack) {
+    if (!parser->panic_mode) {
+        parser_error(parser, parser->current, "Memoria insuficiente para el AST.");
+    }
+    while (stack->operands) {
+        ast_free(expr_pop_operand(parser, stack));
     }
-    return parse_primary(parser);
+    while (stack->frames) {
+        ExprFrame *frame = &parser->expr_frames[--stack->frames];
+        ast_free(frame->node);
+        ast_free(frame->list);
+    }
+    return NULL;
 }
 
-static ASTNode *parse_primary(Parser *parser) {
-    Token token = parser->current;
-    switch (token.type) {
-        case TOKEN_NUMBER:
-        case TOKEN_STRING:
-        case TOKEN_CHAR:
-        case TOKEN_TRUE:
-        case TOKEN_FALSE: {
+// No es reentrante: las pilas son del parser y ninguna regla de la expresión
+// vuelve a llamar a parse_expression.
+static ASTNode *parse_expression(Parser *parser) {
+    ExprStack stack = {0, 0};
+    bool expect_operand = true;
+    while (true) {
+        if (expect_operand) {
+            Token token = parser->current;
+            switch (token.type) {
+                case TOKEN_MINUS:
+                case TOKEN_BANG:
+                case TOKEN_PLUSPLUS:
+                case TOKEN_MINUSMINUS:
+                    parser_advance(parser);
+                    if (!expr_push_frame(parser, &stack, (ExprFrame){EXPR_FRAME_UNARY, 0, token, NULL, NULL})) {
+                        return expr_fail(parser, &stack);
+                    }
+                    continue;
+                case TOKEN_NUMBER:
+                case TOKEN_STRING:
+                case TOKEN_CHAR:
+                case TOKEN_TRUE:
+                case TOKEN_FALSE:
+                    parser_advance(parser);
+                    if (!expr_push_operand(parser, &stack, parser_node(parser, AST_LITERAL, token))) {
+                        return expr_fail(parser, &stack);
+                    }
+                    expect_operand = false;
+                    continue;
+                case TOKEN_IDENTIFIER: {
+                    parser_advance(parser);
+                    ASTNode *identifier = parser_node(parser, AST_IDENTIFIER, token);
+                    if (!parser_check(parser, TOKEN_LPAREN)) {
+                        if (!expr_push_operand(parser, &stack, identifier)) {
+                            return expr_fail(parser, &stack);
+                        }
+                        expect_operand = false;
+                        continue;
+                    }
+                    Token call_token = parser->current;
+                    parser_advance(parser);
+                    ASTNode *args = parser_node(parser, AST_ARG_LIST, parser->current);
+                    if (parser_match(parser, TOKEN_RPAREN)) {
+                        if (!expr_push_operand(parser, &stack, expr_call(parser, call_token, identifier, args))) {
+                            return expr_fail(parser, &stack);
+                        }
+                        expect_operand = false;
+                        continue;
+                    }
+                    ExprFrame frame = {EXPR_FRAME_CALL, 0, call_token, identifier, args};
+                    if (!identifier || !args || !expr_push_frame(parser, &stack, frame)) {
+                        ast_free(identifier);
+                        ast_free(args);
+                        return expr_fail(parser, &stack);
+                    }
+                    continue;
+                }
+                case TOKEN_LPAREN:
+                    parser_advance(parser);
+                    if (!expr_push_frame(parser, &stack, (ExprFrame){EXPR_FRAME_GROUP, 0, token, NULL, NULL})) {
+                        return expr_fail(parser, &stack);
+                    }
+                    continue;
+                case TOKEN_LBRACKET: {
+                    parser_advance(parser);
+                    ASTNode *array = parser_node(parser, AST_ARRAY_LITERAL, token);
+                    if (parser_match(parser, TOKEN_RBRACKET)) {
+                        if (!expr_push_operand(parser, &stack, array)) {
+                            return expr_fail(parser, &stack);
+                        }
+                        expect_operand = false;
+                        continue;
+                    }
+                    ExprFrame frame = {EXPR_FRAME_ARRAY, 0, token, array, NULL};
+                    if (!array || !expr_push_frame(parser, &stack, frame)) {
+                        ast_free(array);
+                        return expr_fail(parser, &stack);
+                    }
+                    continue;
+                }
+                default:
+                    parser_error(parser, token, "Expresión primaria inválida.");
+                    return expr_fail(parser, &stack);
+            }
+        }
+
+        unsigned precedence = BINARY_PRECEDENCE[parser->current.type];
+        if (precedence) {
+            while (stack.frames) {
+                const ExprFrame *top = &parser->expr_frames[stack.frames - 1];
+                if (top->kind != EXPR_FRAME_UNARY && (top->kind != EXPR_FRAME_BINARY || top->precedence < precedence)) {
+                    break;
+                }
+                if (!expr_reduce(parser, &stack)) {
+                    return expr_fail(parser, &stack);
+                }
+            }
+            ExprFrame frame = {EXPR_FRAME_BINARY, precedence, parser->current, NULL, NULL};
             parser_advance(parser);
-            ASTNode *literal = ast_create(AST_LITERAL, token);
-            return literal;
+            if (!expr_push_frame(parser, &stack, frame)) {
+                return expr_fail(parser, &stack);
+            }
+            expect_operand = true;
+            continue;
         }
-        case TOKEN_IDENTIFIER: {
-            ASTNode *identifier = parse_identifier_node(parser);
-            if (parser->current.type == TOKEN_LPAREN) {
-                return parse_call(parser, identifier);
+
+        // Sin más operadores: se cierra todo hasta la barrera más cercana.
+        while (stack.frames && expr_is_operator(&parser->expr_frames[stack.frames - 1])) {
+            if (!expr_reduce(parser, &stack)) {
+                return expr_fail(parser, &stack);
             }
-            return identifier;
         }
-        case TOKEN_LPAREN: {
-            parser_advance(parser);
-            ASTNode *expr = parse_expression(parser);
-            parser_consume(parser, TOKEN_RPAREN, "Se esperaba ')' tras la expresión.");
-            return expr;
+        if (stack.frames == 0) {
+            return expr_pop_operand(parser, &stack);
+        }
+        ExprFrame *barrier = &parser->expr_frames[stack.frames - 1];
+        switch (barrier->kind) {
+            case EXPR_FRAME_GROUP:
+                if (!parser_check(parser, TOKEN_RPAREN)) {
+                    parser_error(parser, parser->current, "Se esperaba ')' tras la expresión.");
+                    return expr_fail(parser, &stack);
+                }
+                parser_advance(parser);
+                stack.frames--;
+                continue;
+            case EXPR_FRAME_CALL:
+                ast_add_child(barrier->list, expr_pop_operand(parser, &stack));
+                if (parser_match(parser, TOKEN_COMMA)) {
+                    expect_operand = true;
+                    continue;
+                }
+                if (!parser_check(parser, TOKEN_RPAREN)) {
+                    parser_error(parser, parser->current, "Se esperaba ')' al cerrar la llamada.");
+                    return expr_fail(parser, &stack);
+                }
+                parser_advance(parser);
+                stack.frames--;
+                if (!expr_push_operand(parser, &stack, expr_call(parser, barrier->token, barrier->node, barrier->list))) {
+                    return expr_fail(parser, &stack);
+                }
+                continue;
+            case EXPR_FRAME_ARRAY:
+                ast_add_child(barrier->node, expr_pop_operand(parser, &stack));
+                if (parser_match(parser, TOKEN_COMMA)) {
+                    expect_operand = true;
+                    continue;
+                }
+                if (!parser_check(parser, TOKEN_RBRACKET)) {
+                    parser_error(parser, parser->current, "Se esperaba ']' tras el arreglo.");
+                    return expr_fail(parser, &stack);
+                }
+                parser_advance(parser);
+                stack.frames--;
+                if (!expr_push_operand(parser, &stack, barrier->node)) {
+                    return expr_fail(parser, &stack);
+                }
+                continue;
+            default:
+                return expr_fail(parser, &stack);
         }
-        case TOKEN_LBRACKET:
-            return parse_array_literal(parser);
-        default:
-            parser_error(parser, token, "Expresión primaria inválida.");
-            return NULL;
     }
 }
 
 static ASTNode *parse_array_literal(Parser *parser) {
     Token bracket = parser_consume(parser, TOKEN_LBRACKET, "Se esperaba '['.");
-    ASTNode *array = ast_create(AST_ARRAY_LITERAL, bracket);
+    ASTNode *array = parser_node(parser, AST_ARRAY_LITERAL, bracket);
     if (!parser_check(parser, TOKEN_RBRACKET)) {
         while (true) {
             ASTNode *value = parse_expression(parser);
@@ -2,26 +2,120 @@
  #define PYCLITE_PARSER_H
 
 #include "ast/ast.h"
+#include "ast/flat_ast.h"
+#include "intern/intern.h"
 #include "lexer/lexer.h"
+#include "lexer/token_ring.h"
 
  #include <stdbool.h>
 
+ typedef struct ParseRegion ParseRegion;
+ typedef struct ExprFrame ExprFrame;
+
+ // Mensajes: siempre literales del parser, válidos mientras dure el programa.
+ typedef struct {
+     Token token;
+     const char *message;
+ } ParserDiagnostic;
+
  typedef struct {
      Lexer lexer;
      Token current;
      Token next;
      bool has_next;
+
+     const TokenBuffer *tokens;
+     size_t next_index;
+     TokenRing *ring;
  
      bool had_error;
      char error_message[256];
      Token error_token;
+     // Modo pánico: la instrucción en curso ya falló y sus errores siguientes
+     // se descartan hasta sincronizar. El primer error sigue en error_message y
+     // error_token; los demás van en errors (error_count los cuenta todos).
+     bool panic_mode;
+     ParserDiagnostic *errors;
+     size_t error_count;
+     size_t error_capacity;
+     size_t max_errors;
+
+     ASTArena arena;
+     bool use_arena;
+     size_t threads;
+     size_t min_region_size;
+     // Parsers de las regiones de un parseo paralelo: sus arenas guardan los
+     // subárboles, así que viven tanto como este parser.
+     ParseRegion *regions;
+     size_t region_count;
+     // Pilas del parser de expresiones; se conservan entre expresiones para no
+     // reservar memoria en cada una.
+     ExprFrame *expr_frames;
+     size_t expr_frame_capacity;
+     ASTNode **expr_operands;
+     size_t expr_operand_capacity;
+     // Tabla donde se internan los identificadores según se leen; es
+     // own_symbols salvo que se cambie con parser_set_symbols.
+     InternTable *symbols;
+     InternTable own_symbols;
  } Parser;
 
+ // Recibe cada instrucción de nivel superior ya completa. El nodo solo es válido
+ // durante la llamada: al volver, el parser libera o recicla su memoria.
+ // Devolver false detiene el análisis sin marcar error.
+ typedef bool (*ParserInstructionFn)(ASTNode *instruction, void *ctx);
+
  void parser_init(Parser *parser, const char *source, size_t length);
+ // Variante que recorre por índice un búfer ya producido por lexer_tokenize_all
+ // sobre la misma fuente, en lugar de pedir los tokens al lexer uno a uno.
+ void parser_init_tokens(Parser *parser, const char *source, size_t length, const TokenBuffer *tokens);
+ // Variante en tubería: el lexer corre en su propio hilo y entrega los tokens
+ // por un TokenRing. Devuelve false si no se pudo arrancar el hilo.
+ bool parser_init_pipelined(Parser *parser, const char *source, size_t length);
+ // Parser sobre [begin, end) de source, como lexer_init_range.
+ void parser_init_range(Parser *parser, const char *source, size_t begin, size_t end);
+ void parser_set_arena(Parser *parser, bool enabled);
+ // Con más de un hilo, parser_parse reparte los archivos grandes en regiones
+ // que empiezan en un `func` de nivel superior y las parsea en paralelo. El
+ // árbol y los diagnósticos son idénticos a los del parseo en serie. Cada
+ // región tiene al menos min_region_size bytes; 0 no divide nunca. No hay un
+ // valor por defecto: el umbral a partir del cual compensa depende de la
+ // máquina y se ajusta con make bench BENCH=regions.
+ void parser_set_threads(Parser *parser, size_t threads, size_t min_region_size);
+ // Con un límite distinto de 1, las listas de instrucciones se recuperan de
+ // cada error de sintaxis saltando hasta ';', '}' o la palabra clave de la
+ // siguiente instrucción, y el análisis sigue hasta reunir max_errors errores
+ // (0 es sin límite). El árbol se descarta igualmente si hubo alguno. Por
+ // defecto es 1: el análisis se detiene en el primero.
+ void parser_set_max_errors(Parser *parser, size_t max_errors);
+ // Interna los identificadores en table (que debe vivir más que el parser) en
+ // lugar de en la tabla propia; así varios parseos de la misma fuente, como los
+ // de un ParserDocument, comparten símbolos. Se llama justo tras parser_init*.
+ void parser_set_symbols(Parser *parser, InternTable *table);
+ // Tabla con los símbolos de los TOKEN_IDENTIFIER del árbol construido.
+ const InternTable *parser_symbols(const Parser *parser);
+ void parser_free(Parser *parser);
+ // distance 0 es el token actual; con búfer de tokens el coste es O(1) para
+ // cualquier distancia, con el lexer incremental se analiza por adelantado.
+ // Solo los tokens actual y siguiente tienen ya su símbolo.
+ Token parser_peek(const Parser *parser, size_t distance);
  ASTNode *parser_parse(Parser *parser);
+ bool parser_parse_flat(Parser *parser, FlatAST *out);
+ // Analiza el programa instrucción a instrucción con memoria acotada por la
+ // instrucción más grande; no construye AST_PROGRAM ni AST_INSTRUCTION_LIST.
+ bool parser_parse_streaming(Parser *parser, ParserInstructionFn callback, void *ctx);
+ // Parsea una sola instrucción a partir del token actual. Devuelve NULL si hay
+ // error; el nodo pertenece al llamante si el arena está desactivado.
+ ASTNode *parser_parse_instruction(Parser *parser);
  bool parser_has_error(const Parser *parser);
  const char *parser_error_message(const Parser *parser);
  Token parser_error_token(const Parser *parser);
+ SourceLocation parser_error_location(Parser *parser);
+ // Errores en orden de aparición; el índice 0 es el mismo que devuelven las
+ // funciones anteriores.
+ size_t parser_error_count(const Parser *parser);
+ const char *parser_error_message_at(const Parser *parser, size_t index);
+ SourceLocation parser_error_location_at(Parser *parser, size_t index);
 
  #endif // PYCLITE_PARSER_H
 
@@ -0,0 +1,350 @@
+#include "resolver.h"
+
+#include <stdlib.h>
+
+typedef enum {
+    TASK_VISIT,
+    // Declara el identificador en el ámbito actual.
+    TASK_DEFINE,
+    TASK_ENTER_BLOCK,
+    TASK_EXIT_BLOCK,
+    // Abre el marco y el ámbito de una func (o del programa) y declara sus parámetros.
+    TASK_ENTER_FUNCTION,
+    TASK_EXIT_FUNCTION
+} ResolverTaskKind;
+
+struct ResolverTask {
+    ResolverTaskKind kind;
+    ASTNode *node;
+};
+
+struct ResolverBinding {
+    uint32_t symbol;
+    uint32_t frame;
+    uint32_t slot;
+    uint32_t declaration;
+    // Declaración del mismo símbolo que esta oculta (índice + 1, o 0).
+    uint32_t shadowed;
+};
+
+struct ResolverScope {
+    size_t first_binding;
+    uint32_t first_slot;
+};
+
+struct ResolverFrame {
+    ASTNode *node;
+    uint32_t next_slot;
+    uint32_t size;
+};
+
+// Asegura sitio para un elemento más en un arreglo que crece al doble.
+// Devuelve el arreglo (quizá movido) o NULL si no hay memoria; en ese caso el
+// original sigue siendo válido.
+static void *resolver_grow(void *items, size_t count, size_t *capacity, size_t size) {
+    if (count < *capacity) {
+        return items;
+    }
+    size_t grown_capacity = *capacity ? *capacity * 2 : 64;
+    void *grown = realloc(items, grown_capacity * size);
+    if (grown) {
+        *capacity = grown_capacity;
+    }
+    return grown;
+}
+
+void resolver_init(Resolver *resolver) {
+    resolver->errors = NULL;
+    resolver->error_count = 0;
+    resolver->error_capacity = 0;
+    resolver->max_errors = 1;
+    resolver->declaration_count = 0;
+    resolver->visible = NULL;
+    resolver->symbol_count = 0;
+    resolver->bindings = NULL;
+    resolver->binding_count = 0;
+    resolver->binding_capacity = 0;
+    resolver->scopes = NULL;
+    resolver->scope_count = 0;
+    resolver->scope_capacity = 0;
+    resolver->frames = NULL;
+    resolver->frame_count = 0;
+    resolver->frame_capacity = 0;
+    resolver->tasks = NULL;
+    resolver->task_count = 0;
+    resolver->task_capacity = 0;
+}
+
+void resolver_free(Resolver *resolver) {
+    free(resolver->errors);
+    free(resolver->visible);
+    free(resolver->bindings);
+    free(resolver->scopes);
+    free(resolver->frames);
+    free(resolver->tasks);
+    resolver_init(resolver);
+}
+
+void resolver_set_max_errors(Resolver *resolver, size_t max_errors) {
+    resolver->max_errors = max_errors;
+}
+
+// Se guardan todos: las func se declaran antes que el resto de su bloque, así
+// que los errores no salen en orden y el límite se aplica al final, ya ordenados.
+static void resolver_error(Resolver *resolver, Token token, const char *message) {
+    ResolverDiagnostic *errors = (ResolverDiagnostic *)resolver_grow(
+        resolver->errors, resolver->error_count, &resolver->error_capacity, sizeof(ResolverDiagnostic));
+    if (!errors) {
+        return;
+    }
+    resolver->errors = errors;
+    resolver->errors[resolver->error_count].token = token;
+    resolver->errors[resolver->error_count].message = message;
+    resolver->error_count++;
+}
+
+static bool resolver_push(Resolver *resolver, ResolverTaskKind kind, ASTNode *node) {
+    ResolverTask *tasks = (ResolverTask *)resolver_grow(resolver->tasks, resolver->task_count,
+                                                        &resolver->task_capacity, sizeof(ResolverTask));
+    if (!tasks) {
+        return false;
+    }
+    resolver->tasks = tasks;
+    resolver->tasks[resolver->task_count].kind = kind;
+    resolver->tasks[resolver->task_count].node = node;
+    resolver->task_count++;
+    return true;
+}
+
+// Apila los hijos en orden inverso para visitarlos de izquierda a derecha.
+static bool resolver_push_children(Resolver *resolver, ASTNode *node, size_t first) {
+    for (size_t i = node->child_count; i > first; --i) {
+        if (node->children[i - 1] && !resolver_push(resolver, TASK_VISIT, node->children[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool resolver_enter_scope(Resolver *resolver) {
+    ResolverScope *scopes = (ResolverScope *)resolver_grow(resolver->scopes, resolver->scope_count,
+                                                           &resolver->scope_capacity, sizeof(ResolverScope));
+    if (!scopes) {
+        return false;
+    }
+    resolver->scopes = scopes;
+    ResolverScope *scope = &resolver->scopes[resolver->scope_count++];
+    scope->first_binding = resolver->binding_count;
+    scope->first_slot = resolver->frames[resolver->frame_count - 1].next_slot;
+    return true;
+}
+
+// Cierra el ámbito: sus declaraciones dejan de ocultar a las de fuera y sus
+// huecos quedan libres para el siguiente bloque del mismo marco.
+static void resolver_exit_scope(Resolver *resolver) {
+    ResolverScope *scope = &resolver->scopes[--resolver->scope_count];
+    while (resolver->binding_count > scope->first_binding) {
+        ResolverBinding *binding = &resolver->bindings[--resolver->binding_count];
+        resolver->visible[binding->symbol] = binding->shadowed;
+    }
+    resolver->frames[resolver->frame_count - 1].next_slot = scope->first_slot;
+}
+
+static bool resolver_known_symbol(const Resolver *resolver, const ASTNode *identifier) {
+    return identifier->token.symbol != 0 && identifier->token.symbol <= resolver->symbol_count;
+}
+
+static bool resolver_define(Resolver *resolver, ASTNode *identifier) {
+    if (!resolver_known_symbol(resolver, identifier)) {
+        resolver_error(resolver, identifier->token, "Identificador sin símbolo.");
+        identifier->declaration = AST_NO_DECLARATION;
+        return true;
+    }
+    uint32_t symbol = identifier->token.symbol;
+    uint32_t visible = resolver->visible[symbol];
+    if (visible && visible - 1 >= resolver->scopes[resolver->scope_count - 1].first_binding) {
+        resolver_error(resolver, identifier->token, "Nombre ya declarado en este ámbito.");
+        const ResolverBinding *previous = &resolver->bindings[visible - 1];
+        identifier->depth = 0;
+        identifier->slot = previous->slot;
+        identifier->declaration = previous->declaration;
+        return true;
+    }
+    ResolverBinding *bindings = (ResolverBinding *)resolver_grow(
+        resolver->bindings, resolver->binding_count, &resolver->binding_capacity, sizeof(ResolverBinding));
+    if (!bindings) {
+        return false;
+    }
+    resolver->bindings = bindings;
+    ResolverFrame *frame = &resolver->frames[resolver->frame_count - 1];
+    ResolverBinding *binding = &resolver->bindings[resolver->binding_count++];
+    binding->symbol = symbol;
+    binding->frame = (uint32_t)(resolver->frame_count - 1);
+    binding->slot = frame->next_slot++;
+    binding->declaration = (uint32_t)resolver->declaration_count++;
+    binding->shadowed = visible;
+    if (frame->next_slot > frame->size) {
+        frame->size = frame->next_slot;
+    }
+    resolver->visible[symbol] = (uint32_t)resolver->binding_count;
+    identifier->depth = 0;
+    identifier->slot = binding->slot;
+    identifier->declaration = binding->declaration;
+    return true;
+}
+
+static void resolver_use(Resolver *resolver, ASTNode *identifier) {
+    uint32_t visible = 0;
+    if (resolver_known_symbol(resolver, identifier)) {
+        visible = resolver->visible[identifier->token.symbol];
+    }
+    if (!visible) {
+        resolver_error(resolver, identifier->token, "Nombre no declarado.");
+        identifier->depth = 0;
+        identifier->slot = AST_NO_SLOT;
+        identifier->declaration = AST_NO_DECLARATION;
+        return;
+    }
+    const ResolverBinding *binding = &resolver->bindings[visible - 1];
+    identifier->depth = (uint32_t)(resolver->frame_count - 1) - binding->frame;
+    identifier->slot = binding->slot;
+    identifier->declaration = binding->declaration;
+}
+
+static bool resolver_enter_function(Resolver *resolver, ASTNode *node) {
+    ResolverFrame *frames = (ResolverFrame *)resolver_grow(resolver->frames, resolver->frame_count,
+                                                           &resolver->frame_capacity, sizeof(ResolverFrame));
+    if (!frames) {
+        return false;
+    }
+    resolver->frames = frames;
+    ResolverFrame *frame = &resolver->frames[resolver->frame_count++];
+    frame->node = node;
+    frame->next_slot = 0;
+    frame->size = 0;
+    if (!resolver_enter_scope(resolver)) {
+        return false;
+    }
+    if (node->type != AST_FUNCTION) {
+        return true;
+    }
+    // Hijos de AST_FUNCTION: nombre, parámetros, cuerpo y return opcional.
+    ASTNode *params = node->children[1];
+    for (size_t i = 0; i < params->child_count; ++i) {
+        if (!resolver_define(resolver, params->children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void resolver_exit_function(Resolver *resolver) {
+    resolver_exit_scope(resolver);
+    ResolverFrame *frame = &resolver->frames[--resolver->frame_count];
+    frame->node->frame_size = frame->size;
+}
+
+static bool resolver_visit(Resolver *resolver, ASTNode *node) {
+    switch (node->type) {
+        case AST_PROGRAM:
+            return resolver_push(resolver, TASK_EXIT_FUNCTION, node) &&
+                   resolver_push_children(resolver, node, 0) &&
+                   resolver_push(resolver, TASK_ENTER_FUNCTION, node);
+        case AST_INSTRUCTION_LIST:
+            // Las func del bloque se declaran antes que nada.
+            for (size_t i = 0; i < node->child_count; ++i) {
+                ASTNode *instruction = node->children[i];
+                if (instruction->type != AST_FUNCTION) {
+                    continue;
+                }
+                if (!resolver_define(resolver, instruction->children[0])) {
+                    return false;
+                }
+            }
+            return resolver_push_children(resolver, node, 0);
+        case AST_DECLARATION:
+            // El valor inicial se resuelve antes de que el nombre exista.
+            return resolver_push(resolver, TASK_DEFINE, node->children[0]) &&
+                   resolver_push(resolver, TASK_VISIT, node->children[1]);
+        case AST_IF:
+        case AST_WHILE:
+            return resolver_push(resolver, TASK_EXIT_BLOCK, node) &&
+                   resolver_push(resolver, TASK_VISIT, node->children[1]) &&
+                   resolver_push(resolver, TASK_ENTER_BLOCK, node) &&
+                   resolver_push(resolver, TASK_VISIT, node->children[0]);
+        case AST_FOR:
+            // Hijos: iterador, iterable y cuerpo; el iterable se resuelve fuera del bloque.
+            return resolver_push(resolver, TASK_EXIT_BLOCK, node) &&
+                   resolver_push(resolver, TASK_VISIT, node->children[2]) &&
+                   resolver_push(resolver, TASK_DEFINE, node->children[0]) &&
+                   resolver_push(resolver, TASK_ENTER_BLOCK, node) &&
+                   resolver_push(resolver, TASK_VISIT, node->children[1]);
+        case AST_FUNCTION:
+            // El nombre ya se declaró con el resto del bloque.
+            return resolver_push(resolver, TASK_EXIT_FUNCTION, node) &&
+                   resolver_push_children(resolver, node, 2) &&
+                   resolver_push(resolver, TASK_ENTER_FUNCTION, node);
+        case AST_IDENTIFIER:
+            resolver_use(resolver, node);
+            return true;
+        case AST_LITERAL:
+        case AST_COMMENT:
+            return true;
+        default:
+            return resolver_push_children(resolver, node, 0);
+    }
+}
+
+static int compare_diagnostics(const void *a, const void *b) {
+    uint32_t left = ((const ResolverDiagnostic *)a)->token.offset;
+    uint32_t right = ((const ResolverDiagnostic *)b)->token.offset;
+    return (left > right) - (left < right);
+}
+
+bool resolver_resolve(Resolver *resolver, ASTNode *program, const InternTable *symbols) {
+    resolver->error_count = 0;
+    resolver->declaration_count = 0;
+    resolver->binding_count = 0;
+    resolver->scope_count = 0;
+    resolver->frame_count = 0;
+    resolver->task_count = 0;
+    size_t symbol_count = intern_count(symbols);
+    free(resolver->visible);
+    resolver->visible = (uint32_t *)calloc(symbol_count + 1, sizeof(uint32_t));
+    resolver->symbol_count = resolver->visible ? symbol_count : 0;
+    bool ok = resolver->visible && resolver_push(resolver, TASK_VISIT, program);
+    while (ok && resolver->task_count > 0) {
+        ResolverTask task = resolver->tasks[--resolver->task_count];
+        switch (task.kind) {
+            case TASK_VISIT:
+                ok = resolver_visit(resolver, task.node);
+                break;
+            case TASK_DEFINE:
+                ok = resolver_define(resolver, task.node);
+                break;
+            case TASK_ENTER_BLOCK:
+                ok = resolver_enter_scope(resolver);
+                break;
+            case TASK_EXIT_BLOCK:
+                resolver_exit_scope(resolver);
+                break;
+            case TASK_ENTER_FUNCTION:
+                ok = resolver_enter_function(resolver, task.node);
+                break;
+            case TASK_EXIT_FUNCTION:
+                resolver_exit_function(resolver);
+                break;
+        }
+    }
+    if (!ok) {
+        resolver_error(resolver, program->token, "Memoria insuficiente para resolver los nombres.");
+    }
+    // Cada error es de un identificador distinto: los offsets no se repiten.
+    if (resolver->error_count > 1) {
+        qsort(resolver->errors, resolver->error_count, sizeof(ResolverDiagnostic), compare_diagnostics);
+    }
+    if (resolver->max_errors && resolver->error_count > resolver->max_errors) {
+        resolver->error_count = resolver->max_errors;
+    }
+    return ok && resolver->error_count == 0;
+}
@@ -0,0 +1,77 @@
+#ifndef PYCLITE_RESOLVER_H
+#define PYCLITE_RESOLVER_H
+
+#include "ast/ast.h"
+#include "intern/intern.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Resolución de nombres sobre el árbol de parser_parse.
+//
+// Ámbitos léxicos: el programa, cada func (parámetros y cuerpo) y el bloque de
+// cada if, while y for (el iterador del for es del bloque). Una variable se ve
+// desde su declaración hasta el final de su ámbito; una func se ve en todo el
+// bloque que la declara, para que funcionen la recursión mutua y las llamadas
+// a funciones definidas más abajo.
+//
+// El programa y cada func tienen un marco de variables. Los bloques toman sus
+// huecos del marco de la función que los contiene y los devuelven al cerrarse,
+// así que el tamaño del marco es el máximo de variables vivas a la vez. Tras
+// resolver, cada AST_IDENTIFIER lleva depth y slot: la variable está en el
+// hueco slot del marco que queda depth funciones hacia fuera (0 es el propio).
+// AST_PROGRAM y cada AST_FUNCTION llevan su frame_size.
+//
+// Además, cada declaración (variable, parámetro, iterador o func) recibe un
+// número en el orden en que se declara, de 0 a declaration_count - 1, y sus
+// identificadores lo llevan en declaration; AST_NO_DECLARATION si no se
+// resolvieron.
+
+// Mensajes: siempre literales, válidos mientras dure el programa.
+typedef struct {
+    Token token;
+    const char *message;
+} ResolverDiagnostic;
+
+typedef struct ResolverTask ResolverTask;
+typedef struct ResolverBinding ResolverBinding;
+typedef struct ResolverScope ResolverScope;
+typedef struct ResolverFrame ResolverFrame;
+
+typedef struct {
+    ResolverDiagnostic *errors;
+    size_t error_count;
+    size_t error_capacity;
+    // Se quedan los max_errors primeros en orden del código; 0 es sin límite.
+    size_t max_errors;
+    // Declaraciones numeradas en la última resolución.
+    size_t declaration_count;
+
+    // Por símbolo, índice + 1 en bindings de su declaración visible (0 si no hay).
+    uint32_t *visible;
+    size_t symbol_count;
+    // Declaraciones vivas, en orden; cada una recuerda la que oculta.
+    ResolverBinding *bindings;
+    size_t binding_count;
+    size_t binding_capacity;
+    ResolverScope *scopes;
+    size_t scope_count;
+    size_t scope_capacity;
+    ResolverFrame *frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    // Recorrido iterativo: las expresiones pueden anidarse sin límite.
+    ResolverTask *tasks;
+    size_t task_count;
+    size_t task_capacity;
+} Resolver;
+
+void resolver_init(Resolver *resolver);
+void resolver_free(Resolver *resolver);
+void resolver_set_max_errors(Resolver *resolver, size_t max_errors);
+// Anota program; symbols es la tabla con la que se parseó (parser_symbols).
+// Devuelve false si hubo algún error, que queda en errors.
+bool resolver_resolve(Resolver *resolver, ASTNode *program, const InternTable *symbols);
+
+#endif // PYCLITE_RESOLVER_H
@@ -0,0 +1,722 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include "parser/incremental.h"
+#include "source/source.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SERVER_BACKLOG 16
+#define SERVER_MAX_PATH 4096
+#define SERVER_MAX_FILES (1u << 20)
+// Conexiones atendidas a la vez, cada una en su hilo.
+#define SERVER_MAX_CLIENTS 64
+// Un cliente que tarda más que esto en enviar o recibir cada parte de un
+// mensaje se descarta, para que no retenga un hilo indefinidamente.
+#define SERVER_IO_TIMEOUT_SECONDS 5
+
+// Protocolo: un byte de orden. CHECK va seguido del --max-errors del cliente
+// (u32), del número de rutas y de cada ruta como longitud más sus bytes. La respuesta es su longitud en bytes (u64)
+// seguida, por cada ruta, de: estado (u8), instrucciones (u64), línea y
+// columna del primer error (u64), su mensaje (u32 de longitud más bytes) y
+// los errores siguientes (u32 con cuántos y, por cada uno, línea, columna y
+// mensaje como el primero). Los enteros van en little-endian con su anchura
+// fija, así que el formato no depende de la disposición de DriverResult.
+//
+// Solo hay comprobación: los árboles se quedan en el servidor, ya que el
+// cliente solo muestra diagnósticos.
+enum {
+    SERVER_CHECK = 'C',
+    SERVER_STOP = 'S'
+};
+
+typedef struct CacheEntry {
+    char *path;
+    struct CacheEntry *next;
+    // Protege el resto de la entrada; dos clientes pueden pedir el mismo archivo.
+    pthread_mutex_t lock;
+    struct timespec mtime;
+    off_t size;
+    uint64_t hash;
+    bool has_document;
+    ParserDocument document;
+    // Primer error, o ninguno; es lo que da el documento incremental.
+    DriverResult result;
+    // Con errores y un cliente que pide más de uno: el resultado de un parseo
+    // completo con errors_limit como --max-errors, hasta que cambie el texto.
+    bool has_errors;
+    size_t errors_limit;
+    DriverResult errors;
+} CacheEntry;
+
+// Las entradas no se borran hasta cache_free, así que un puntero obtenido con
+// cache_lookup sigue siendo válido tras soltar lock.
+typedef struct {
+    CacheEntry **buckets;
+    size_t bucket_count;
+    size_t count;
+    pthread_mutex_t lock;
+} Cache;
+
+static bool cache_init(Cache *cache) {
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->bucket_count = 256;
+    cache->count = 0;
+    cache->buckets = (CacheEntry **)calloc(cache->bucket_count, sizeof(CacheEntry *));
+    return cache->buckets != NULL;
+}
+
+static void cache_free(Cache *cache) {
+    for (size_t i = 0; i < cache->bucket_count; ++i) {
+        CacheEntry *entry = cache->buckets[i];
+        while (entry) {
+            CacheEntry *next = entry->next;
+            if (entry->has_document) {
+                parser_document_free(&entry->document);
+            }
+            if (entry->has_errors) {
+                driver_result_free(&entry->errors);
+            }
+            pthread_mutex_destroy(&entry->lock);
+            free(entry->path);
+            free(entry);
+            entry = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = NULL;
+    cache->bucket_count = 0;
+    cache->count = 0;
+    pthread_mutex_destroy(&cache->lock);
+}
+
+static void cache_grow(Cache *cache) {
+    size_t bucket_count = cache->bucket_count * 2;
+    CacheEntry **buckets = (CacheEntry **)calloc(bucket_count, sizeof(CacheEntry *));
+    if (!buckets) {
+        return;
+    }
+    for (size_t i = 0; i < cache->bucket_count; ++i) {
+        CacheEntry *entry = cache->buckets[i];
+        while (entry) {
+            CacheEntry *next = entry->next;
+            size_t bucket = source_hash(entry->path, strlen(entry->path)) & (bucket_count - 1);
+            entry->next = buckets[bucket];
+            buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+}
+
+// Busca la entrada de path y la crea vacía si no existe. Hay que tener
+// cache->lock.
+static CacheEntry *cache_find(Cache *cache, const char *path) {
+    size_t length = strlen(path);
+    size_t bucket = source_hash(path, length) & (cache->bucket_count - 1);
+    for (CacheEntry *entry = cache->buckets[bucket]; entry; entry = entry->next) {
+        if (strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    CacheEntry *entry = (CacheEntry *)calloc(1, sizeof(CacheEntry));
+    char *copy = (char *)malloc(length + 1);
+    if (!entry || !copy) {
+        free(entry);
+        free(copy);
+        return NULL;
+    }
+    memcpy(copy, path, length + 1);
+    pthread_mutex_init(&entry->lock, NULL);
+    entry->path = copy;
+    entry->next = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    if (++cache->count > cache->bucket_count) {
+        cache_grow(cache);
+    }
+    return entry;
+}
+
+static CacheEntry *cache_lookup(Cache *cache, const char *path) {
+    pthread_mutex_lock(&cache->lock);
+    CacheEntry *entry = cache_find(cache, path);
+    pthread_mutex_unlock(&cache->lock);
+    return entry;
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Message;
+
+static bool message_append(Message *message, const void *data, size_t length) {
+    if (message->length + length > message->capacity) {
+        size_t capacity = message->capacity ? message->capacity : 4096;
+        while (capacity < message->length + length) {
+            capacity *= 2;
+        }
+        char *grown = (char *)realloc(message->data, capacity);
+        if (!grown) {
+            return false;
+        }
+        message->data = grown;
+        message->capacity = capacity;
+    }
+    memcpy(message->data + message->length, data, length);
+    message->length += length;
+    return true;
+}
+
+static bool message_u8(Message *message, uint8_t value) {
+    return message_append(message, &value, 1);
+}
+
+static bool message_u32(Message *message, uint32_t value) {
+    unsigned char bytes[4];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    return message_append(message, bytes, sizeof(bytes));
+}
+
+static bool message_u64(Message *message, uint64_t value) {
+    unsigned char bytes[8];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    return message_append(message, bytes, sizeof(bytes));
+}
+
+static bool message_string(Message *message, const char *text) {
+    size_t length = strlen(text);
+    return length <= UINT32_MAX && message_u32(message, (uint32_t)length) && message_append(message, text, length);
+}
+
+static bool message_diagnostic(Message *message, SourceLocation location, const char *text) {
+    return message_u64(message, location.line) && message_u64(message, location.column) &&
+           message_string(message, text);
+}
+
+static bool message_result(Message *message, const DriverResult *result) {
+    bool ok = message_u8(message, (uint8_t)result->status) && message_u64(message, result->instruction_count) &&
+              message_diagnostic(message, result->location, result->message) &&
+              message_u32(message, (uint32_t)result->more_error_count);
+    for (size_t i = 0; ok && i < result->more_error_count; ++i) {
+        ok = message_diagnostic(message, result->more_errors[i].location, result->more_errors[i].message);
+    }
+    return ok;
+}
+
+// Lectura de un mensaje recibido; ok pasa a false en cuanto falta algún byte.
+typedef struct {
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+    bool ok;
+} MessageReader;
+
+static const unsigned char *reader_take(MessageReader *reader, size_t length) {
+    if (!reader->ok || length > reader->length - reader->position) {
+        reader->ok = false;
+        return NULL;
+    }
+    const unsigned char *bytes = reader->data + reader->position;
+    reader->position += length;
+    return bytes;
+}
+
+static uint64_t reader_uint(MessageReader *reader, size_t width) {
+    const unsigned char *bytes = reader_take(reader, width);
+    uint64_t value = 0;
+    for (size_t i = 0; bytes && i < width; ++i) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+// Convierte el cambio de contenido en una sola edición: lo que hay entre el
+// prefijo y el sufijo comunes.
+static void document_update(ParserDocument *doc, const char *data, size_t length) {
+    size_t limit = doc->length < length ? doc->length : length;
+    size_t prefix = 0;
+    while (prefix < limit && doc->source[prefix] == data[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < limit - prefix && doc->source[doc->length - 1 - suffix] == data[length - 1 - suffix]) {
+        suffix++;
+    }
+    parser_document_edit(doc, prefix, doc->length - prefix - suffix, data + prefix, length - prefix - suffix);
+}
+
+static void document_result(const ParserDocument *doc, DriverResult *result) {
+    result->status = DRIVER_OK;
+    result->instruction_count = doc->count;
+    result->location.line = 0;
+    result->location.column = 0;
+    result->message[0] = '\0';
+    result->more_errors = NULL;
+    result->more_error_count = 0;
+    memset(&result->types, 0, sizeof(result->types));
+    memset(&result->optimization, 0, sizeof(result->optimization));
+    if (parser_document_has_error(doc)) {
+        result->status = DRIVER_PARSE_ERROR;
+        result->location = parser_document_error_location(doc);
+        snprintf(result->message, sizeof(result->message), "%s", parser_document_error_message(doc));
+    }
+}
+
+static bool same_time(struct timespec a, struct timespec b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+// El documento incremental se detiene en el primer error. Si el cliente pide
+// más, los demás salen de un parseo completo, que se guarda hasta que el
+// texto cambie; el camino sin errores no paga nada.
+static const DriverResult *entry_errors(CacheEntry *entry, const DriverOptions *options) {
+    if (entry->result.status != DRIVER_PARSE_ERROR || options->max_errors == 1) {
+        return &entry->result;
+    }
+    if (!entry->has_errors || entry->errors_limit != options->max_errors) {
+        if (entry->has_errors) {
+            driver_result_free(&entry->errors);
+        }
+        driver_compile_file(entry->path, options, &entry->errors);
+        entry->has_errors = true;
+        entry->errors_limit = options->max_errors;
+    }
+    return &entry->errors;
+}
+
+static void entry_changed(CacheEntry *entry) {
+    document_result(&entry->document, &entry->result);
+    if (entry->has_errors) {
+        driver_result_free(&entry->errors);
+        entry->has_errors = false;
+    }
+}
+
+static bool append_compiled(Message *response, const char *path, const DriverOptions *options) {
+    DriverResult result;
+    driver_compile_file(path, options, &result);
+    bool ok = message_result(response, &result);
+    driver_result_free(&result);
+    return ok;
+}
+
+// Comprueba path con el límite de errores del cliente y añade su resultado a
+// response. Devuelve false si no hay memoria para la respuesta.
+static bool server_check_file(Cache *cache, const char *path, size_t max_errors, Message *response) {
+    DriverOptions options = {.jobs = 1, .parse_threads = 1, .max_errors = max_errors};
+    struct stat info;
+    CacheEntry *entry = NULL;
+    // Tuberías y demás no tienen una fecha fiable: se compilan sin caché.
+    if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+        entry = cache_lookup(cache, path);
+    }
+    if (!entry) {
+        return append_compiled(response, path, &options);
+    }
+
+    pthread_mutex_lock(&entry->lock);
+    bool cached = entry->has_document && same_time(entry->mtime, info.st_mtim) && entry->size == info.st_size;
+    SourceFile file;
+    if (!cached && (!source_load(&file, path) || file.length > LEXER_MAX_SOURCE_LENGTH)) {
+        pthread_mutex_unlock(&entry->lock);
+        return append_compiled(response, path, &options);
+    }
+    if (!cached) {
+        uint64_t hash = source_hash(file.data, file.length);
+        if (!entry->has_document) {
+            parser_document_init(&entry->document, file.data, file.length);
+            entry->has_document = true;
+            entry_changed(entry);
+        } else if (hash != entry->hash || file.length != entry->document.length) {
+            document_update(&entry->document, file.data, file.length);
+            entry_changed(entry);
+        }
+        entry->hash = hash;
+        entry->mtime = info.st_mtim;
+        entry->size = info.st_size;
+        source_release(&file);
+    }
+    bool ok = message_result(response, entry_errors(entry, &options));
+    pthread_mutex_unlock(&entry->lock);
+    return ok;
+}
+
+static bool write_all(int fd, const void *data, size_t length) {
+    const char *bytes = (const char *)data;
+    while (length > 0) {
+        ssize_t written = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t length) {
+    char *bytes = (char *)data;
+    while (length > 0) {
+        ssize_t got = read(fd, bytes, length);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+// Atiende una conexión. Devuelve false si se pidió detener el servidor.
+static bool server_handle(Cache *cache, int client) {
+    unsigned char command;
+    if (!read_all(client, &command, 1)) {
+        return true;
+    }
+    if (command == SERVER_STOP) {
+        write_all(client, &command, 1);
+        return false;
+    }
+    unsigned char header[8];
+    if (command != SERVER_CHECK || !read_all(client, header, sizeof(header))) {
+        return true;
+    }
+    MessageReader reader = {header, sizeof(header), 0, true};
+    size_t max_errors = (size_t)reader_uint(&reader, 4);
+    uint32_t count = (uint32_t)reader_uint(&reader, 4);
+    if (count > SERVER_MAX_FILES) {
+        return true;
+    }
+    // La longitud de la respuesta se rellena al final.
+    Message response = {NULL, 0, 0};
+    bool ok = message_u64(&response, 0);
+    char path[SERVER_MAX_PATH + 1];
+    for (uint32_t i = 0; i < count && ok; ++i) {
+        reader = (MessageReader){header, 4, 0, read_all(client, header, 4)};
+        uint32_t length = (uint32_t)reader_uint(&reader, 4);
+        ok = reader.ok && length <= SERVER_MAX_PATH && read_all(client, path, length);
+        if (ok) {
+            path[length] = '\0';
+            ok = server_check_file(cache, path, max_errors, &response);
+        }
+    }
+    if (ok) {
+        uint64_t body = response.length - 8;
+        for (size_t i = 0; i < 8; ++i) {
+            response.data[i] = (char)(body >> (8 * i));
+        }
+        write_all(client, response.data, response.length);
+    }
+    free(response.data);
+    return true;
+}
+
+static bool socket_address(const char *socket_path, struct sockaddr_un *address) {
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        return false;
+    }
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+static int connect_socket(const char *socket_path) {
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Estado compartido por el bucle de aceptación y los hilos de los clientes.
+typedef struct {
+    Cache cache;
+    int listener;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t active;
+    bool stopping;
+} Server;
+
+typedef struct {
+    Server *server;
+    int client;
+} ClientTask;
+
+static void client_finish(Server *server, int client, bool running) {
+    close(client);
+    pthread_mutex_lock(&server->lock);
+    if (!running && !server->stopping) {
+        server->stopping = true;
+        // Despierta al accept bloqueado en el hilo principal.
+        shutdown(server->listener, SHUT_RDWR);
+    }
+    server->active--;
+    pthread_cond_broadcast(&server->changed);
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void *client_main(void *arg) {
+    ClientTask task = *(ClientTask *)arg;
+    free(arg);
+    client_finish(task.server, task.client, server_handle(&task.server->cache, task.client));
+    return NULL;
+}
+
+// Entrega client a un hilo propio. Si no se puede crear, se atiende en este.
+static void server_dispatch(Server *server, int client) {
+    struct timeval timeout = {SERVER_IO_TIMEOUT_SECONDS, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    pthread_mutex_lock(&server->lock);
+    while (server->active == SERVER_MAX_CLIENTS) {
+        pthread_cond_wait(&server->changed, &server->lock);
+    }
+    server->active++;
+    pthread_mutex_unlock(&server->lock);
+
+    ClientTask *task = (ClientTask *)malloc(sizeof(ClientTask));
+    pthread_t thread;
+    if (task) {
+        *task = (ClientTask){server, client};
+        if (pthread_create(&thread, NULL, client_main, task) == 0) {
+            pthread_detach(thread);
+            return;
+        }
+        free(task);
+    }
+    client_finish(server, client, server_handle(&server->cache, client));
+}
+
+int server_run(const char *socket_path) {
+    struct sockaddr_un address;
+    if (!socket_address(socket_path, &address)) {
+        fprintf(stderr, "Ruta de socket demasiado larga: %s\n", socket_path);
+        return 1;
+    }
+    // Un socket que aún responde es de otro servidor; si no, es un resto de
+    // una ejecución anterior y se puede reemplazar.
+    int probe = connect_socket(socket_path);
+    if (probe >= 0) {
+        close(probe);
+        fprintf(stderr, "Ya hay un servidor escuchando en %s\n", socket_path);
+        return 1;
+    }
+    unlink(socket_path);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, SERVER_BACKLOG) != 0) {
+        fprintf(stderr, "No se pudo escuchar en %s: %s\n", socket_path, strerror(errno));
+        if (listener >= 0) {
+            close(listener);
+        }
+        return 1;
+    }
+    Server server;
+    if (!cache_init(&server.cache)) {
+        fprintf(stderr, "Memoria insuficiente para la caché del servidor.\n");
+        close(listener);
+        unlink(socket_path);
+        return 1;
+    }
+    server.listener = listener;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.changed, NULL);
+    server.active = 0;
+    server.stopping = false;
+    printf("Servidor escuchando en %s\n", socket_path);
+    fflush(stdout);
+
+    bool failed = false;
+    while (true) {
+        int client = accept(listener, NULL, NULL);
+        pthread_mutex_lock(&server.lock);
+        bool stopping = server.stopping;
+        pthread_mutex_unlock(&server.lock);
+        if (client < 0) {
+            if (stopping) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            fprintf(stderr, "Error al aceptar conexiones: %s\n", strerror(errno));
+            failed = true;
+            break;
+        }
+        if (stopping) {
+            close(client);
+            break;
+        }
+        server_dispatch(&server, client);
+    }
+    // Los clientes en curso terminan antes de liberar la caché.
+    pthread_mutex_lock(&server.lock);
+    while (server.active > 0) {
+        pthread_cond_wait(&server.changed, &server.lock);
+    }
+    pthread_mutex_unlock(&server.lock);
+    close(listener);
+    unlink(socket_path);
+    cache_free(&server.cache);
+    pthread_cond_destroy(&server.changed);
+    pthread_mutex_destroy(&server.lock);
+    return failed ? 1 : 0;
+}
+
+// El servidor no comparte el directorio actual del cliente: las rutas
+// relativas se envían con cwd delante.
+static bool message_append_path(Message *message, const char *cwd, const char *path) {
+    bool relative = path[0] != '/';
+    size_t cwd_length = relative ? strlen(cwd) : 0;
+    size_t path_length = strlen(path);
+    size_t total = cwd_length + relative + path_length;
+    if (total > SERVER_MAX_PATH) {
+        return false;
+    }
+    return message_u32(message, (uint32_t)total) && message_append(message, cwd, cwd_length) &&
+           message_append(message, "/", relative) && message_append(message, path, path_length);
+}
+
+static void reader_diagnostic(MessageReader *reader, SourceLocation *location, const char **text, size_t *length) {
+    location->line = (size_t)reader_uint(reader, 8);
+    location->column = (size_t)reader_uint(reader, 8);
+    *length = (size_t)reader_uint(reader, 4);
+    *text = (const char *)reader_take(reader, *length);
+}
+
+// Descodifica un resultado. Los errores siguientes y sus mensajes van en un
+// solo bloque para que driver_result_free los libere juntos.
+static bool reader_result(MessageReader *reader, DriverResult *result) {
+    memset(result, 0, sizeof(*result));
+    uint8_t status = (uint8_t)reader_uint(reader, 1);
+    result->status = status <= DRIVER_NAME_ERROR ? (DriverStatus)status : DRIVER_PARSE_ERROR;
+    result->instruction_count = (size_t)reader_uint(reader, 8);
+    const char *text;
+    size_t length;
+    reader_diagnostic(reader, &result->location, &text, &length);
+    if (!reader->ok) {
+        return false;
+    }
+    size_t copied = length < sizeof(result->message) ? length : sizeof(result->message) - 1;
+    memcpy(result->message, text, copied);
+    result->message[copied] = '\0';
+
+    size_t count = (size_t)reader_uint(reader, 4);
+    // Primera pasada: comprobar el mensaje y medir el bloque.
+    size_t start = reader->position;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count && reader->ok; ++i) {
+        SourceLocation location;
+        reader_diagnostic(reader, &location, &text, &length);
+        bytes += length + 1;
+    }
+    if (!reader->ok || count == 0) {
+        return reader->ok;
+    }
+    char *block = (char *)malloc(count * sizeof(DriverDiagnostic) + bytes);
+    if (!block) {
+        return false;
+    }
+    DriverDiagnostic *errors = (DriverDiagnostic *)block;
+    char *strings = block + count * sizeof(DriverDiagnostic);
+    reader->position = start;
+    for (size_t i = 0; i < count; ++i) {
+        reader_diagnostic(reader, &errors[i].location, &text, &length);
+        memcpy(strings, text, length);
+        strings[length] = '\0';
+        errors[i].message = strings;
+        strings += length + 1;
+    }
+    result->more_errors = errors;
+    result->more_error_count = count;
+    return true;
+}
+
+bool server_check(const char *socket_path, const DriverFileList *files, size_t max_errors, DriverResult *results) {
+    char cwd[SERVER_MAX_PATH];
+    if (files->count > SERVER_MAX_FILES || max_errors > UINT32_MAX || !getcwd(cwd, sizeof(cwd))) {
+        return false;
+    }
+    Message message = {NULL, 0, 0};
+    bool ok = message_u8(&message, SERVER_CHECK) && message_u32(&message, (uint32_t)max_errors) &&
+              message_u32(&message, (uint32_t)files->count);
+    for (size_t i = 0; i < files->count && ok; ++i) {
+        ok = message_append_path(&message, cwd, files->paths[i]);
+    }
+    int fd = ok ? connect_socket(socket_path) : -1;
+    unsigned char header[8];
+    ok = fd >= 0 && write_all(fd, message.data, message.length) && read_all(fd, header, sizeof(header));
+    free(message.data);
+    unsigned char *body = NULL;
+    size_t length = 0;
+    if (ok) {
+        MessageReader reader = {header, sizeof(header), 0, true};
+        uint64_t size = reader_uint(&reader, 8);
+        length = (size_t)size;
+        body = size == length ? (unsigned char *)malloc(length ? length : 1) : NULL;
+        ok = body && read_all(fd, body, length);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    MessageReader reader = {body, length, 0, ok};
+    size_t decoded = 0;
+    while (ok && decoded < files->count) {
+        ok = reader_result(&reader, &results[decoded]);
+        decoded += ok;
+    }
+    ok = ok && reader.position == reader.length;
+    if (!ok) {
+        for (size_t i = 0; i < decoded; ++i) {
+            driver_result_free(&results[i]);
+        }
+    }
+    free(body);
+    return ok;
+}
+
+bool server_stop(const char *socket_path) {
+    int fd = connect_socket(socket_path);
+    if (fd < 0) {
+        return false;
+    }
+    unsigned char command = SERVER_STOP;
+    bool ok = write_all(fd, &command, 1) && read_all(fd, &command, 1);
+    close(fd);
+    return ok;
+}
@@ -0,0 +1,25 @@
+#ifndef PYCLITE_SERVER_H
+#define PYCLITE_SERVER_H
+
+#include "driver/driver.h"
+
+#include <stdbool.h>
+
+// Servidor de compilación persistente sobre un socket Unix. Guarda un
+// ParserDocument por ruta: si la fecha de modificación y el tamaño no
+// cambiaron, el archivo ni se lee; si cambiaron pero el hash del contenido es
+// el mismo, no se parsea; y si el contenido cambió, solo se reanaliza el tramo
+// que difiere. Atiende cada conexión en su propio hilo hasta recibir la orden
+// de parada. Devuelve el código de salida del proceso.
+int server_run(const char *socket_path);
+
+// Cliente: pide al servidor que compruebe files (rutas relativas al
+// directorio actual del cliente) con hasta max_errors errores por archivo
+// (0 es sin límite), y deja en results un resultado por archivo, en el mismo
+// orden; hay que liberarlos con driver_result_free. Devuelve false si no se
+// pudo hablar con el servidor.
+bool server_check(const char *socket_path, const DriverFileList *files, size_t max_errors, DriverResult *results);
+// Pide al servidor que termine; devuelve false si no había ninguno escuchando.
+bool server_stop(const char *socket_path);
+
+#endif // PYCLITE_SERVER_H
@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool read_stream(SourceFile *file, FILE *stream) {
+    size_t capacity = 64 * 1024;
+    size_t length = 0;
+    char *buffer = (char *)malloc(capacity);
+    if (!buffer) {
+        return false;
+    }
+    while (true) {
+        if (length == capacity) {
+            capacity *= 2;
+            char *grown = (char *)realloc(buffer, capacity);
+            if (!grown) {
+                free(buffer);
+                return false;
+            }
+            buffer = grown;
+        }
+        size_t read = fread(buffer + length, 1, capacity - length, stream);
+        length += read;
+        if (read == 0) {
+            break;
+        }
+    }
+    if (ferror(stream)) {
+        free(buffer);
+        return false;
+    }
+    file->data = buffer;
+    file->length = length;
+    file->mapped = false;
+    return true;
+}
+
+#ifndef _WIN32
+// Proyecta el archivo abierto en fd. Tuberías, FIFOs y archivos vacíos (como
+// los de /proc) se leen del mismo descriptor: volver a abrir la ruta de un
+// FIFO esperaría a otro escritor y se quedaría colgado.
+static bool load_fd(SourceFile *file, int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t length = (size_t)info.st_size;
+        void *data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            posix_madvise(data, length, POSIX_MADV_SEQUENTIAL);
+            file->data = (const char *)data;
+            file->length = length;
+            file->mapped = true;
+            return true;
+        }
+    }
+    FILE *stream = fdopen(fd, "rb");
+    if (!stream) {
+        close(fd);
+        return false;
+    }
+    bool ok = read_stream(file, stream);
+    fclose(stream);
+    return ok;
+}
+#else
+static bool read_path(SourceFile *file, const char *path) {
+    FILE *stream = fopen(path, "rb");
+    if (!stream) {
+        return false;
+    }
+    bool ok = read_stream(file, stream);
+    fclose(stream);
+    return ok;
+}
+#endif
+
+bool source_load(SourceFile *file, const char *path) {
+    file->data = NULL;
+    file->length = 0;
+    file->mapped = false;
+    if (strcmp(path, "-") == 0) {
+        return read_stream(file, stdin);
+    }
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    return fd >= 0 && load_fd(file, fd);
+#else
+    return read_path(file, path);
+#endif
+}
+
+void source_release(SourceFile *file) {
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap((void *)file->data, file->length);
+        file->data = NULL;
+        file->length = 0;
+        file->mapped = false;
+        return;
+    }
+#endif
+    free((void *)file->data);
+    file->data = NULL;
+    file->length = 0;
+}
+
+uint64_t source_hash(const char *data, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,22 @@
+#ifndef PYCLITE_SOURCE_H
+#define PYCLITE_SOURCE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Texto fuente de un archivo. Los archivos regulares se proyectan en memoria
+// (sin copia y sin '\0' final); la entrada estándar ("-"), tuberías y otros
+// flujos se leen a un búfer propio.
+typedef struct {
+    const char *data;
+    size_t length;
+    bool mapped;
+} SourceFile;
+
+bool source_load(SourceFile *file, const char *path);
+void source_release(SourceFile *file);
+// FNV-1a de 64 bits del contenido, para detectar cambios sin guardar copias.
+uint64_t source_hash(const char *data, size_t length);
+
+#endif // PYCLITE_SOURCE_H
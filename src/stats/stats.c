@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#include <time.h>
+
+#include <sys/resource.h>
+
+double stats_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+#ifdef PYCLITE_STATS
+
+#include <pthread.h>
+#include <stdlib.h>
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static StatsBlock *stats_blocks;
+static _Thread_local StatsBlock *stats_block;
+// Si no hay memoria para el bloque de un hilo, cuenta en este, compartido y
+// sin sincronizar: los números pueden salir algo por debajo, pero no se pierde
+// el informe.
+static StatsBlock stats_fallback;
+
+StatsBlock *stats_local(void) {
+    if (stats_block) {
+        return stats_block;
+    }
+    StatsBlock *block = (StatsBlock *)calloc(1, sizeof(StatsBlock));
+    if (!block) {
+        return &stats_fallback;
+    }
+    pthread_mutex_lock(&stats_lock);
+    block->next = stats_blocks;
+    stats_blocks = block;
+    pthread_mutex_unlock(&stats_lock);
+    stats_block = block;
+    return block;
+}
+
+void stats_count_tokens(const TokenBuffer *tokens) {
+    StatsBlock *block = stats_local();
+    for (size_t i = 0; i < tokens->count; ++i) {
+        block->tokens[tokens->tokens[i].type]++;
+    }
+}
+
+static void stats_add(StatsBlock *total, const StatsBlock *block) {
+    for (size_t i = 0; i < STATS_PHASE_COUNT; ++i) {
+        total->seconds[i] += block->seconds[i];
+    }
+    total->files += block->files;
+    total->cache_hits += block->cache_hits;
+    for (size_t i = 0; i <= TOKEN_UNKNOWN; ++i) {
+        total->tokens[i] += block->tokens[i];
+    }
+    for (size_t i = 0; i <= AST_COMMENT; ++i) {
+        total->nodes[i] += block->nodes[i];
+    }
+    total->heap_allocations += block->heap_allocations;
+    total->heap_bytes += block->heap_bytes;
+    total->arena_allocations += block->arena_allocations;
+    total->arena_bytes += block->arena_bytes;
+}
+
+bool stats_enabled(void) {
+    return true;
+}
+
+void stats_report(FILE *stream, double wall_seconds) {
+    StatsBlock total = {0};
+    stats_add(&total, &stats_fallback);
+    pthread_mutex_lock(&stats_lock);
+    for (const StatsBlock *block = stats_blocks; block; block = block->next) {
+        stats_add(&total, block);
+    }
+    pthread_mutex_unlock(&stats_lock);
+
+    struct rusage usage;
+    long peak_rss = getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+    size_t token_total = 0;
+    size_t node_total = 0;
+    for (size_t i = 0; i <= TOKEN_UNKNOWN; ++i) {
+        token_total += total.tokens[i];
+    }
+    for (size_t i = 0; i <= AST_COMMENT; ++i) {
+        node_total += total.nodes[i];
+    }
+
+    // Los tiempos de fase suman los de todos los hilos; con -j pueden superar
+    // a wall_seconds.
+    fprintf(stream, "{\n  \"files\": %zu,\n  \"cache_hits\": %zu,\n", total.files, total.cache_hits);
+    fprintf(stream, "  \"wall_seconds\": %.6f,\n", wall_seconds);
+    fprintf(stream, "  \"phase_seconds\": {\"read\": %.6f, \"lex\": %.6f, \"parse\": %.6f, \"resolve\": %.6f, "
+            "\"types\": %.6f, \"optimize\": %.6f, \"teardown\": %.6f},\n",
+            total.seconds[STATS_READ], total.seconds[STATS_LEX], total.seconds[STATS_PARSE],
+            total.seconds[STATS_RESOLVE], total.seconds[STATS_TYPES], total.seconds[STATS_OPTIMIZE],
+            total.seconds[STATS_TEARDOWN]);
+    fprintf(stream, "  \"tokens\": {\n    \"total\": %zu", token_total);
+    for (size_t i = 0; i <= TOKEN_UNKNOWN; ++i) {
+        if (total.tokens[i]) {
+            fprintf(stream, ",\n    \"%s\": %zu", token_type_str((TokenType)i), total.tokens[i]);
+        }
+    }
+    fprintf(stream, "\n  },\n  \"nodes\": {\n    \"total\": %zu", node_total);
+    for (size_t i = 0; i <= AST_COMMENT; ++i) {
+        if (total.nodes[i]) {
+            fprintf(stream, ",\n    \"%s\": %zu", ast_type_str((ASTNodeType)i), total.nodes[i]);
+        }
+    }
+    fprintf(stream, "\n  },\n");
+    fprintf(stream, "  \"ast_allocations\": {\n");
+    fprintf(stream, "    \"heap\": {\"count\": %zu, \"bytes\": %zu},\n", total.heap_allocations, total.heap_bytes);
+    fprintf(stream, "    \"arena\": {\"count\": %zu, \"bytes\": %zu}\n  },\n", total.arena_allocations,
+            total.arena_bytes);
+    // ru_maxrss está en KiB en Linux.
+    fprintf(stream, "  \"peak_rss_bytes\": %ld\n}\n", peak_rss * 1024);
+}
+
+#else
+
+bool stats_enabled(void) {
+    return false;
+}
+
+void stats_report(FILE *stream, double wall_seconds) {
+    (void)stream;
+    (void)wall_seconds;
+}
+
+#endif
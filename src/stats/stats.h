@@ -0,0 +1,77 @@
+#ifndef PYCLITE_STATS_H
+#define PYCLITE_STATS_H
+
+#include "ast/ast.h"
+#include "lexer/lexer.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Instrumentación por fases para --stats. Solo existe al compilar con
+// PYCLITE_STATS (make STATS=1); sin él, las macros de abajo no generan código
+// y stats_enabled() es false.
+//
+// Cada hilo acumula en su propio bloque de contadores, sin atómicos ni
+// cerrojos; el bloque se registra en una lista global la primera vez que el
+// hilo cuenta algo y stats_report los suma cuando ya no queda ningún hilo
+// trabajando.
+
+typedef enum {
+    STATS_READ,
+    STATS_LEX,
+    STATS_PARSE,
+    STATS_RESOLVE,
+    STATS_TYPES,
+    STATS_OPTIMIZE,
+    STATS_TEARDOWN,
+    STATS_PHASE_COUNT
+} StatsPhase;
+
+#ifdef PYCLITE_STATS
+
+typedef struct StatsBlock StatsBlock;
+
+struct StatsBlock {
+    StatsBlock *next;
+    double seconds[STATS_PHASE_COUNT];
+    size_t files;
+    size_t cache_hits;
+    size_t tokens[TOKEN_UNKNOWN + 1];
+    size_t nodes[AST_COMMENT + 1];
+    size_t heap_allocations;
+    size_t heap_bytes;
+    size_t arena_allocations;
+    size_t arena_bytes;
+};
+
+StatsBlock *stats_local(void);
+void stats_count_tokens(const TokenBuffer *tokens);
+
+#define STATS_TIMER(var) double var = stats_now()
+#define STATS_PHASE(phase, var) (stats_local()->seconds[(phase)] += stats_now() - (var))
+#define STATS_COUNT(field) (stats_local()->field++)
+#define STATS_NODE(type) (stats_local()->nodes[(type)]++)
+#define STATS_HEAP_ALLOC(size) (stats_local()->heap_allocations++, stats_local()->heap_bytes += (size))
+#define STATS_ARENA_ALLOC(size) (stats_local()->arena_allocations++, stats_local()->arena_bytes += (size))
+#define STATS_TOKENS(buffer) stats_count_tokens(buffer)
+
+#else
+
+#define STATS_TIMER(var) ((void)0)
+#define STATS_PHASE(phase, var) ((void)0)
+#define STATS_COUNT(field) ((void)0)
+#define STATS_NODE(type) ((void)0)
+#define STATS_HEAP_ALLOC(size) ((void)0)
+#define STATS_ARENA_ALLOC(size) ((void)0)
+#define STATS_TOKENS(buffer) ((void)0)
+
+#endif
+
+bool stats_enabled(void);
+// Reloj monótono en segundos; existe también sin PYCLITE_STATS.
+double stats_now(void);
+// Escribe el informe JSON con los contadores de todos los hilos. wall_seconds
+// es el tiempo total de la ejecución medido por el llamante.
+void stats_report(FILE *stream, double wall_seconds);
+
+#endif // PYCLITE_STATS_H
@@ -0,0 +1,1045 @@
+#include "types.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Especializaciones de una misma func antes de recurrir a la que tiene todos
+// los parámetros VALUE_DYNAMIC: acota las combinaciones de las recursivas.
+#define TYPES_MAX_SPECIALIZATIONS 8
+// Una llamada analiza en el acto la especialización nueva que necesita, para
+// que quien llama ya vea su resultado; pasada esta profundidad, la deja en la
+// cola y quien llama se repite cuando esté.
+#define TYPES_MAX_NESTING 32
+#define TYPES_NONE UINT32_MAX
+
+typedef enum {
+    DECLARATION_UNSEEN,
+    // int, float, char o bool: el tipo declarado.
+    DECLARATION_FIXED,
+    // array: se infiere el tipo de sus elementos.
+    DECLARATION_ARRAY,
+    DECLARATION_FUNC,
+    // Parámetro o iterador: se infiere todo.
+    DECLARATION_FREE
+} TypeDeclarationKind;
+
+struct TypeDeclaration {
+    TypeDeclarationKind kind;
+    ValueType declared;
+    // Func (0 es el programa) a cuyo marco pertenece, y su posición en los
+    // locals de las especializaciones de esa func.
+    uint32_t function;
+    uint32_t local;
+    // DECLARATION_FUNC: la func que nombra.
+    uint32_t target;
+};
+
+struct TypeFunction {
+    ASTNode *node;
+    uint32_t parent;
+    uint32_t param_count;
+    uint32_t local_count;
+    uint32_t *specializations;
+    size_t specialization_count;
+    size_t specialization_capacity;
+    // Alguna de sus especializaciones ya anotó el árbol.
+    bool recorded;
+};
+
+struct TypeState {
+    uint32_t function;
+    // Tipo de cada declaración propia; en las array, el de sus elementos.
+    TypeInfo *locals;
+    // Especializaciones que leyeron sus variables o su resultado y que hay que
+    // repetir si cambian.
+    uint32_t *dependents;
+    size_t dependent_count;
+    size_t dependent_capacity;
+    // Última pasada que se apuntó en dependents.
+    uint64_t registered;
+    bool analyzed;
+    bool active;
+    bool queued;
+    // Sus variables cambiaron mientras se analizaba: hay que repetir la pasada.
+    bool changed;
+    bool recorded;
+    // Creada al analizar una func que nunca se llama: no puede ensanchar las
+    // variables de las especializaciones de verdad.
+    bool detached;
+};
+
+struct TypeFrame {
+    ASTNode *node;
+    uint32_t next;
+    size_t base;
+};
+
+// Especialización que se está recorriendo y pasada con la que se apunta como
+// dependiente de lo que lee.
+typedef struct {
+    uint32_t specialization;
+    uint64_t pass;
+} TypeWalk;
+
+static bool types_statement(TypeInference *types, const TypeWalk *walk, ASTNode *node);
+static bool types_analyze(TypeInference *types, uint32_t specialization);
+
+// Asegura sitio para un elemento más en un arreglo que crece al doble.
+// Devuelve el arreglo (quizá movido) o NULL si no hay memoria; en ese caso el
+// original sigue siendo válido.
+static void *types_grow(void *items, size_t count, size_t *capacity, size_t size) {
+    if (count < *capacity) {
+        return items;
+    }
+    size_t grown_capacity = *capacity ? *capacity * 2 : 64;
+    void *grown = realloc(items, grown_capacity * size);
+    if (grown) {
+        *capacity = grown_capacity;
+    }
+    return grown;
+}
+
+void types_init(TypeInference *types) {
+    types->specializations = NULL;
+    types->specialization_count = 0;
+    memset(&types->summary, 0, sizeof(types->summary));
+    types->source = NULL;
+    types->states = NULL;
+    types->specialization_capacity = 0;
+    types->declarations = NULL;
+    types->declaration_count = 0;
+    types->functions = NULL;
+    types->function_count = 0;
+    types->function_capacity = 0;
+    types->queue = NULL;
+    types->queue_count = 0;
+    types->queue_capacity = 0;
+    types->frames = NULL;
+    types->frame_count = 0;
+    types->frame_capacity = 0;
+    types->values = NULL;
+    types->value_count = 0;
+    types->value_capacity = 0;
+    types->pass = 0;
+    types->nesting = 0;
+    types->recording = false;
+}
+
+// Vacía el resultado anterior conservando los arreglos de trabajo.
+static void types_clear(TypeInference *types) {
+    for (size_t i = 0; i < types->specialization_count; ++i) {
+        free(types->specializations[i].params);
+        free(types->states[i].locals);
+        free(types->states[i].dependents);
+    }
+    for (size_t i = 0; i < types->function_count; ++i) {
+        free(types->functions[i].specializations);
+    }
+    types->specialization_count = 0;
+    memset(&types->summary, 0, sizeof(types->summary));
+    types->function_count = 0;
+    types->queue_count = 0;
+    types->frame_count = 0;
+    types->value_count = 0;
+    types->nesting = 0;
+    types->recording = false;
+}
+
+void types_free(TypeInference *types) {
+    types_clear(types);
+    free(types->specializations);
+    free(types->states);
+    free(types->declarations);
+    free(types->functions);
+    free(types->queue);
+    free(types->frames);
+    free(types->values);
+    types_init(types);
+}
+
+static TypeInfo types_info(ValueType type) {
+    TypeInfo info = {type, VALUE_UNKNOWN};
+    return info;
+}
+
+static bool types_same(TypeInfo a, TypeInfo b) {
+    return a.type == b.type && a.element == b.element;
+}
+
+// VALUE_UNKNOWN es el neutro y VALUE_DYNAMIC absorbe: dos tipos concretos
+// distintos ya no son ninguno de los dos.
+static ValueType types_join(ValueType a, ValueType b) {
+    if (a == b || b == VALUE_UNKNOWN) {
+        return a;
+    }
+    if (a == VALUE_UNKNOWN) {
+        return b;
+    }
+    return VALUE_DYNAMIC;
+}
+
+static TypeInfo types_join_info(TypeInfo a, TypeInfo b) {
+    TypeInfo joined;
+    joined.type = types_join(a.type, b.type);
+    joined.element = joined.type == VALUE_ARRAY ? types_join(a.element, b.element) : VALUE_UNKNOWN;
+    return joined;
+}
+
+static bool types_is_integer(ValueType type) {
+    return type == VALUE_INT || type == VALUE_CHAR || type == VALUE_BOOL;
+}
+
+static bool types_is_number(ValueType type) {
+    return types_is_integer(type) || type == VALUE_FLOAT;
+}
+
+static ValueType types_arithmetic(ValueType left, ValueType right, bool integer_only) {
+    if (types_is_integer(left) && types_is_integer(right)) {
+        return VALUE_INT;
+    }
+    if (!integer_only && types_is_number(left) && types_is_number(right)) {
+        return VALUE_FLOAT;
+    }
+    return VALUE_DYNAMIC;
+}
+
+// Un operando VALUE_UNKNOWN aún no tiene valor (una recursión sin resolver):
+// el resultado tampoco.
+static ValueType types_binary(TokenType op, ValueType left, ValueType right) {
+    if (left == VALUE_UNKNOWN || right == VALUE_UNKNOWN) {
+        return VALUE_UNKNOWN;
+    }
+    switch (op) {
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+        case TOKEN_STAR:
+        case TOKEN_SLASH:
+            return types_arithmetic(left, right, false);
+        case TOKEN_PERCENT:
+            return types_arithmetic(left, right, true);
+        case TOKEN_EQEQ:
+        case TOKEN_BANGEQ:
+        case TOKEN_LT:
+        case TOKEN_LTE:
+        case TOKEN_GT:
+        case TOKEN_GTE:
+        case TOKEN_ANDAND:
+        case TOKEN_OROR:
+            return VALUE_BOOL;
+        default:
+            return VALUE_DYNAMIC;
+    }
+}
+
+static ValueType types_unary(TokenType op, ValueType operand) {
+    if (operand == VALUE_UNKNOWN) {
+        return VALUE_UNKNOWN;
+    }
+    switch (op) {
+        case TOKEN_MINUS:
+            return types_arithmetic(operand, VALUE_INT, false);
+        case TOKEN_BANG:
+            return VALUE_BOOL;
+        case TOKEN_PLUSPLUS:
+        case TOKEN_MINUSMINUS:
+            return operand == VALUE_INT || operand == VALUE_CHAR || operand == VALUE_FLOAT ? operand : VALUE_DYNAMIC;
+        default:
+            return VALUE_DYNAMIC;
+    }
+}
+
+static ValueType types_literal(const TypeInference *types, const ASTNode *node) {
+    switch (node->token.type) {
+        case TOKEN_NUMBER:
+            return memchr(types->source + node->token.offset, '.', node->token.length) ? VALUE_FLOAT : VALUE_INT;
+        case TOKEN_STRING:
+            return VALUE_STRING;
+        case TOKEN_CHAR:
+            return VALUE_CHAR;
+        case TOKEN_TRUE:
+        case TOKEN_FALSE:
+            return VALUE_BOOL;
+        default:
+            return VALUE_DYNAMIC;
+    }
+}
+
+static ValueType types_declared(TokenType keyword) {
+    switch (keyword) {
+        case TOKEN_KW_INT:
+            return VALUE_INT;
+        case TOKEN_KW_FLOAT:
+            return VALUE_FLOAT;
+        case TOKEN_KW_CHAR:
+            return VALUE_CHAR;
+        case TOKEN_KW_BOOL:
+            return VALUE_BOOL;
+        default:
+            return VALUE_DYNAMIC;
+    }
+}
+
+static bool types_push_queue(TypeInference *types, uint32_t specialization) {
+    uint32_t *queue = (uint32_t *)types_grow(types->queue, types->queue_count, &types->queue_capacity,
+                                             sizeof(uint32_t));
+    if (!queue) {
+        return false;
+    }
+    types->queue = queue;
+    types->queue[types->queue_count++] = specialization;
+    return true;
+}
+
+// Hace que la especialización se analice otra vez: en el acto si está en
+// curso, o desde la cola.
+static bool types_revisit(TypeInference *types, uint32_t specialization) {
+    TypeState *state = &types->states[specialization];
+    if (state->active) {
+        state->changed = true;
+        return true;
+    }
+    if (state->queued) {
+        return true;
+    }
+    state->queued = true;
+    return types_push_queue(types, specialization);
+}
+
+// Sus dependientes se repiten y, al hacerlo, vuelven a apuntarse.
+static bool types_notify(TypeInference *types, uint32_t specialization) {
+    TypeState *state = &types->states[specialization];
+    for (size_t i = 0; i < state->dependent_count; ++i) {
+        if (!types_revisit(types, state->dependents[i])) {
+            return false;
+        }
+    }
+    state->dependent_count = 0;
+    state->registered = 0;
+    return true;
+}
+
+static bool types_depend(TypeInference *types, const TypeWalk *walk, uint32_t specialization) {
+    TypeState *state = &types->states[specialization];
+    if (types->recording || state->registered == walk->pass) {
+        return true;
+    }
+    uint32_t *dependents = (uint32_t *)types_grow(state->dependents, state->dependent_count,
+                                                  &state->dependent_capacity, sizeof(uint32_t));
+    if (!dependents) {
+        return false;
+    }
+    state->dependents = dependents;
+    state->dependents[state->dependent_count++] = walk->specialization;
+    state->registered = walk->pass;
+    return true;
+}
+
+// Especialización de function en la cadena de las que contienen a specialization.
+static uint32_t types_owner(const TypeInference *types, uint32_t specialization, uint32_t function) {
+    while (types->states[specialization].function != function) {
+        if (specialization == 0) {
+            return TYPES_NONE;
+        }
+        specialization = types->specializations[specialization].parent;
+    }
+    return specialization;
+}
+
+static bool types_read(TypeInference *types, const TypeWalk *walk, const ASTNode *identifier, TypeInfo *value) {
+    *value = types_info(VALUE_DYNAMIC);
+    if (identifier->declaration >= types->declaration_count) {
+        return true;
+    }
+    const TypeDeclaration *declaration = &types->declarations[identifier->declaration];
+    switch (declaration->kind) {
+        case DECLARATION_FIXED:
+            *value = types_info(declaration->declared);
+            return true;
+        case DECLARATION_FUNC:
+            *value = types_info(VALUE_FUNC);
+            return true;
+        case DECLARATION_UNSEEN:
+            return true;
+        default:
+            break;
+    }
+    uint32_t owner = types_owner(types, walk->specialization, declaration->function);
+    if (owner == TYPES_NONE) {
+        return true;
+    }
+    *value = types->states[owner].locals[declaration->local];
+    if (declaration->kind == DECLARATION_ARRAY) {
+        value->type = VALUE_ARRAY;
+    }
+    return owner == walk->specialization || types_depend(types, walk, owner);
+}
+
+// Las variables con tipo declarado no cambian; las demás se ensanchan con
+// cada valor que reciben.
+static bool types_assign(TypeInference *types, const TypeWalk *walk, const ASTNode *identifier, TypeInfo value) {
+    if (types->recording || identifier->declaration >= types->declaration_count) {
+        return true;
+    }
+    const TypeDeclaration *declaration = &types->declarations[identifier->declaration];
+    if (declaration->kind == DECLARATION_ARRAY) {
+        if (value.type != VALUE_ARRAY) {
+            return true;
+        }
+    } else if (declaration->kind != DECLARATION_FREE) {
+        return true;
+    }
+    uint32_t owner = types_owner(types, walk->specialization, declaration->function);
+    if (owner == TYPES_NONE ||
+        (types->states[walk->specialization].detached && !types->states[owner].detached)) {
+        return true;
+    }
+    TypeInfo *local = &types->states[owner].locals[declaration->local];
+    TypeInfo joined = types_join_info(*local, value);
+    if (types_same(joined, *local)) {
+        return true;
+    }
+    *local = joined;
+    return types_revisit(types, owner) && types_notify(types, owner);
+}
+
+static bool types_return(TypeInference *types, const TypeWalk *walk, TypeInfo value) {
+    if (types->recording) {
+        return true;
+    }
+    TypeSpecialization *specialization = &types->specializations[walk->specialization];
+    TypeInfo joined = types_join_info(specialization->result, value);
+    if (types_same(joined, specialization->result)) {
+        return true;
+    }
+    specialization->result = joined;
+    return types_notify(types, walk->specialization);
+}
+
+static void types_record(TypeInference *types, ASTNode *node, TypeInfo value) {
+    if (types->recording) {
+        node->value_type = types_join(node->value_type, value.type);
+    }
+}
+
+static bool types_reserve_values(TypeInference *types, size_t extra) {
+    if (types->value_count + extra <= types->value_capacity) {
+        return true;
+    }
+    size_t capacity = types->value_capacity ? types->value_capacity : 64;
+    while (capacity < types->value_count + extra) {
+        capacity *= 2;
+    }
+    TypeInfo *values = (TypeInfo *)realloc(types->values, capacity * sizeof(TypeInfo));
+    if (!values) {
+        return false;
+    }
+    types->values = values;
+    types->value_capacity = capacity;
+    return true;
+}
+
+static bool types_push_value(TypeInference *types, TypeInfo value) {
+    if (!types_reserve_values(types, 1)) {
+        return false;
+    }
+    types->values[types->value_count++] = value;
+    return true;
+}
+
+static uint32_t types_find(const TypeInference *types, uint32_t function, uint32_t parent, const TypeInfo *key) {
+    const TypeFunction *target = &types->functions[function];
+    for (size_t i = 0; i < target->specialization_count; ++i) {
+        const TypeSpecialization *specialization = &types->specializations[target->specializations[i]];
+        if (specialization->parent != parent) {
+            continue;
+        }
+        uint32_t p = 0;
+        while (p < target->param_count && types_same(specialization->params[p], key[p])) {
+            p++;
+        }
+        if (p == target->param_count) {
+            return target->specializations[i];
+        }
+    }
+    return TYPES_NONE;
+}
+
+static bool types_create(TypeInference *types, uint32_t function, uint32_t parent, const TypeInfo *key,
+                         bool detached, uint32_t *created) {
+    if (types->specialization_count == types->specialization_capacity) {
+        size_t capacity = types->specialization_capacity ? types->specialization_capacity * 2 : 64;
+        TypeSpecialization *specializations = (TypeSpecialization *)realloc(
+            types->specializations, capacity * sizeof(TypeSpecialization));
+        if (!specializations) {
+            return false;
+        }
+        types->specializations = specializations;
+        TypeState *states = (TypeState *)realloc(types->states, capacity * sizeof(TypeState));
+        if (!states) {
+            return false;
+        }
+        types->states = states;
+        types->specialization_capacity = capacity;
+    }
+    TypeFunction *target = &types->functions[function];
+    uint32_t *list = (uint32_t *)types_grow(target->specializations, target->specialization_count,
+                                            &target->specialization_capacity, sizeof(uint32_t));
+    if (!list) {
+        return false;
+    }
+    target->specializations = list;
+    TypeInfo *params = target->param_count ? (TypeInfo *)malloc(target->param_count * sizeof(TypeInfo)) : NULL;
+    TypeInfo *locals = target->local_count ? (TypeInfo *)calloc(target->local_count, sizeof(TypeInfo)) : NULL;
+    if ((target->param_count && !params) || (target->local_count && !locals)) {
+        free(params);
+        free(locals);
+        return false;
+    }
+    uint32_t index = (uint32_t)types->specialization_count++;
+    target->specializations[target->specialization_count++] = index;
+
+    TypeSpecialization *specialization = &types->specializations[index];
+    specialization->function = target->node;
+    specialization->parent = parent;
+    specialization->params = params;
+    specialization->param_count = target->param_count;
+    specialization->result = types_info(VALUE_UNKNOWN);
+    TypeState *state = &types->states[index];
+    state->function = function;
+    state->locals = locals;
+    state->dependents = NULL;
+    state->dependent_count = 0;
+    state->dependent_capacity = 0;
+    state->registered = 0;
+    state->analyzed = false;
+    state->active = false;
+    state->queued = false;
+    state->changed = false;
+    state->recorded = false;
+    state->detached = detached;
+    // Los parámetros parten del tipo de su argumento.
+    for (uint32_t p = 0; p < target->param_count; ++p) {
+        params[p] = key[p];
+        uint32_t declaration = target->node->children[1]->children[p]->declaration;
+        if (declaration < types->declaration_count && types->declarations[declaration].function == function) {
+            TypeInfo *local = &locals[types->declarations[declaration].local];
+            *local = types_join_info(*local, key[p]);
+        }
+    }
+    *created = index;
+    return true;
+}
+
+// Llamada a una func: los argumentos están en values desde base. Busca (o crea
+// y analiza) la especialización para sus tipos; el resultado es lo que esta
+// devuelve.
+static bool types_call(TypeInference *types, const TypeWalk *walk, ASTNode *node, size_t base, TypeInfo *result) {
+    *result = types_info(VALUE_DYNAMIC);
+    const ASTNode *callee = node->children[0];
+    if (callee->declaration >= types->declaration_count ||
+        types->declarations[callee->declaration].kind != DECLARATION_FUNC) {
+        return true;
+    }
+    const TypeDeclaration *declaration = &types->declarations[callee->declaration];
+    uint32_t function = declaration->target;
+    uint32_t parent = types_owner(types, walk->specialization, declaration->function);
+    if (parent == TYPES_NONE) {
+        return true;
+    }
+    // La clave: un tipo por parámetro; los que no reciben argumento, dinámicos.
+    uint32_t param_count = types->functions[function].param_count;
+    size_t arg_count = types->value_count - base;
+    size_t key = types->value_count;
+    if (!types_reserve_values(types, param_count)) {
+        return false;
+    }
+    for (uint32_t p = 0; p < param_count; ++p) {
+        types->values[key + p] = p < arg_count ? types->values[base + p] : types_info(VALUE_DYNAMIC);
+    }
+    uint32_t specialization = types_find(types, function, parent, &types->values[key]);
+    if (specialization == TYPES_NONE && !types->recording) {
+        if (types->functions[function].specialization_count >= TYPES_MAX_SPECIALIZATIONS) {
+            for (uint32_t p = 0; p < param_count; ++p) {
+                types->values[key + p] = types_info(VALUE_DYNAMIC);
+            }
+            specialization = types_find(types, function, parent, &types->values[key]);
+        }
+        if (specialization == TYPES_NONE &&
+            !types_create(types, function, parent, &types->values[key],
+                          types->states[walk->specialization].detached, &specialization)) {
+            return false;
+        }
+    }
+    if (specialization == TYPES_NONE) {
+        return true;
+    }
+
+    if (types->recording) {
+        if (node->specialization != specialization) {
+            node->specialization = node->specialization == TYPES_NO_SPECIALIZATION ? specialization
+                                                                                   : TYPES_MIXED_SPECIALIZATION;
+        }
+        if (!types->states[specialization].recorded && !types_push_queue(types, specialization)) {
+            return false;
+        }
+    } else if (!types->states[specialization].analyzed) {
+        if (types->nesting < TYPES_MAX_NESTING) {
+            types->nesting++;
+            bool analyzed = types_analyze(types, specialization);
+            types->nesting--;
+            if (!analyzed) {
+                return false;
+            }
+        } else if (!types_revisit(types, specialization)) {
+            return false;
+        }
+    }
+    *result = types->specializations[specialization].result;
+    return types_depend(types, walk, specialization);
+}
+
+// Nodo cuyos hijos son los operandos de node, o NULL si no tiene.
+static const ASTNode *types_operands(const ASTNode *node) {
+    switch (node->type) {
+        case AST_EXPRESSION:
+        case AST_ARRAY_LITERAL:
+            return node;
+        case AST_CALL:
+            // csay y cread: argumentos y destino; las demás: nombre y argumentos.
+            if (node->token.type == TOKEN_KW_CSAY || node->token.type == TOKEN_KW_CREAD) {
+                return node->children[0];
+            }
+            return node->children[1];
+        default:
+            return NULL;
+    }
+}
+
+// Tipo de node a partir de los de sus operandos, que están en values desde base.
+static bool types_combine(TypeInference *types, const TypeWalk *walk, ASTNode *node, size_t base,
+                          TypeInfo *result) {
+    const TypeInfo *operands = &types->values[base];
+    switch (node->type) {
+        case AST_EXPRESSION:
+            if (node->child_count == 2) {
+                *result = types_info(types_binary(node->token.type, operands[0].type, operands[1].type));
+            } else if (node->child_count == 1) {
+                *result = types_info(types_unary(node->token.type, operands[0].type));
+            } else {
+                *result = types_info(VALUE_DYNAMIC);
+            }
+            return true;
+        case AST_ARRAY_LITERAL: {
+            ValueType element = VALUE_UNKNOWN;
+            for (size_t i = base; i < types->value_count; ++i) {
+                element = types_join(element, types->values[i].type);
+            }
+            result->type = VALUE_ARRAY;
+            result->element = element;
+            return true;
+        }
+        case AST_CALL:
+            if (node->token.type == TOKEN_KW_CSAY || node->token.type == TOKEN_KW_CREAD) {
+                *result = types_info(VALUE_VOID);
+                // Lo que lee cread puede ser cualquier cosa.
+                return node->token.type != TOKEN_KW_CREAD || node->child_count < 2 ||
+                       types_assign(types, walk, node->children[1], types_info(VALUE_DYNAMIC));
+            }
+            return types_call(types, walk, node, base, result);
+        default:
+            *result = types_info(VALUE_DYNAMIC);
+            return true;
+    }
+}
+
+static bool types_push_frame(TypeInference *types, ASTNode *node) {
+    TypeFrame *frames = (TypeFrame *)types_grow(types->frames, types->frame_count, &types->frame_capacity,
+                                                sizeof(TypeFrame));
+    if (!frames) {
+        return false;
+    }
+    types->frames = frames;
+    TypeFrame *frame = &types->frames[types->frame_count++];
+    frame->node = node;
+    frame->next = 0;
+    frame->base = types->value_count;
+    return true;
+}
+
+// Las hojas se resuelven en el acto; el resto abre un marco.
+static bool types_push_node(TypeInference *types, const TypeWalk *walk, ASTNode *node) {
+    if (node->type == AST_LITERAL || node->type == AST_IDENTIFIER) {
+        TypeInfo value = types_info(VALUE_UNKNOWN);
+        if (node->type == AST_LITERAL) {
+            value = types_info(types_literal(types, node));
+        } else if (!types_read(types, walk, node, &value)) {
+            return false;
+        }
+        types_record(types, node, value);
+        return types_push_value(types, value);
+    }
+    return types_push_frame(types, node);
+}
+
+// Postorden con pilas propias. Una llamada puede analizar otra especialización
+// en medio; esta usa las pilas por encima de lo que hay, así que aquí solo se
+// guardan índices.
+static bool types_eval(TypeInference *types, const TypeWalk *walk, ASTNode *root, TypeInfo *value) {
+    size_t frame_base = types->frame_count;
+    size_t value_base = types->value_count;
+    if (!types_push_node(types, walk, root)) {
+        return false;
+    }
+    while (types->frame_count > frame_base) {
+        TypeFrame *frame = &types->frames[types->frame_count - 1];
+        const ASTNode *operands = types_operands(frame->node);
+        if (operands && frame->next < operands->child_count) {
+            if (!types_push_node(types, walk, operands->children[frame->next++])) {
+                return false;
+            }
+            continue;
+        }
+        ASTNode *node = frame->node;
+        size_t base = frame->base;
+        types->frame_count--;
+        TypeInfo result;
+        if (!types_combine(types, walk, node, base, &result)) {
+            return false;
+        }
+        types->value_count = base;
+        types_record(types, node, result);
+        if (!types_push_value(types, result)) {
+            return false;
+        }
+    }
+    *value = types->values[value_base];
+    types->value_count = value_base;
+    return true;
+}
+
+static bool types_statements(TypeInference *types, const TypeWalk *walk, ASTNode *list) {
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        if (!types_statement(types, walk, list->children[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool types_statement(TypeInference *types, const TypeWalk *walk, ASTNode *node) {
+    TypeInfo value;
+    switch (node->type) {
+        case AST_DECLARATION:
+        case AST_ASSIGNMENT:
+            return types_eval(types, walk, node->children[1], &value) &&
+                   types_assign(types, walk, node->children[0], value);
+        case AST_IF:
+        case AST_WHILE:
+            return types_eval(types, walk, node->children[0], &value) &&
+                   types_statements(types, walk, node->children[1]);
+        case AST_FOR: {
+            // Hijos: iterador, iterable y cuerpo. Los elementos de un arreglo
+            // de arreglos no guardan el tipo de los suyos.
+            ASTNode *iterable = node->children[1];
+            if (!types_read(types, walk, iterable, &value)) {
+                return false;
+            }
+            types_record(types, iterable, value);
+            TypeInfo item = types_info(VALUE_DYNAMIC);
+            if (value.type == VALUE_ARRAY) {
+                item = types_info(value.element);
+                if (value.element == VALUE_ARRAY) {
+                    item.element = VALUE_DYNAMIC;
+                }
+            } else if (value.type == VALUE_UNKNOWN) {
+                item = types_info(VALUE_UNKNOWN);
+            }
+            return types_assign(types, walk, node->children[0], item) &&
+                   types_statements(types, walk, node->children[2]);
+        }
+        case AST_RETURN:
+            return types_eval(types, walk, node->children[0], &value) && types_return(types, walk, value);
+        case AST_EXPRESSION:
+            if (!types_eval(types, walk, node->children[0], &value)) {
+                return false;
+            }
+            types_record(types, node, value);
+            return true;
+        case AST_CALL:
+            return types_eval(types, walk, node, &value);
+        default:
+            // Las func se analizan en cada llamada; los comentarios no tienen tipo.
+            return true;
+    }
+}
+
+// Una pasada por el cuerpo de la especialización.
+static bool types_walk(TypeInference *types, uint32_t specialization) {
+    TypeWalk walk = {specialization, ++types->pass};
+    ASTNode *node = types->functions[types->states[specialization].function].node;
+    if (node->type != AST_FUNCTION) {
+        return node->child_count == 0 || types_statements(types, &walk, node->children[0]);
+    }
+    // Hijos de AST_FUNCTION: nombre, parámetros, cuerpo y return opcional.
+    ASTNode *body = node->children[2];
+    if (!types_statements(types, &walk, body) ||
+        (node->child_count > 3 && !types_statement(types, &walk, node->children[3]))) {
+        return false;
+    }
+    // Si ningún return está directamente en el cuerpo, la función puede
+    // acabar sin devolver nada.
+    bool returns = node->child_count > 3;
+    for (uint32_t i = 0; i < body->child_count && !returns; ++i) {
+        returns = body->children[i]->type == AST_RETURN;
+    }
+    return returns || types_return(types, &walk, types_info(VALUE_VOID));
+}
+
+static bool types_analyze(TypeInference *types, uint32_t specialization) {
+    TypeState *state = &types->states[specialization];
+    state->queued = false;
+    state->analyzed = true;
+    state->active = true;
+    do {
+        types->states[specialization].changed = false;
+        if (!types_walk(types, specialization)) {
+            return false;
+        }
+    } while (types->states[specialization].changed);
+    types->states[specialization].active = false;
+    return true;
+}
+
+static bool types_drain(TypeInference *types) {
+    while (types->queue_count > 0) {
+        uint32_t specialization = types->queue[--types->queue_count];
+        if (types->states[specialization].queued && !types_analyze(types, specialization)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Con todo estable, una última pasada anota el árbol desde first y las
+// especializaciones a las que llega.
+static bool types_record_from(TypeInference *types, uint32_t first) {
+    types->recording = true;
+    bool ok = types_push_queue(types, first);
+    while (ok && types->queue_count > 0) {
+        uint32_t specialization = types->queue[--types->queue_count];
+        if (types->states[specialization].recorded) {
+            continue;
+        }
+        types->states[specialization].recorded = true;
+        types->functions[types->states[specialization].function].recorded = true;
+        ok = types_walk(types, specialization);
+    }
+    types->recording = false;
+    return ok;
+}
+
+// Una func a la que nada llama se analiza con parámetros dinámicos dentro de
+// una especialización cualquiera de la func que la contiene.
+static bool types_cover(TypeInference *types, uint32_t function) {
+    const TypeFunction *outer = &types->functions[types->functions[function].parent];
+    uint32_t parent = TYPES_NONE;
+    for (size_t i = 0; i < outer->specialization_count && parent == TYPES_NONE; ++i) {
+        if (types->states[outer->specializations[i]].recorded) {
+            parent = outer->specializations[i];
+        }
+    }
+    if (parent == TYPES_NONE) {
+        return true;
+    }
+    uint32_t param_count = types->functions[function].param_count;
+    if (!types_reserve_values(types, param_count)) {
+        return false;
+    }
+    for (uint32_t p = 0; p < param_count; ++p) {
+        types->values[p] = types_info(VALUE_DYNAMIC);
+    }
+    uint32_t specialization = types_find(types, function, parent, types->values);
+    if (specialization == TYPES_NONE && !types_create(types, function, parent, types->values, true, &specialization)) {
+        return false;
+    }
+    if (!types->states[specialization].analyzed && !types_analyze(types, specialization)) {
+        return false;
+    }
+    return types_drain(types) && types_record_from(types, specialization);
+}
+
+static bool types_add_function(TypeInference *types, ASTNode *node, uint32_t parent, uint32_t *index) {
+    TypeFunction *functions = (TypeFunction *)types_grow(types->functions, types->function_count,
+                                                         &types->function_capacity, sizeof(TypeFunction));
+    if (!functions) {
+        return false;
+    }
+    types->functions = functions;
+    TypeFunction *function = &types->functions[types->function_count];
+    function->node = node;
+    function->parent = parent;
+    function->param_count = node->type == AST_FUNCTION ? node->children[1]->child_count : 0;
+    function->local_count = 0;
+    function->specializations = NULL;
+    function->specialization_count = 0;
+    function->specialization_capacity = 0;
+    function->recorded = false;
+    *index = (uint32_t)types->function_count++;
+    return true;
+}
+
+static void types_declare(TypeInference *types, const ASTNode *identifier, uint32_t function,
+                          TypeDeclarationKind kind, ValueType declared, uint32_t target) {
+    if (identifier->declaration >= types->declaration_count) {
+        return;
+    }
+    TypeDeclaration *declaration = &types->declarations[identifier->declaration];
+    if (declaration->kind == DECLARATION_UNSEEN) {
+        declaration->function = function;
+        declaration->local = types->functions[function].local_count++;
+    }
+    // Un nombre repetido en el mismo ámbito comparte número: vale el último.
+    declaration->kind = kind;
+    declaration->declared = declared;
+    declaration->target = target;
+}
+
+// Registra las func y a quién pertenece cada declaración. Solo recorre
+// instrucciones, cuyo anidamiento ya acotó el parser recursivo.
+static bool types_collect(TypeInference *types, ASTNode *list, uint32_t function) {
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        ASTNode *node = list->children[i];
+        switch (node->type) {
+            case AST_DECLARATION:
+                if (node->token.type == TOKEN_KW_ARRAY) {
+                    types_declare(types, node->children[0], function, DECLARATION_ARRAY, VALUE_ARRAY, 0);
+                } else {
+                    types_declare(types, node->children[0], function, DECLARATION_FIXED,
+                                  types_declared(node->token.type), 0);
+                }
+                break;
+            case AST_FUNCTION: {
+                uint32_t index;
+                if (!types_add_function(types, node, function, &index)) {
+                    return false;
+                }
+                types_declare(types, node->children[0], function, DECLARATION_FUNC, VALUE_FUNC, index);
+                const ASTNode *params = node->children[1];
+                for (uint32_t p = 0; p < params->child_count; ++p) {
+                    types_declare(types, params->children[p], index, DECLARATION_FREE, VALUE_UNKNOWN, 0);
+                }
+                if (!types_collect(types, node->children[2], index)) {
+                    return false;
+                }
+                break;
+            }
+            case AST_FOR:
+                types_declare(types, node->children[0], function, DECLARATION_FREE, VALUE_UNKNOWN, 0);
+                if (!types_collect(types, node->children[2], function)) {
+                    return false;
+                }
+                break;
+            case AST_IF:
+            case AST_WHILE:
+                if (!types_collect(types, node->children[1], function)) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+// Si node, hijo index de parent, produce un valor que cuenta como expresión.
+static bool types_is_expression(const ASTNode *parent, uint32_t index, const ASTNode *node) {
+    switch (node->type) {
+        case AST_EXPRESSION:
+            // En una lista de instrucciones es el envoltorio de una expresión suelta.
+            return parent->type != AST_INSTRUCTION_LIST;
+        case AST_LITERAL:
+        case AST_ARRAY_LITERAL:
+            return true;
+        case AST_CALL:
+            return node->token.type != TOKEN_KW_CSAY && node->token.type != TOKEN_KW_CREAD;
+        case AST_IDENTIFIER:
+            // Solo las lecturas: no los nombres que se declaran, asignan o llaman.
+            switch (parent->type) {
+                case AST_EXPRESSION:
+                case AST_ARG_LIST:
+                case AST_ARRAY_LITERAL:
+                case AST_RETURN:
+                    return true;
+                case AST_IF:
+                case AST_WHILE:
+                    return index == 0;
+                case AST_DECLARATION:
+                case AST_ASSIGNMENT:
+                case AST_FOR:
+                    return index == 1;
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
+
+static bool types_summarize(TypeInference *types, ASTNode *program) {
+    TypeSummary *summary = &types->summary;
+    for (size_t i = 0; i < types->specialization_count; ++i) {
+        summary->specializations += i > 0 && types->states[i].recorded;
+    }
+    if (!types_push_frame(types, program)) {
+        return false;
+    }
+    while (types->frame_count > 0) {
+        ASTNode *node = types->frames[--types->frame_count].node;
+        for (uint32_t i = 0; i < node->child_count; ++i) {
+            ASTNode *child = node->children[i];
+            if (types_is_expression(node, i, child)) {
+                bool typed = child->value_type != VALUE_UNKNOWN && child->value_type != VALUE_DYNAMIC;
+                summary->expressions++;
+                summary->typed_expressions += typed;
+                if (child->type == AST_EXPRESSION) {
+                    summary->operators++;
+                    summary->typed_operators += typed;
+                }
+            }
+            if (!types_push_frame(types, child)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool types_infer(TypeInference *types, ASTNode *program, size_t declaration_count, const char *source) {
+    types_clear(types);
+    types->source = source;
+    free(types->declarations);
+    types->declarations = (TypeDeclaration *)calloc(declaration_count ? declaration_count : 1,
+                                                    sizeof(TypeDeclaration));
+    types->declaration_count = types->declarations ? declaration_count : 0;
+    if (!types->declarations) {
+        return false;
+    }
+    uint32_t function;
+    uint32_t root;
+    bool ok = types_add_function(types, program, 0, &function) &&
+              (program->child_count == 0 || types_collect(types, program->children[0], function)) &&
+              types_create(types, function, 0, NULL, false, &root) && types_analyze(types, root) &&
+              types_drain(types) && types_record_from(types, root);
+    // Las func quedan en orden de aparición: la que contiene a otra va antes.
+    for (uint32_t f = 1; ok && f < types->function_count; ++f) {
+        ok = types->functions[f].recorded || types_cover(types, f);
+    }
+    ok = ok && types_summarize(types, program);
+    types->queue_count = 0;
+    types->frame_count = 0;
+    types->value_count = 0;
+    types->nesting = 0;
+    types->recording = false;
+    return ok;
+}
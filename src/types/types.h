@@ -0,0 +1,115 @@
+#ifndef PYCLITE_TYPES_H
+#define PYCLITE_TYPES_H
+
+#include "ast/ast.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Inferencia estática de tipos sobre un árbol recién resuelto (resolver.h).
+//
+// Las variables int, float, char y bool tienen el tipo con que se declaran; de
+// las array se infiere el tipo de sus elementos. Los parámetros de func y los
+// iteradores de for no llevan tipo: se infiere sin mirar el flujo, como la
+// unión de todo lo que se les asigna en cualquier punto.
+//
+// Cada func se analiza aparte para cada combinación de tipos de argumentos con
+// que se la llama (una especialización): una función llamada con int y con
+// float tiene un cuerpo entero y otro real. La recursión y las variables que
+// se ensanchan se resuelven iterando hasta un punto fijo. Las func que nunca se
+// llaman se analizan con parámetros VALUE_DYNAMIC, y lo que asignan a variables
+// de fuera no las ensancha.
+//
+// Reglas, como en C: + - * / entre int, char y bool dan int, y float si algún
+// operando es float; % solo entre enteros; comparaciones, ==, !=, &&, || y !
+// dan bool; el ++ y el -- conservan el tipo. Cualquier otra combinación es
+// VALUE_DYNAMIC.
+//
+// Al terminar, cada expresión lleva en value_type la unión de sus tipos en las
+// especializaciones alcanzables: un tipo concreto si en todas coincide y
+// VALUE_DYNAMIC si no. Cada AST_CALL a una func lleva en specialization la
+// especialización a la que llama.
+
+// specialization de las llamadas que no van a una func conocida, y de las que
+// llaman a especializaciones distintas según desde cuál se las alcance.
+#define TYPES_NO_SPECIALIZATION 0
+#define TYPES_MIXED_SPECIALIZATION UINT32_MAX
+
+typedef struct {
+    ValueType type;
+    // Tipo de los elementos cuando type es VALUE_ARRAY; VALUE_UNKNOWN si no.
+    ValueType element;
+} TypeInfo;
+
+typedef struct {
+    // AST_FUNCTION analizada; el AST_PROGRAM en la especialización 0.
+    const ASTNode *function;
+    // Especialización de la func que contiene a esta, de la que toma las
+    // variables de fuera.
+    uint32_t parent;
+    // Tipos de los argumentos, que junto con parent identifican la especialización.
+    TypeInfo *params;
+    uint32_t param_count;
+    // Tipo de lo que devuelve: VALUE_VOID si no devuelve nada.
+    TypeInfo result;
+} TypeSpecialization;
+
+typedef struct {
+    // Nodos que producen un valor: operadores, literales, lecturas de
+    // variables, arreglos y llamadas a func.
+    size_t expressions;
+    size_t typed_expressions;
+    // Solo los AST_EXPRESSION de operadores.
+    size_t operators;
+    size_t typed_operators;
+    // Especializaciones de func alcanzables.
+    size_t specializations;
+} TypeSummary;
+
+typedef struct TypeDeclaration TypeDeclaration;
+typedef struct TypeFunction TypeFunction;
+typedef struct TypeState TypeState;
+typedef struct TypeFrame TypeFrame;
+
+typedef struct {
+    TypeSpecialization *specializations;
+    size_t specialization_count;
+    TypeSummary summary;
+
+    // Texto del archivo, para distinguir los literales enteros de los reales.
+    const char *source;
+    // Por especialización: estado del análisis, en paralelo a specializations.
+    TypeState *states;
+    size_t specialization_capacity;
+    // Por número de declaración del resolvedor.
+    TypeDeclaration *declarations;
+    size_t declaration_count;
+    // La 0 es el programa.
+    TypeFunction *functions;
+    size_t function_count;
+    size_t function_capacity;
+    // Especializaciones pendientes de analizar (o de anotar, al final).
+    uint32_t *queue;
+    size_t queue_count;
+    size_t queue_capacity;
+    // Recorrido iterativo de las expresiones, que pueden anidarse sin límite.
+    TypeFrame *frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    TypeInfo *values;
+    size_t value_count;
+    size_t value_capacity;
+    uint64_t pass;
+    size_t nesting;
+    bool recording;
+} TypeInference;
+
+void types_init(TypeInference *types);
+void types_free(TypeInference *types);
+// Anota program, ya resuelto; declaration_count es el del Resolver y source el
+// texto que se parseó. Los identificadores sin resolver se tratan como
+// VALUE_DYNAMIC. Devuelve false si no hubo memoria.
+bool types_infer(TypeInference *types, ASTNode *program, size_t declaration_count, const char *source);
+
+#endif // PYCLITE_TYPES_H
@@ -0,0 +1,195 @@
+// Entradas rotas de la caché de ASTs: una entrada correcta se carga, y cada
+// copia con un campo del árbol corrompido (tipo o token inexistente, subárbol
+// que no avanza, que se sale del de su padre o de la raíz) o truncada debe
+// rechazarse y borrarse del directorio, para que la siguiente compilación la
+// vuelva a escribir.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache/ast_cache.h"
+#include "parser/parser.h"
+#include "source/source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char SOURCE[] = "int x = 1;\n"
+                             "if (x > 0) {\n"
+                             "    while (x < 10) {\n"
+                             "        x = x + (2 * x);\n"
+                             "    }\n"
+                             "}\n"
+                             "csay(x);\n";
+
+static size_t failures = 0;
+
+static void fail(const char *label, const char *what) {
+    failures++;
+    fprintf(stderr, "%s: %s\n", label, what);
+}
+
+static char *read_entry(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = (char *)malloc(*size);
+    if (data && fread(data, 1, *size, file) != *size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    return data;
+}
+
+static void write_entry(const char *path, const char *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(data, 1, size, file) != size) {
+        fprintf(stderr, "No se pudo escribir %s\n", path);
+        exit(1);
+    }
+    fclose(file);
+}
+
+static void set_u32(char *data, size_t offset, uint32_t value) {
+    memcpy(data + offset, &value, sizeof(value));
+}
+
+int main(void) {
+    char dir[] = "/tmp/test_cache_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    size_t length = sizeof(SOURCE) - 1;
+    uint64_t hash = source_hash(SOURCE, length);
+    char path[sizeof(dir) + 32];
+    snprintf(path, sizeof(path), "%s/%016llx.ast", dir, (unsigned long long)hash);
+
+    Parser parser;
+    parser_init(&parser, SOURCE, length);
+    FlatAST tree;
+    flat_ast_init(&tree);
+    if (!parser_parse_flat(&parser, &tree) || !ast_cache_store(dir, hash, length, &tree)) {
+        fprintf(stderr, "No se pudo guardar la entrada de referencia\n");
+        return 1;
+    }
+    uint32_t count = tree.count;
+    flat_ast_free(&tree);
+    parser_free(&parser);
+
+    // Posición de cada arreglo dentro del archivo, tomada de la proyección.
+    AstCacheEntry entry;
+    if (!ast_cache_load(dir, hash, length, &entry)) {
+        fprintf(stderr, "La entrada de referencia no se carga\n");
+        return 1;
+    }
+    const char *base = (const char *)entry.mapping;
+    size_t kinds = (size_t)((const char *)entry.ast.kinds - base);
+    size_t tokens = (size_t)((const char *)entry.ast.tokens - base);
+    size_t ends = (size_t)((const char *)entry.ast.subtree_end - base);
+    uint32_t token_count = entry.ast.token_count;
+    // Un nodo con hermano detrás: su subárbol puede crecer sin salirse del
+    // total pero sí del de su padre.
+    uint32_t nested = 0;
+    for (uint32_t i = 1; i < count && !nested; i++) {
+        uint32_t parent = 0;
+        for (uint32_t j = 0; j < i; j++) {
+            if (entry.ast.subtree_end[j] > i) {
+                parent = j;
+            }
+        }
+        if (parent > 0 && entry.ast.subtree_end[i] < entry.ast.subtree_end[parent]) {
+            nested = i;
+        }
+    }
+    uint32_t nested_parent_end = 0;
+    for (uint32_t j = 0; j < nested; j++) {
+        if (entry.ast.subtree_end[j] > nested) {
+            nested_parent_end = entry.ast.subtree_end[j];
+        }
+    }
+    ast_cache_release(&entry);
+    if (!nested) {
+        fprintf(stderr, "El árbol de referencia no tiene nodos anidados con hermanos\n");
+        return 1;
+    }
+
+    size_t size;
+    char *good = read_entry(path, &size);
+    if (!good) {
+        fprintf(stderr, "No se pudo leer %s\n", path);
+        return 1;
+    }
+    char *bad = (char *)malloc(size);
+    typedef struct {
+        const char *label;
+        size_t offset;
+        uint32_t value;
+    } Corruption;
+    const Corruption corruptions[] = {
+        {"tipo de nodo inexistente", kinds + 4 * 2, UINT32_MAX},
+        {"token inexistente", tokens + 4 * 3, token_count},
+        {"raíz que no cubre el árbol", ends, count - 1},
+        {"raíz que se sale del árbol", ends, count + 1},
+        {"subárbol vacío", ends + 4 * 1, 1},
+        {"subárbol que retrocede", ends + 4 * 2, 0},
+        {"subárbol fuera del padre", ends + 4 * nested, nested_parent_end + 1},
+        {"subárbol fuera del árbol", ends + 4 * (count - 1), UINT32_MAX},
+    };
+    size_t checks = 0;
+    for (size_t i = 0; i < sizeof(corruptions) / sizeof(corruptions[0]); i++) {
+        memcpy(bad, good, size);
+        set_u32(bad, corruptions[i].offset, corruptions[i].value);
+        write_entry(path, bad, size);
+        if (ast_cache_load(dir, hash, length, &entry)) {
+            ast_cache_release(&entry);
+            fail(corruptions[i].label, "se cargó");
+        } else if (access(path, F_OK) == 0) {
+            fail(corruptions[i].label, "no se borró");
+        }
+        checks++;
+    }
+    write_entry(path, good, size - 4);
+    if (ast_cache_load(dir, hash, length, &entry)) {
+        ast_cache_release(&entry);
+        fail("entrada truncada", "se cargó");
+    } else if (access(path, F_OK) == 0) {
+        fail("entrada truncada", "no se borró");
+    }
+    checks++;
+
+    // Otra longitud de fuente es otra entrada, no un archivo roto: no se borra.
+    write_entry(path, good, size);
+    if (ast_cache_load(dir, hash, length + 1, &entry)) {
+        ast_cache_release(&entry);
+        fail("otra longitud", "se cargó");
+    } else if (access(path, F_OK) != 0) {
+        fail("otra longitud", "se borró");
+    }
+    checks++;
+    if (!ast_cache_load(dir, hash, length, &entry)) {
+        fail("entrada restaurada", "no se cargó");
+    } else {
+        ast_cache_release(&entry);
+    }
+    checks++;
+
+    unlink(path);
+    rmdir(dir);
+    free(bad);
+    free(good);
+    if (failures) {
+        fprintf(stderr, "test_cache: %zu de %zu comprobaciones fallaron\n", failures, checks);
+        return 1;
+    }
+    printf("test_cache: %zu entradas corruptas rechazadas y borradas\n", checks - 2);
+    return 0;
+}
@@ -0,0 +1,219 @@
+// ParserDocument frente a un parseo completo: tras cada edición, el árbol que
+// devuelven parser_document_program y parser_document_instruction (con los
+// offsets de las instrucciones reutilizadas ya desplazados) debe ser idéntico
+// al de parser_parse sobre el texto actual, y los diagnósticos, los mismos.
+// Incluye una instrucción reutilizada con un millón de niveles de anidamiento,
+// que no debe depender de la pila de C al desplazarse.
+
+#include "parser/incremental.h"
+#include "parser/parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEEP_LEVELS 1000000
+#define RANDOM_EDITS 2000
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+
+static void fail(const char *label, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s: %s\n", label, what);
+    }
+}
+
+typedef struct {
+    const ASTNode *a;
+    const ASTNode *b;
+} NodePair;
+
+// Compara tipo, tipo de token, offset y longitud nodo a nodo, sin recursión.
+static bool same_tree(const ASTNode *a, const ASTNode *b) {
+    size_t capacity = 1024;
+    size_t depth = 0;
+    NodePair *stack = (NodePair *)malloc(capacity * sizeof(NodePair));
+    if (!stack) {
+        return false;
+    }
+    bool same = true;
+    stack[depth++] = (NodePair){a, b};
+    while (depth > 0 && same) {
+        NodePair pair = stack[--depth];
+        if (!pair.a || !pair.b) {
+            same = pair.a == pair.b;
+            continue;
+        }
+        same = pair.a->type == pair.b->type && pair.a->token.type == pair.b->token.type &&
+               pair.a->token.offset == pair.b->token.offset && pair.a->token.length == pair.b->token.length &&
+               pair.a->child_count == pair.b->child_count;
+        for (size_t i = 0; same && i < pair.a->child_count; ++i) {
+            if (depth == capacity) {
+                NodePair *grown = (NodePair *)realloc(stack, capacity * 2 * sizeof(NodePair));
+                if (!grown) {
+                    same = false;
+                    break;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth++] = (NodePair){pair.a->children[i], pair.b->children[i]};
+        }
+    }
+    free(stack);
+    return same;
+}
+
+// Parsea doc->source desde cero y lo compara con el documento.
+static void check_document(const char *label, ParserDocument *doc, bool edit_ok) {
+    Parser parser;
+    parser_init(&parser, doc->source, doc->length);
+    parser_set_arena(&parser, true);
+    ASTNode *expected = parser_parse(&parser);
+    bool expected_ok = !parser_has_error(&parser);
+    if (edit_ok != expected_ok) {
+        fail(label, "el documento y el parseo completo no coinciden en si hay errores");
+    } else if (!expected_ok) {
+        SourceLocation a = parser_document_error_location(doc);
+        SourceLocation b = parser_error_location(&parser);
+        if (strcmp(parser_document_error_message(doc), parser_error_message(&parser)) != 0 || a.line != b.line ||
+            a.column != b.column) {
+            fail(label, "diagnóstico distinto del parseo completo");
+        }
+    } else {
+        // Primero una instrucción suelta, que desplaza solo su subárbol.
+        size_t count = doc->count;
+        if (count > 0) {
+            size_t index = (size_t)(rng_next() % count);
+            if (!same_tree(parser_document_instruction(doc, index), expected->children[0]->children[index])) {
+                fail(label, "parser_document_instruction difiere del parseo completo");
+            }
+        }
+        if (!same_tree(parser_document_program(doc), expected)) {
+            fail(label, "parser_document_program difiere del parseo completo");
+        }
+    }
+    parser_free(&parser);
+}
+
+static bool document_edit(ParserDocument *doc, size_t offset, size_t removed, const char *text) {
+    return parser_document_edit(doc, offset, removed, text, strlen(text));
+}
+
+// Una instrucción con DEEP_LEVELS operadores unarios anidados detrás de otra
+// que se edita, de modo que la profunda se reutiliza con un desplazamiento.
+static void check_deep_instruction(void) {
+    static const char head[] = "int a = 1;\nx = ";
+    static const char tail[] = "1;\nint b = 2;\n";
+    size_t length = sizeof(head) - 1 + DEEP_LEVELS + sizeof(tail) - 1;
+    char *source = (char *)malloc(length);
+    if (!source) {
+        fail("profunda", "sin memoria");
+        return;
+    }
+    memcpy(source, head, sizeof(head) - 1);
+    memset(source + sizeof(head) - 1, '!', DEEP_LEVELS);
+    memcpy(source + sizeof(head) - 1 + DEEP_LEVELS, tail, sizeof(tail) - 1);
+
+    ParserDocument doc;
+    if (!parser_document_init(&doc, source, length)) {
+        fail("profunda", "el documento inicial tiene errores");
+    }
+    free(source);
+    // "1" -> "12345": la instrucción profunda se desplaza 4 bytes.
+    bool ok = document_edit(&doc, 8, 1, "12345");
+    if (doc.reparsed != 1) {
+        fail("profunda", "la edición volvió a analizar más de una instrucción");
+    }
+    check_document("profunda", &doc, ok);
+    // Y de vuelta, con el desplazamiento contrario.
+    ok = document_edit(&doc, 8, 5, "7");
+    check_document("profunda", &doc, ok);
+    parser_document_free(&doc);
+}
+
+static const char *const SNIPPETS[] = {
+    "int x = 1;\n", "float y = 2.5;\n", "x = x + 1;\n", "csay(x);\n", "if (x > 1) {\n    csay(\"si\");\n}\n",
+    "while (x < 3) {\n    x = x + 1;\n}\n", "func f(a, b) {\n    return a * b;\n}\n", "array v = [1, 2, 3];\n",
+    "for (i in v) {\n    csay(i);\n}\n", "// comentario\n", "/* bloque */\n", "x", "1", " ", "\n", ";", "{", "}",
+    "(", ")", "+", "=", "\"", "int", "func", "return 0;\n",
+};
+#define SNIPPET_COUNT (sizeof(SNIPPETS) / sizeof(SNIPPETS[0]))
+
+static size_t valid_edits = 0;
+
+static void apply_and_check(ParserDocument *doc, size_t offset, size_t removed, const char *text, const char *label) {
+    bool ok = document_edit(doc, offset, removed, text);
+    valid_edits += ok;
+    check_document(label, doc, ok);
+}
+
+// Ediciones aleatorias sobre un programa pequeño. Cada paso aplica una
+// inserción, borrado o sustitución con un fragmento válido o inválido y
+// después la deshace, así que el documento alterna entre textos con errores y
+// sin ellos; las instrucciones completas insertadas tras un salto de línea se
+// conservan para que el programa crezca.
+static void check_random_edits(void) {
+    static const char initial[] = "int x = 1;\nfloat y = 2.5;\nfunc suma(a, b) {\n    return a + b;\n}\n"
+                                  "if (x > y) {\n    csay(\"Mayor\");\n}\ncsay(suma(3, 4));\n";
+    ParserDocument doc;
+    parser_document_init(&doc, initial, sizeof(initial) - 1);
+    char label[32];
+    char *saved = NULL;
+    for (size_t i = 0; i < RANDOM_EDITS; ++i) {
+        snprintf(label, sizeof(label), "edición %zu", i);
+        size_t offset = (size_t)(rng_next() % (doc.length + 1));
+        const char *text = SNIPPETS[rng_next() % SNIPPET_COUNT];
+        size_t text_length = strlen(text);
+        if (doc.length < 4096 && text[text_length - 1] == '\n' && (offset == 0 || doc.source[offset - 1] == '\n')) {
+            apply_and_check(&doc, offset, 0, text, label);
+            continue;
+        }
+        size_t removed = (size_t)(rng_next() % 8);
+        if (removed > doc.length - offset) {
+            removed = doc.length - offset;
+        }
+        free(saved);
+        saved = (char *)malloc(removed + 1);
+        if (!saved) {
+            fail(label, "sin memoria");
+            break;
+        }
+        memcpy(saved, doc.source + offset, removed);
+        saved[removed] = '\0';
+        // Uno de cada cuatro pasos es un borrado puro.
+        if (rng_next() % 4 == 0) {
+            text = "";
+            text_length = 0;
+        }
+        apply_and_check(&doc, offset, removed, text, label);
+        apply_and_check(&doc, offset, text_length, saved, label);
+    }
+    free(saved);
+    parser_document_free(&doc);
+    // Sin suficientes documentos válidos la comparación de árboles no prueba nada.
+    if (valid_edits < RANDOM_EDITS / 2) {
+        fail("aleatorias", "demasiado pocas ediciones dejaron un documento sin errores");
+    }
+}
+
+int main(void) {
+    check_deep_instruction();
+    check_random_edits();
+    if (failures) {
+        fprintf(stderr, "test_incremental: %zu comprobaciones fallaron\n", failures);
+        return 1;
+    }
+    printf("test_incremental: %zu ediciones sin errores y el resto con los mismos diagnósticos que el parseo "
+           "completo\n", valid_edits);
+    return 0;
+}
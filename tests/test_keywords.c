@@ -0,0 +1,157 @@
+// Comprueba que la tabla hash de palabras reservadas del lexer (KEYWORDS en
+// lexer.c) clasifica igual que la búsqueda lineal original: cada palabra
+// reservada, sus ediciones de un carácter, sus prefijos y extensiones, los
+// identificadores que caen en la misma casilla que una palabra reservada y
+// todos los identificadores cortos. Se prueban los dos motores del lexer.
+
+#include "lexer/lexer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    const char *keyword;
+    TokenType type;
+} ReferenceKeyword;
+
+// La tabla tal como era antes del hash perfecto.
+static const ReferenceKeyword REFERENCE[] = {
+    {"array", TOKEN_KW_ARRAY}, {"bool", TOKEN_KW_BOOL},     {"char", TOKEN_KW_CHAR},   {"cread", TOKEN_KW_CREAD},
+    {"csay", TOKEN_KW_CSAY},   {"false", TOKEN_FALSE},      {"float", TOKEN_KW_FLOAT}, {"for", TOKEN_KW_FOR},
+    {"func", TOKEN_KW_FUNC},   {"if", TOKEN_KW_IF},         {"in", TOKEN_KW_IN},       {"int", TOKEN_KW_INT},
+    {"return", TOKEN_KW_RETURN}, {"true", TOKEN_TRUE},      {"while", TOKEN_KW_WHILE},
+};
+#define REFERENCE_COUNT (sizeof(REFERENCE) / sizeof(REFERENCE[0]))
+
+static const char IDENTIFIER_CHARS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+#define IDENTIFIER_CHAR_COUNT (sizeof(IDENTIFIER_CHARS) - 1)
+
+static size_t checked = 0;
+static size_t failures = 0;
+
+static TokenType reference_lookup(const char *text, size_t length) {
+    for (size_t i = 0; i < REFERENCE_COUNT; ++i) {
+        if (length == strlen(REFERENCE[i].keyword) && strncmp(text, REFERENCE[i].keyword, length) == 0) {
+            return REFERENCE[i].type;
+        }
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+// Lexea text (un identificador completo) con los dos motores.
+static void check(const char *text, size_t length) {
+    if (length == 0 || (text[0] >= '0' && text[0] <= '9')) {
+        return;
+    }
+    TokenType expected = reference_lookup(text, length);
+    static const LexerEngine ENGINES[] = {LEXER_ENGINE_CLASSIC, LEXER_ENGINE_DFA};
+    for (size_t e = 0; e < 2; ++e) {
+        Lexer lexer;
+        lexer_init(&lexer, text, length);
+        lexer.engine = ENGINES[e];
+        Token token = lexer_next_token(&lexer);
+        lexer_free(&lexer);
+        checked++;
+        if (token.type != expected || token.offset != 0 || token.length != length) {
+            if (failures++ < 20) {
+                fprintf(stderr, "%s: '%.*s' da %s (%u bytes), se esperaba %s\n",
+                        ENGINES[e] == LEXER_ENGINE_DFA ? "dfa" : "classic", (int)length, text,
+                        token_type_str(token.type), token.length, token_type_str(expected));
+            }
+        }
+    }
+}
+
+static void check_keyword_neighbours(const char *keyword) {
+    char text[16];
+    size_t length = strlen(keyword);
+    check(keyword, length);
+    for (size_t i = 0; i < length; ++i) {
+        // Sustitución de un carácter.
+        memcpy(text, keyword, length);
+        for (size_t c = 0; c < IDENTIFIER_CHAR_COUNT; ++c) {
+            text[i] = IDENTIFIER_CHARS[c];
+            check(text, length);
+        }
+        // Borrado de un carácter y prefijos.
+        memcpy(text, keyword, i);
+        memcpy(text + i, keyword + i + 1, length - i - 1);
+        check(text, length - 1);
+        check(keyword, i);
+    }
+    for (size_t i = 0; i <= length; ++i) {
+        // Inserción de un carácter, incluidas las extensiones por cada extremo.
+        memcpy(text, keyword, i);
+        memcpy(text + i + 1, keyword + i, length - i);
+        for (size_t c = 0; c < IDENTIFIER_CHAR_COUNT; ++c) {
+            text[i] = IDENTIFIER_CHARS[c];
+            check(text, length + 1);
+        }
+    }
+}
+
+// Misma fórmula que KEYWORD_SLOT en lexer.c.
+static size_t keyword_slot(char first, char last, size_t length) {
+    return (length + 2u * (unsigned char)first + 6u * (unsigned char)last) & 31u;
+}
+
+// Identificadores de longitud 1 a 8 que caen en la casilla de alguna palabra
+// reservada sin serlo; el relleno central es 'k' o 'x'.
+static void check_slot_collisions(void) {
+    char text[16];
+    for (size_t length = 1; length <= 8; ++length) {
+        for (size_t f = 0; f < IDENTIFIER_CHAR_COUNT; ++f) {
+            for (size_t l = 0; l < (length == 1 ? 1 : IDENTIFIER_CHAR_COUNT); ++l) {
+                char first = IDENTIFIER_CHARS[f];
+                char last = length == 1 ? first : IDENTIFIER_CHARS[l];
+                size_t slot = keyword_slot(first, last, length);
+                bool collides = false;
+                for (size_t k = 0; k < REFERENCE_COUNT && !collides; ++k) {
+                    const char *keyword = REFERENCE[k].keyword;
+                    size_t keyword_length = strlen(keyword);
+                    collides = keyword_slot(keyword[0], keyword[keyword_length - 1], keyword_length) == slot;
+                }
+                if (!collides) {
+                    continue;
+                }
+                for (size_t fill = 0; fill < 2; ++fill) {
+                    memset(text, fill ? 'x' : 'k', length);
+                    text[0] = first;
+                    text[length - 1] = last;
+                    check(text, length);
+                }
+            }
+        }
+    }
+}
+
+// Todos los identificadores de hasta tres caracteres.
+static void check_short_identifiers(void) {
+    char text[3];
+    for (size_t a = 0; a < IDENTIFIER_CHAR_COUNT; ++a) {
+        text[0] = IDENTIFIER_CHARS[a];
+        check(text, 1);
+        for (size_t b = 0; b < IDENTIFIER_CHAR_COUNT; ++b) {
+            text[1] = IDENTIFIER_CHARS[b];
+            check(text, 2);
+            for (size_t c = 0; c < IDENTIFIER_CHAR_COUNT; ++c) {
+                text[2] = IDENTIFIER_CHARS[c];
+                check(text, 3);
+            }
+        }
+    }
+}
+
+int main(void) {
+    for (size_t i = 0; i < REFERENCE_COUNT; ++i) {
+        check_keyword_neighbours(REFERENCE[i].keyword);
+    }
+    check_slot_collisions();
+    check_short_identifiers();
+    if (failures) {
+        fprintf(stderr, "test_keywords: %zu de %zu comprobaciones fallaron\n", failures, checked);
+        return 1;
+    }
+    printf("test_keywords: %zu comprobaciones correctas\n", checked);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Prueba diferencial de los motores del lexer: LEXER_ENGINE_DFA debe producir
+// exactamente los mismos tokens (tipo, offset y longitud) que el clásico sobre
+// sample.pycl, un corpus de programas generados a partir de fragmentos de
+// PyCLite y entradas aleatorias con los bytes que cambian el estado del lexer.
+
+#include "lexer/lexer.h"
+#include "source/source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_INPUTS 200000
+#define RANDOM_MAX_LENGTH 64
+#define CORPUS_PROGRAMS 200
+
+static unsigned long long rng_state = 0x2545f4914f6cdd1dull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+static void compare_engines(const char *label, const char *source, size_t length) {
+    Lexer classic;
+    Lexer dfa;
+    lexer_init(&classic, source, length);
+    lexer_init(&dfa, source, length);
+    classic.engine = LEXER_ENGINE_CLASSIC;
+    dfa.engine = LEXER_ENGINE_DFA;
+    compared++;
+    while (true) {
+        Token expected = lexer_next_token(&classic);
+        Token actual = lexer_next_token(&dfa);
+        if (expected.type != actual.type || expected.offset != actual.offset || expected.length != actual.length) {
+            if (failures++ < 20) {
+                fprintf(stderr, "%s: en el offset %u classic da %s/%u y dfa %s/%u en %u\n", label, expected.offset,
+                        token_type_str(expected.type), expected.length, token_type_str(actual.type), actual.length,
+                        actual.offset);
+            }
+            break;
+        }
+        if (expected.type == TOKEN_EOF) {
+            break;
+        }
+    }
+    lexer_free(&classic);
+    lexer_free(&dfa);
+}
+
+static void check_file(const char *path) {
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+        failures++;
+        return;
+    }
+    compare_engines(path, file.data, file.length);
+    source_release(&file);
+}
+
+// Fragmentos que cubren cada clase de token, los cuatro tipos de comentario y
+// cadenas con escapes; se concatenan con separadores aleatorios o sin ellos.
+static const char *const FRAGMENTS[] = {
+    "int", "float", "char", "bool", "array", "if", "for", "in", "while", "func", "return", "csay", "cread",
+    "true", "false", "x", "_tmp9", "valor_42", "Int", "funcs", "0", "42", "3.14", "1.2.3", "7.",
+    "\"hola\"", "\"esc \\\" \\n\"", "\"sin cerrar", "'a'", "'\\''", "'", "+", "++", "-", "--", "*", "/", "%",
+    "=", "==", "!", "!=", "<", "<=", ">", ">=", "&&", "||", "&", "|", "(", ")", "{", "}", "[", "]", ",", ";",
+    ".", "// línea\n", "$ dólar\n", "/* bloque * / */", "/* sin cerrar", "%% porcentaje %%", "%%", "@", "#",
+    "\xc3\xb1", "\xff",
+};
+#define FRAGMENT_COUNT (sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]))
+
+static const char *const SEPARATORS[] = {"", " ", "\n", "\t", "  \n    ", "\r\n"};
+#define SEPARATOR_COUNT (sizeof(SEPARATORS) / sizeof(SEPARATORS[0]))
+
+static void check_corpus(void) {
+    size_t capacity = 64 * 1024;
+    char *program = (char *)malloc(capacity);
+    if (!program) {
+        failures++;
+        return;
+    }
+    for (size_t p = 0; p < CORPUS_PROGRAMS; ++p) {
+        size_t length = 0;
+        size_t target = 512 + (size_t)(rng_next() % (capacity / 2));
+        while (length < target) {
+            const char *fragment = FRAGMENTS[rng_next() % FRAGMENT_COUNT];
+            const char *separator = SEPARATORS[rng_next() % SEPARATOR_COUNT];
+            size_t fragment_length = strlen(fragment);
+            size_t separator_length = strlen(separator);
+            memcpy(program + length, fragment, fragment_length);
+            memcpy(program + length + fragment_length, separator, separator_length);
+            length += fragment_length + separator_length;
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "corpus %zu", p);
+        compare_engines(label, program, length);
+    }
+    free(program);
+}
+
+// Bytes que cambian el estado de alguno de los dos motores, incluidos NUL y
+// bytes con el bit alto.
+static const char RANDOM_ALPHABET[] = "az_Z09.\"'\\/*$%\n \t+-=!<>&|(){}[],;@\x80\xff";
+
+static void check_random(void) {
+    char input[RANDOM_MAX_LENGTH];
+    for (size_t i = 0; i < RANDOM_INPUTS; ++i) {
+        size_t length = (size_t)(rng_next() % (RANDOM_MAX_LENGTH + 1));
+        for (size_t j = 0; j < length; ++j) {
+            // sizeof incluye el '\0' final, que también entra en el alfabeto.
+            input[j] = RANDOM_ALPHABET[rng_next() % sizeof(RANDOM_ALPHABET)];
+        }
+        compare_engines("aleatoria", input, length);
+    }
+}
+
+int main(void) {
+    check_file("sample.pycl");
+    check_corpus();
+    check_random();
+    if (failures) {
+        fprintf(stderr, "test_lexer_dfa: %zu de %zu entradas difieren\n", failures, compared);
+        return 1;
+    }
+    printf("test_lexer_dfa: %zu entradas con los mismos tokens en classic y dfa\n", compared);
+    return 0;
+}
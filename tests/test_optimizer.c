@@ -0,0 +1,252 @@
+// optimizer_optimize en los casos límite de optimizer.h: cada programa termina
+// con una declaración cuyo valor, tras parsear, resolver, inferir tipos y
+// optimizar, debe quedar plegado en un literal con el valor exacto (bit a bit
+// en los reales, para distinguir -0.0) o quedarse sin plegar, y el resumen debe
+// contar exactamente lo plegado, evaluado, simplificado y podado. Se cubren los
+// desbordamientos de int, la división y el resto entre cero, INT64_MIN / -1,
+// los reales no finitos, x - (-0.0), el límite de 53 bits al guardar un entero
+// en un float y las func recursivas que agotan su combustible o el del archivo.
+
+#include "optimizer/optimizer.h"
+#include "parser/parser.h"
+#include "resolver/resolver.h"
+#include "types/types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Más llamadas de las que caben en el combustible del archivo.
+#define BUDGET_CALLS 100
+
+typedef struct {
+    const char *label;
+    const char *source;
+    // Nodo que debe quedar como valor de la última declaración; si es un
+    // AST_LITERAL plegado, su tipo y su valor.
+    ASTNodeType node;
+    ValueType type;
+    int64_t integer;
+    double real;
+    size_t folded;
+    size_t evaluated;
+    size_t simplified;
+    size_t pruned;
+} OptimizerCase;
+
+#define FIB "func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+#define DOWN "func baja(n) { if (n == 0) { return 0; } return baja(n - 1); }\n"
+#define PARITY                                                                                                        \
+    "func par(n) { if (n == 0) { return true; } return impar(n - 1); }\n"                                            \
+    "func impar(n) { if (n == 0) { return false; } return par(n - 1); }\n"
+// 2^32 multiplicado 31 veces da 2^992, exacto; una más, 2^1024, que ya es infinito.
+#define TWO_32 "4294967296.0"
+#define TWO_32_X2 TWO_32 " * " TWO_32
+#define TWO_32_X4 TWO_32_X2 " * " TWO_32_X2
+#define TWO_32_X8 TWO_32_X4 " * " TWO_32_X4
+#define TWO_32_X16 TWO_32_X8 " * " TWO_32_X8
+#define TWO_32_X31 TWO_32_X16 " * " TWO_32_X8 " * " TWO_32_X4 " * " TWO_32_X2 " * " TWO_32
+
+static const OptimizerCase CASES[] = {
+    // Enteros de 64 bits.
+    {"int máximo", "int r = 9223372036854775806 + 1;", AST_LITERAL, VALUE_INT, INT64_MAX, 0.0, 1, 0, 0, 0},
+    {"suma desbordada", "int r = 9223372036854775807 + 1;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"resta desbordada", "int r = -9223372036854775807 - 2;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 1, 0, 0, 0},
+    {"int mínimo", "int r = -9223372036854775807 - 1;", AST_LITERAL, VALUE_INT, INT64_MIN, 0.0, 2, 0, 0, 0},
+    {"producto desbordado", "int r = 4611686018427387904 * 2;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"producto negativo desbordado", "int r = -4611686018427387905 * 2;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 1,
+     0, 0, 0},
+    {"producto hasta int mínimo", "int r = -4611686018427387904 * 2;", AST_LITERAL, VALUE_INT, INT64_MIN, 0.0, 2, 0,
+     0, 0},
+    {"negar int mínimo", "int r = -(-9223372036854775807 - 1);", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 2, 0, 0, 0},
+    // División y resto.
+    {"división entre cero", "int r = 7 / 0;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"resto entre cero", "int r = 7 % 0;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"división real entre cero", "float r = 1.0 / 0;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"división truncada", "int r = -7 / 2;", AST_LITERAL, VALUE_INT, -3, 0.0, 2, 0, 0, 0},
+    {"resto negativo", "int r = -7 % 2;", AST_LITERAL, VALUE_INT, -1, 0.0, 2, 0, 0, 0},
+    {"int mínimo / -1", "int r = (-9223372036854775807 - 1) / -1;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 3, 0, 0,
+     0},
+    {"int mínimo % -1", "int r = (-9223372036854775807 - 1) % -1;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 3, 0, 0,
+     0},
+    {"int mínimo / 1", "int r = (-9223372036854775807 - 1) / 1;", AST_LITERAL, VALUE_INT, INT64_MIN, 0.0, 3, 0, 0,
+     0},
+    // Reales no finitos.
+    {"real grande", "float r = " TWO_32_X31 ";", AST_LITERAL, VALUE_FLOAT, 0, 0x1p992, 30, 0, 0, 0},
+    {"real infinito", "float r = " TWO_32_X31 " * " TWO_32 ";", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 30, 0, 0, 0},
+    {"cero entre cero", "float r = 0.0 / 0.0;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    // Ceros con signo: x - 0 es x incluso con x = -0.0; x - (-0.0) y x + 0.0 no.
+    {"menos cero", "float r = -0.0;", AST_LITERAL, VALUE_FLOAT, 0, -0.0, 1, 0, 0, 0},
+    {"cero menos cero", "float r = -0.0 - 0.0;", AST_LITERAL, VALUE_FLOAT, 0, -0.0, 2, 0, 0, 0},
+    {"x - 0.0", "float x = 2.5;\nfloat r = x - 0.0;", AST_IDENTIFIER, VALUE_UNKNOWN, 0, 0.0, 0, 0, 1, 0},
+    {"x - (-0.0)", "float x = 2.5;\nfloat r = x - (-0.0);", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 1, 0, 0, 0},
+    {"x + 0.0", "float x = 2.5;\nfloat r = x + 0.0;", AST_EXPRESSION, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"x * 1.0", "float x = 2.5;\nfloat r = x * 1.0;", AST_IDENTIFIER, VALUE_UNKNOWN, 0, 0.0, 0, 0, 1, 0},
+    // Un entero se guarda en un float solo si cabe en 53 bits.
+    {"float de 2^53", "func g() { float v = 9007199254740992; return v; }\nfloat r = g();", AST_LITERAL, VALUE_FLOAT,
+     0, 9007199254740992.0, 0, 1, 0, 0},
+    {"float de -2^53", "func g() { float v = -9007199254740992; return v; }\nfloat r = g();", AST_LITERAL,
+     VALUE_FLOAT, 0, -9007199254740992.0, 1, 1, 0, 0},
+    {"float de 2^53 + 1", "func g() { float v = 9007199254740993; return v; }\nfloat r = g();", AST_CALL,
+     VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"float de -2^53 - 1", "func g() { float v = -9007199254740993; return v; }\nfloat r = g();", AST_CALL,
+     VALUE_UNKNOWN, 0, 0.0, 1, 0, 0, 0},
+    {"char en un int", "func g() { int v = 'a'; return v; }\nint r = g();", AST_LITERAL, VALUE_INT, 'a', 0.0, 0, 1,
+     0, 0},
+    // Recursión: la que cabe en el combustible se evalúa, la que no se queda.
+    {"fib(10)", FIB "int r = fib(10);", AST_LITERAL, VALUE_INT, 55, 0.0, 0, 1, 0, 0},
+    {"fib(30) sin combustible", FIB "int r = fib(30);", AST_CALL, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"recursión mutua", PARITY "bool r = par(11);", AST_LITERAL, VALUE_BOOL, 0, 0.0, 0, 1, 0, 0},
+    {"recursión de 100", DOWN "int r = baja(100);", AST_LITERAL, VALUE_INT, 0, 0.0, 0, 1, 0, 0},
+    {"recursión sin fondo", DOWN "int r = baja(1000000);", AST_CALL, VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    {"recursión infinita", "func siempre(n) { return siempre(n + 1); }\nint r = siempre(0);", AST_CALL,
+     VALUE_UNKNOWN, 0, 0.0, 0, 0, 0, 0},
+    // Poda de instrucciones.
+    {"if falso", "if (1 > 2) { csay(1); }\nint r = 1 + 1;", AST_LITERAL, VALUE_INT, 2, 0.0, 2, 0, 0, 1},
+    {"while falso", "while (false) { csay(1); }\nint r = 2 * 3;", AST_LITERAL, VALUE_INT, 6, 0.0, 1, 0, 0, 1},
+};
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+static size_t failures = 0;
+
+static void fail(const char *label, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s: %s\n", label, what);
+    }
+}
+
+// Parsea, resuelve, infiere y optimiza source. Devuelve el árbol o NULL si
+// falló alguna fase antes de optimizar.
+static ASTNode *optimize(Parser *parser, const char *source, OptimizerSummary *summary) {
+    parser_init(parser, source, strlen(source));
+    ASTNode *program = parser_parse(parser);
+    if (!program) {
+        return NULL;
+    }
+    Resolver resolver;
+    resolver_init(&resolver);
+    bool resolved = resolver_resolve(&resolver, program, parser_symbols(parser));
+    size_t declarations = resolver.declaration_count;
+    resolver_free(&resolver);
+    TypeInference types;
+    types_init(&types);
+    bool inferred = resolved && types_infer(&types, program, declarations, source);
+    types_free(&types);
+    Optimizer optimizer;
+    optimizer_init(&optimizer);
+    bool optimized = inferred && optimizer_optimize(&optimizer, program, source);
+    *summary = optimizer.summary;
+    optimizer_free(&optimizer);
+    if (!optimized) {
+        ast_free(program);
+        return NULL;
+    }
+    return program;
+}
+
+// Valor de la última declaración de nivel superior.
+static const ASTNode *last_value(const ASTNode *program) {
+    const ASTNode *list = program->children[0];
+    for (uint32_t i = list->child_count; i > 0; --i) {
+        const ASTNode *node = list->children[i - 1];
+        if (node->type == AST_DECLARATION && node->child_count == 2) {
+            return node->children[1];
+        }
+    }
+    return NULL;
+}
+
+static void check_case(const OptimizerCase *test) {
+    Parser parser;
+    OptimizerSummary summary;
+    ASTNode *program = optimize(&parser, test->source, &summary);
+    const ASTNode *value = program ? last_value(program) : NULL;
+    char what[160];
+    if (!value) {
+        fail(test->label, "no llegó a optimizarse");
+    } else if (value->type != test->node) {
+        snprintf(what, sizeof(what), "queda un %s y se esperaba un %s", ast_type_str(value->type),
+                 ast_type_str(test->node));
+        fail(test->label, what);
+    } else if (test->node == AST_LITERAL && (value->token.length != 0 || value->value_type != test->type)) {
+        fail(test->label, "el literal no es el plegado o tiene otro tipo");
+    } else if (test->node == AST_LITERAL && test->type == VALUE_FLOAT &&
+               memcmp(&value->real, &test->real, sizeof(double)) != 0) {
+        snprintf(what, sizeof(what), "vale %.17g y se esperaba %.17g", value->real, test->real);
+        fail(test->label, what);
+    } else if (test->node == AST_LITERAL && test->type != VALUE_FLOAT && value->integer != test->integer) {
+        snprintf(what, sizeof(what), "vale %lld y se esperaba %lld", (long long)value->integer,
+                 (long long)test->integer);
+        fail(test->label, what);
+    }
+    if (value && (summary.folded != test->folded || summary.evaluated != test->evaluated ||
+                  summary.simplified != test->simplified || summary.pruned != test->pruned)) {
+        snprintf(what, sizeof(what),
+                 "resumen %zu plegadas, %zu evaluadas, %zu simplificadas, %zu podadas; se esperaba %zu, %zu, %zu, %zu",
+                 summary.folded, summary.evaluated, summary.simplified, summary.pruned, test->folded,
+                 test->evaluated, test->simplified, test->pruned);
+        fail(test->label, what);
+    }
+    ast_free(program);
+    parser_free(&parser);
+}
+
+// Muchas llamadas que caben en su combustible agotan el del archivo: las
+// primeras se evalúan y, desde la primera que no, ya no se evalúa ninguna.
+static void check_budget(void) {
+    static const char DECLARATION[] = "int r = 0;\n";
+    static const char CALL[] = "r = fib(15);\n";
+    size_t length = strlen(FIB) + strlen(DECLARATION) + BUDGET_CALLS * strlen(CALL) + 1;
+    char *source = (char *)malloc(length);
+    strcpy(source, FIB);
+    strcat(source, DECLARATION);
+    for (size_t i = 0; i < BUDGET_CALLS; i++) {
+        strcat(source, CALL);
+    }
+    Parser parser;
+    OptimizerSummary summary;
+    ASTNode *program = optimize(&parser, source, &summary);
+    if (!program) {
+        fail("combustible del archivo", "no llegó a optimizarse");
+    } else {
+        const ASTNode *list = program->children[0];
+        size_t evaluated = 0;
+        bool kept = false;
+        for (uint32_t i = 0; i < list->child_count; ++i) {
+            if (list->children[i]->type != AST_ASSIGNMENT) {
+                continue;
+            }
+            const ASTNode *value = list->children[i]->children[1];
+            if (value->type == AST_LITERAL && value->integer == 610) {
+                evaluated++;
+                if (kept) {
+                    fail("combustible del archivo", "se evaluó una llamada tras otra que no");
+                }
+            } else {
+                kept = true;
+            }
+        }
+        if (evaluated == 0 || evaluated == BUDGET_CALLS || evaluated != summary.evaluated) {
+            char what[96];
+            snprintf(what, sizeof(what), "%zu llamadas evaluadas de %d (%zu en el resumen)", evaluated,
+                     BUDGET_CALLS, summary.evaluated);
+            fail("combustible del archivo", what);
+        }
+    }
+    ast_free(program);
+    parser_free(&parser);
+    free(source);
+}
+
+int main(void) {
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        check_case(&CASES[i]);
+    }
+    check_budget();
+    if (failures) {
+        fprintf(stderr, "test_optimizer: %zu fallos en %zu casos\n", failures, CASE_COUNT + 1);
+        return 1;
+    }
+    printf("test_optimizer: %zu casos límite con el literal y el resumen esperados\n", CASE_COUNT + 1);
+    return 0;
+}
@@ -0,0 +1,230 @@
+// Parseo por regiones (parser_set_threads con --split-size) frente al parseo
+// en serie: sobre programas generados con muchos `func` de nivel superior, con
+// regiones mínimas pequeñas y de 2 a 8 hilos, el árbol debe ser idéntico nodo a
+// nodo, incluidos los símbolos de los identificadores (las regiones internan en
+// tablas propias que luego se reasignan a la del parser) y la tabla final. Con
+// un error inyectado, alguna región falla y el parser recurre al parseo en
+// serie: los diagnósticos deben ser los mismos, con uno y con varios errores.
+// `func` dentro de cadenas y comentarios pone a prueba los cortes.
+
+#include "intern/intern.h"
+#include "parser/parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGRAMS 400
+#define PROGRAM_ITEMS 80
+// Programas en los que al menos debe haberse dividido de verdad.
+#define MIN_SPLIT_PROGRAMS (PROGRAMS / 2)
+
+static const size_t REGION_SIZES[] = {1, 16, 64, 256};
+#define REGION_SIZE_COUNT (sizeof(REGION_SIZES) / sizeof(REGION_SIZES[0]))
+
+static unsigned long long rng_state = 0xa54ff53a5f1d36f1ull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+// Parseos con diagnósticos, en los que el parseo por regiones debe ceder al serie.
+static size_t rejected = 0;
+
+static void fail(const char *label, size_t threads, size_t region, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s (%zu hilos, regiones de %zu bytes): %s\n", label, threads, region, what);
+    }
+}
+
+typedef struct {
+    const ASTNode *a;
+    const ASTNode *b;
+} NodePair;
+
+// Compara tipo, token (tipo, offset, longitud y símbolo) e hijos nodo a nodo,
+// sin recursión.
+static bool same_tree(const ASTNode *a, const ASTNode *b) {
+    size_t capacity = 1024;
+    size_t depth = 0;
+    NodePair *stack = (NodePair *)malloc(capacity * sizeof(NodePair));
+    if (!stack) {
+        return false;
+    }
+    bool same = true;
+    stack[depth++] = (NodePair){a, b};
+    while (depth > 0 && same) {
+        NodePair pair = stack[--depth];
+        if (!pair.a || !pair.b) {
+            same = pair.a == pair.b;
+            continue;
+        }
+        same = pair.a->type == pair.b->type && pair.a->token.type == pair.b->token.type &&
+               pair.a->token.offset == pair.b->token.offset && pair.a->token.length == pair.b->token.length &&
+               pair.a->token.symbol == pair.b->token.symbol && pair.a->child_count == pair.b->child_count;
+        for (size_t i = 0; same && i < pair.a->child_count; ++i) {
+            if (depth == capacity) {
+                NodePair *grown = (NodePair *)realloc(stack, capacity * 2 * sizeof(NodePair));
+                if (!grown) {
+                    same = false;
+                    break;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth++] = (NodePair){pair.a->children[i], pair.b->children[i]};
+        }
+    }
+    free(stack);
+    return same;
+}
+
+static bool same_symbols(const InternTable *a, const InternTable *b) {
+    if (intern_count(a) != intern_count(b)) {
+        return false;
+    }
+    for (uint32_t symbol = 1; symbol <= intern_count(a); symbol++) {
+        size_t length_a;
+        size_t length_b;
+        const char *name_a = intern_name(a, symbol, &length_a);
+        const char *name_b = intern_name(b, symbol, &length_b);
+        if (length_a != length_b || memcmp(name_a, name_b, length_a) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool same_errors(Parser *a, Parser *b) {
+    if (parser_has_error(a) != parser_has_error(b) || parser_error_count(a) != parser_error_count(b)) {
+        return false;
+    }
+    for (size_t i = 0; i < parser_error_count(a); i++) {
+        SourceLocation la = parser_error_location_at(a, i);
+        SourceLocation lb = parser_error_location_at(b, i);
+        if (la.line != lb.line || la.column != lb.column ||
+            strcmp(parser_error_message_at(a, i), parser_error_message_at(b, i)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Devuelve true si el parseo se dividió de verdad en regiones.
+static bool compare(const char *label, const char *source, size_t length, size_t threads, size_t region,
+                    size_t max_errors) {
+    Parser serial;
+    Parser split;
+    parser_init(&serial, source, length);
+    parser_init(&split, source, length);
+    parser_set_max_errors(&serial, max_errors);
+    parser_set_max_errors(&split, max_errors);
+    parser_set_threads(&split, threads, region);
+    ASTNode *expected = parser_parse(&serial);
+    ASTNode *actual = parser_parse(&split);
+    // Con el arena activado las regiones que salieron bien siguen vivas.
+    bool divided = split.region_count > 1;
+    if (!same_errors(&serial, &split)) {
+        fail(label, threads, region, "diagnósticos distintos");
+    } else if (parser_has_error(&serial)) {
+        rejected++;
+    } else if (!same_tree(expected, actual)) {
+        fail(label, threads, region, "árbol distinto");
+    } else if (!same_symbols(parser_symbols(&serial), parser_symbols(&split))) {
+        fail(label, threads, region, "tabla de símbolos distinta");
+    }
+    parser_free(&serial);
+    parser_free(&split);
+    return divided;
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text *text, const char *piece) {
+    size_t length = strlen(piece);
+    if (text->length + length + 1 > text->capacity) {
+        text->capacity = (text->length + length + 1) * 2;
+        text->data = (char *)realloc(text->data, text->capacity);
+        if (!text->data) {
+            fprintf(stderr, "Memoria insuficiente\n");
+            exit(1);
+        }
+    }
+    memcpy(text->data + text->length, piece, length);
+    text->length += length;
+}
+
+// Elementos de nivel superior: sobre todo funciones, que es donde se corta,
+// e instrucciones sueltas entre ellas que usan y declaran nombres nuevos.
+static const char *const ITEMS[] = {
+    "func suma(p, q) {\n    return p + q;\n}\n",
+    "func vacia() {\n}\n",
+    "func anidada(n) {\n    func interna(m) { return m * 2; }\n    if (n > 0) { return interna(n); }\n"
+    "    return 0;\n}\n",
+    "func con_cadena() {\n    csay(\"func falsa() { \");\n    return '}';\n}\n",
+    "func con_comentario(a) {\n    /* func en un comentario { */\n    // func otra {\n    return a;\n}\n",
+    "int total = suma(1, 2);\n",
+    "array datos = [1, 2, 3];\n",
+    "for (d in datos) { total = total + d; }\n",
+    "while (total < 100) { total = total * 2; }\n",
+    "csay(\"total: \", total);\n",
+    "$ func en un comentario de línea\n",
+    "%% func en un comentario de bloque %%\n",
+    "funcion_no_es_func = 1;\n",
+};
+#define ITEM_COUNT (sizeof(ITEMS) / sizeof(ITEMS[0]))
+
+// Errores que se inyectan en un punto al azar; algunos rompen el anidamiento
+// de llaves, de modo que los cortes caen a mitad de una instrucción.
+static const char *const ERRORS[] = {"@", ")", "{", "}", "int = ;", "func (", "\"", "/*"};
+#define ERROR_COUNT (sizeof(ERRORS) / sizeof(ERRORS[0]))
+
+int main(void) {
+    Text text = {NULL, 0, 0};
+    size_t divided = 0;
+    size_t compared = 0;
+    for (size_t program = 0; program < PROGRAMS; program++) {
+        text.length = 0;
+        size_t items = 1 + rng_next() % PROGRAM_ITEMS;
+        for (size_t i = 0; i < items; i++) {
+            append(&text, ITEMS[rng_next() % ITEM_COUNT]);
+        }
+        size_t threads = 2 + rng_next() % 7;
+        size_t region = REGION_SIZES[rng_next() % REGION_SIZE_COUNT];
+        bool split = compare("programa válido", text.data, text.length, threads, region, 1);
+        divided += split;
+        compared++;
+
+        // El mismo programa con un error en un punto al azar.
+        size_t at = rng_next() % (text.length + 1);
+        const char *error = ERRORS[rng_next() % ERROR_COUNT];
+        size_t error_length = strlen(error);
+        append(&text, error);
+        memmove(text.data + at + error_length, text.data + at, text.length - error_length - at);
+        memcpy(text.data + at, error, error_length);
+        compare("programa con un error", text.data, text.length, threads, region, 1);
+        compare("programa con un error y recuperación", text.data, text.length, threads, region, 20);
+        compared += 2;
+    }
+    free(text.data);
+    if (divided < MIN_SPLIT_PROGRAMS) {
+        fprintf(stderr, "test_parallel_parse: solo %zu de %d programas se dividieron en regiones\n", divided,
+                PROGRAMS);
+        failures++;
+    }
+    if (failures) {
+        fprintf(stderr, "test_parallel_parse: %zu diferencias en %zu comparaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_parallel_parse: %zu parseos iguales en serie y por regiones (%zu divididos, %zu con errores)\n",
+           compared, divided, rejected);
+    return 0;
+}
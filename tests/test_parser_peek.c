@@ -0,0 +1,193 @@
+// parser_peek con las tres fuentes de tokens: el lexer incremental
+// (parser_init), el búfer de lexer_tokenize_all (parser_init_tokens) y el hilo
+// lexer con su TokenRing (parser_init_pipelined). Al principio de cada
+// instrucción de nivel superior, las tres deben dar el mismo token (tipo,
+// offset y longitud) para cada distancia de 0 a PEEK_NEAR y para algunas
+// lejanas; las sopas de tokens tienen menos de PEEK_NEAR, así que ahí se
+// cubren todas las distancias hasta pasar el TOKEN_EOF. Después las tres parsean la instrucción y se sigue con la próxima.
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "source/source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PEEK_NEAR 64
+// Menores que la capacidad del TokenRing, que recorta las distancias mayores.
+static const size_t PEEK_FAR[] = {100, 257, 1000, 16000};
+#define PROGRAMS 100
+#define PROGRAM_STATEMENTS 150
+#define SOUPS 2000
+#define SOUP_FRAGMENTS 30
+
+static unsigned long long rng_state = 0x6a09e667f3bcc909ull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+typedef struct {
+    Parser parser;
+    const char *name;
+} Source;
+
+static bool same_token(Token a, Token b) {
+    return a.type == b.type && a.offset == b.offset && a.length == b.length;
+}
+
+static bool compare_peek(const char *label, Source *sources, size_t distance) {
+    Token expected = parser_peek(&sources[0].parser, distance);
+    for (size_t i = 1; i < 3; i++) {
+        Token actual = parser_peek(&sources[i].parser, distance);
+        compared++;
+        if (!same_token(expected, actual)) {
+            if (failures++ < 20) {
+                fprintf(stderr, "%s: peek(%zu) en el offset %u: %s da %s@%u/%u y %s da %s@%u/%u\n", label, distance,
+                        parser_peek(&sources[0].parser, 0).offset, sources[0].name, token_type_str(expected.type),
+                        expected.offset, expected.length, sources[i].name, token_type_str(actual.type),
+                        actual.offset, actual.length);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+static void compare_parsers(const char *label, const char *source, size_t length) {
+    TokenBuffer tokens;
+    token_buffer_init(&tokens);
+    Lexer lexer;
+    lexer_init(&lexer, source, length);
+    if (!lexer_tokenize_all(&lexer, &tokens)) {
+        fprintf(stderr, "%s: sin memoria para los tokens\n", label);
+        exit(1);
+    }
+    Source sources[3] = {{.name = "serie"}, {.name = "búfer"}, {.name = "tubería"}};
+    parser_init(&sources[0].parser, source, length);
+    parser_init_tokens(&sources[1].parser, source, length, &tokens);
+    if (!parser_init_pipelined(&sources[2].parser, source, length)) {
+        fprintf(stderr, "%s: no se pudo arrancar el hilo del lexer\n", label);
+        exit(1);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        parser_set_arena(&sources[i].parser, false);
+    }
+    bool ok = true;
+    while (ok) {
+        for (size_t distance = 0; distance <= PEEK_NEAR && ok; distance++) {
+            ok = compare_peek(label, sources, distance);
+        }
+        for (size_t i = 0; i < sizeof(PEEK_FAR) / sizeof(PEEK_FAR[0]) && ok; i++) {
+            ok = compare_peek(label, sources, PEEK_FAR[i]);
+        }
+        if (!ok || parser_peek(&sources[0].parser, 0).type == TOKEN_EOF) {
+            break;
+        }
+        bool parsed = true;
+        for (size_t i = 0; i < 3; i++) {
+            ASTNode *instruction = parser_parse_instruction(&sources[i].parser);
+            parsed = parsed && instruction;
+            ast_free(instruction);
+        }
+        // Tras un error cada parser se queda donde lo encontró.
+        ok = parsed;
+    }
+    for (size_t i = 0; i < 3; i++) {
+        parser_free(&sources[i].parser);
+    }
+    token_buffer_free(&tokens);
+    lexer_free(&lexer);
+}
+
+static void check_file(const char *path) {
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+        failures++;
+        return;
+    }
+    compare_parsers(path, file.data, file.length);
+    source_release(&file);
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text *text, const char *piece) {
+    size_t length = strlen(piece);
+    if (text->length + length > text->capacity) {
+        text->capacity = (text->length + length) * 2;
+        text->data = (char *)realloc(text->data, text->capacity);
+        if (!text->data) {
+            fprintf(stderr, "Memoria insuficiente\n");
+            exit(1);
+        }
+    }
+    memcpy(text->data + text->length, piece, length);
+    text->length += length;
+}
+
+// Instrucciones válidas, para recorrer programas largos instrucción a
+// instrucción.
+static const char *const STATEMENTS[] = {
+    "int x = 1;\n",
+    "x = x + 2 * (3 - x) / 4;\n",
+    "float f = 3.5;\n",
+    "array a = [1, 2, 3];\n",
+    "csay(\"hola\", x);\n",
+    "if (x > 1 && x < 9) { x = x - 1; }\n",
+    "while (x < 10) { x = x + 1; }\n",
+    "for (v in a) { csay(v); }\n",
+    "func suma(p, q) { return p + q; }\n",
+    "x = suma(x, -x);\n",
+    "/* comentario */ char c = 'z';\n",
+};
+#define STATEMENT_COUNT (sizeof(STATEMENTS) / sizeof(STATEMENTS[0]))
+
+// Fragmentos sueltos: la mayoría de las sopas fallan pronto, pero antes se
+// comparan todas las distancias desde el primer token.
+static const char *const FRAGMENTS[] = {
+    "int", "x", "=", "1", ";", "(", ")", "{", "}", "[", "]", ",", "+", "*", "==", "&&", "if", "while",
+    "func", "return", "\"s\"", "'c'", "3.25", "// l\n", "/* b */", " ", "\n", "@",
+};
+#define FRAGMENT_COUNT (sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]))
+
+int main(void) {
+    check_file("sample.pycl");
+    Text text = {NULL, 0, 0};
+    for (size_t program = 0; program < PROGRAMS; program++) {
+        text.length = 0;
+        size_t statements = 1 + rng_next() % PROGRAM_STATEMENTS;
+        for (size_t i = 0; i < statements; i++) {
+            append(&text, STATEMENTS[rng_next() % STATEMENT_COUNT]);
+        }
+        compare_parsers("programa generado", text.data, text.length);
+    }
+    for (size_t soup = 0; soup < SOUPS; soup++) {
+        text.length = 0;
+        size_t fragments = rng_next() % SOUP_FRAGMENTS;
+        for (size_t i = 0; i < fragments; i++) {
+            append(&text, FRAGMENTS[rng_next() % FRAGMENT_COUNT]);
+            append(&text, " ");
+        }
+        compare_parsers("sopa de tokens", text.data ? text.data : "", text.length);
+    }
+    free(text.data);
+    if (failures) {
+        fprintf(stderr, "test_parser_peek: %zu diferencias en %zu comparaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_parser_peek: %zu comparaciones de parser_peek iguales en serie, con búfer y en tubería\n", compared);
+    return 0;
+}
@@ -0,0 +1,245 @@
+// Forma del árbol de las expresiones: cada una se escribe con todos sus
+// paréntesis, "(a + (b * c))", y se compara con la que dicta la gramática de
+// parse_expression. Se prueban todas las combinaciones de uno a tres operadores
+// binarios (cada par de precedencias en los dos órdenes, y las asociatividades),
+// los pares con paréntesis explícitos, los unarios delante de cada operando y
+// anidados entre sí, y llamadas y arreglos dentro de las expresiones. El árbol
+// esperado se construye aquí por descenso recursivo, a partir de una tabla de
+// precedencias propia, y no con la pila de operadores del parser.
+
+#include "parser/parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_OPERATORS 3
+#define TREE_SIZE 256
+
+typedef struct {
+    const char *lexeme;
+    unsigned precedence;
+} Operator;
+
+// De menor a mayor precedencia; todos asocian por la izquierda.
+static const Operator OPERATORS[] = {
+    {"||", 1}, {"&&", 2}, {"==", 3}, {"!=", 3}, {"<", 4}, {"<=", 4}, {">", 4},
+    {">=", 4}, {"+", 5},  {"-", 5},  {"*", 6},  {"/", 6},  {"%", 6},
+};
+#define OPERATOR_COUNT (sizeof(OPERATORS) / sizeof(OPERATORS[0]))
+#define MAX_PRECEDENCE 6
+
+static const char *const UNARY[] = {"-", "!", "++", "--"};
+#define UNARY_COUNT (sizeof(UNARY) / sizeof(UNARY[0]))
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append_bytes(Text *text, const char *piece, size_t length) {
+    if (text->length + length + 1 > text->capacity) {
+        text->capacity = (text->length + length + 1) * 2;
+        text->data = (char *)realloc(text->data, text->capacity);
+        if (!text->data) {
+            fprintf(stderr, "Memoria insuficiente\n");
+            exit(1);
+        }
+    }
+    memcpy(text->data + text->length, piece, length);
+    text->length += length;
+    text->data[text->length] = '\0';
+}
+
+static void append(Text *text, const char *piece) {
+    append_bytes(text, piece, strlen(piece));
+}
+
+static void append_lexeme(Text *text, const char *source, const ASTNode *node) {
+    append_bytes(text, source + node->token.offset, node->token.length);
+}
+
+static void append_list(Text *text, const char *source, const ASTNode *list);
+
+// Escribe node con un paréntesis alrededor de cada operador.
+static void render(Text *text, const char *source, const ASTNode *node) {
+    if (!node) {
+        append(text, "<nulo>");
+        return;
+    }
+    switch (node->type) {
+        case AST_EXPRESSION:
+            append(text, "(");
+            if (node->child_count == 2) {
+                render(text, source, node->children[0]);
+                append(text, " ");
+                append_lexeme(text, source, node);
+                append(text, " ");
+                render(text, source, node->children[1]);
+            } else {
+                append_lexeme(text, source, node);
+                append(text, " ");
+                render(text, source, node->child_count ? node->children[0] : NULL);
+            }
+            append(text, ")");
+            break;
+        case AST_LITERAL:
+        case AST_IDENTIFIER:
+            append_lexeme(text, source, node);
+            break;
+        case AST_CALL:
+            render(text, source, node->children[0]);
+            append(text, "(");
+            append_list(text, source, node->children[1]);
+            append(text, ")");
+            break;
+        case AST_ARRAY_LITERAL:
+            append(text, "[");
+            append_list(text, source, node);
+            append(text, "]");
+            break;
+        default:
+            append(text, ast_type_str(node->type));
+            break;
+    }
+}
+
+static void append_list(Text *text, const char *source, const ASTNode *list) {
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        if (i > 0) {
+            append(text, ", ");
+        }
+        render(text, source, list->children[i]);
+    }
+}
+
+// Parsea "int r = expression;" y compara el árbol de la expresión con expected.
+static void check(const char *expression, const char *expected) {
+    Text source = {NULL, 0, 0};
+    append(&source, "int r = ");
+    append(&source, expression);
+    append(&source, ";");
+    Parser parser;
+    parser_init(&parser, source.data, source.length);
+    ASTNode *program = parser_parse(&parser);
+    Text actual = {NULL, 0, 0};
+    if (!program) {
+        append(&actual, parser_error_message(&parser));
+    } else {
+        render(&actual, source.data, program->children[0]->children[0]->children[1]);
+    }
+    compared++;
+    if (strcmp(actual.data, expected) != 0 && failures++ < 20) {
+        fprintf(stderr, "%s: da %s y se esperaba %s\n", expression, actual.data, expected);
+    }
+    ast_free(program);
+    parser_free(&parser);
+    free(actual.data);
+    free(source.data);
+}
+
+// Árbol esperado de "a o1 b o2 c ...", por descenso recursivo: cada nivel
+// toma operandos del siguiente y los une por la izquierda.
+static void expected_tree(const size_t *operators, size_t count, size_t *next, unsigned level, char *out) {
+    if (level > MAX_PRECEDENCE) {
+        snprintf(out, TREE_SIZE, "%c", (char)('a' + *next));
+        return;
+    }
+    expected_tree(operators, count, next, level + 1, out);
+    while (*next < count && OPERATORS[operators[*next]].precedence == level) {
+        const char *lexeme = OPERATORS[operators[(*next)++]].lexeme;
+        char left[TREE_SIZE];
+        char right[TREE_SIZE];
+        memcpy(left, out, TREE_SIZE);
+        expected_tree(operators, count, next, level + 1, right);
+        if (snprintf(out, TREE_SIZE, "(%s %s %s)", left, lexeme, right) >= TREE_SIZE) {
+            fprintf(stderr, "Árbol esperado demasiado largo\n");
+            exit(1);
+        }
+    }
+}
+
+// Todas las secuencias de count operadores binarios.
+static void check_chains(size_t count) {
+    size_t operators[MAX_OPERATORS] = {0};
+    while (true) {
+        char expression[TREE_SIZE];
+        size_t length = 0;
+        for (size_t i = 0; i < count; i++) {
+            length += snprintf(expression + length, sizeof(expression) - length, "%c %s ", (char)('a' + i),
+                               OPERATORS[operators[i]].lexeme);
+        }
+        snprintf(expression + length, sizeof(expression) - length, "%c", (char)('a' + count));
+        char expected[TREE_SIZE];
+        size_t next = 0;
+        expected_tree(operators, count, &next, 1, expected);
+        check(expression, expected);
+
+        size_t i = 0;
+        while (i < count && ++operators[i] == OPERATOR_COUNT) {
+            operators[i++] = 0;
+        }
+        if (i == count) {
+            return;
+        }
+    }
+}
+
+int main(void) {
+    for (size_t count = 1; count <= MAX_OPERATORS; count++) {
+        check_chains(count);
+    }
+    char expression[TREE_SIZE];
+    char expected[TREE_SIZE];
+    for (size_t i = 0; i < OPERATOR_COUNT; i++) {
+        const char *first = OPERATORS[i].lexeme;
+        for (size_t j = 0; j < OPERATOR_COUNT; j++) {
+            const char *second = OPERATORS[j].lexeme;
+            // Los paréntesis mandan sobre las precedencias.
+            snprintf(expression, sizeof(expression), "(a %s b) %s c", first, second);
+            snprintf(expected, sizeof(expected), "((a %s b) %s c)", first, second);
+            check(expression, expected);
+            snprintf(expression, sizeof(expression), "a %s (b %s c)", first, second);
+            snprintf(expected, sizeof(expected), "(a %s (b %s c))", first, second);
+            check(expression, expected);
+        }
+        // Los unarios ligan más que cualquier binario, delante de cada operando.
+        for (size_t u = 0; u < UNARY_COUNT; u++) {
+            snprintf(expression, sizeof(expression), "%s a %s b", UNARY[u], first);
+            snprintf(expected, sizeof(expected), "((%s a) %s b)", UNARY[u], first);
+            check(expression, expected);
+            snprintf(expression, sizeof(expression), "a %s %s b", first, UNARY[u]);
+            snprintf(expected, sizeof(expected), "(a %s (%s b))", first, UNARY[u]);
+            check(expression, expected);
+        }
+    }
+    for (size_t u = 0; u < UNARY_COUNT; u++) {
+        for (size_t v = 0; v < UNARY_COUNT; v++) {
+            snprintf(expression, sizeof(expression), "%s %s a", UNARY[u], UNARY[v]);
+            snprintf(expected, sizeof(expected), "(%s (%s a))", UNARY[u], UNARY[v]);
+            check(expression, expected);
+        }
+    }
+
+    // Llamadas, arreglos y grupos anidados como operandos.
+    check("f(a, b + c) * d", "(f(a, (b + c)) * d)");
+    check("-f(a) + g()", "((- f(a)) + g())");
+    check("f(g(a * b - c), [d || e, !e]) == 1", "(f(g(((a * b) - c)), [(d || e), (! e)]) == 1)");
+    check("[a + b * c, (a + b) * c]", "[(a + (b * c)), ((a + b) * c)]");
+    check("((((a))))", "a");
+    check("-(a - b) - -(c)", "((- (a - b)) - (- c))");
+    check("a < b == c > d && !e || f", "((((a < b) == (c > d)) && (! e)) || f)");
+    check("1 - 2 - 3 - 4", "(((1 - 2) - 3) - 4)");
+    check("a / b * c % d", "(((a / b) * c) % d)");
+
+    if (failures) {
+        fprintf(stderr, "test_precedence: %zu diferencias en %zu expresiones\n", failures, compared);
+        return 1;
+    }
+    printf("test_precedence: %zu expresiones con el árbol esperado\n", compared);
+    return 0;
+}
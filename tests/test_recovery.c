@@ -0,0 +1,263 @@
+// Recuperación de errores de sintaxis (parser_set_max_errors, --max-errors).
+// Para cada entrada se reúnen todos los errores sin límite y se comprueba que
+// con un límite N salen exactamente los N primeros (el primero, el mismo que
+// en el modo de un solo error), tanto en parser_parse como en
+// parser_parse_streaming. Las entradas son programas con errores inyectados,
+// sopas de tokens con llaves sin cerrar y bytes al azar; como cada error tras
+// el primero consume al menos un token, nunca puede haber más errores que
+// tokens, y la alarma hace fallar la prueba si la recuperación no termina.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#define TIMEOUT_SECONDS 20
+#define PROGRAMS 2000
+#define PROGRAM_STATEMENTS 40
+#define PROGRAM_ERRORS 6
+#define SOUPS 3000
+#define SOUP_FRAGMENTS 60
+#define GARBAGE 2000
+#define GARBAGE_LENGTH 300
+#define MAX_DIAGNOSTICS 4096
+
+static const size_t LIMITS[] = {1, 2, 3, 5, 20};
+#define LIMIT_COUNT (sizeof(LIMITS) / sizeof(LIMITS[0]))
+
+static unsigned long long rng_state = 0x510e527fade682d1ull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+static size_t compared = 0;
+static size_t recovered = 0;
+
+static void fail(const char *label, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s: %s\n", label, what);
+    }
+}
+
+static void on_alarm(int signal) {
+    (void)signal;
+    static const char message[] = "test_recovery: la recuperación no terminó\n";
+    if (write(STDERR_FILENO, message, sizeof(message) - 1) < 0) {
+        _exit(1);
+    }
+    _exit(1);
+}
+
+typedef struct {
+    SourceLocation location;
+    const char *message;
+} Diagnostic;
+
+typedef struct {
+    Diagnostic items[MAX_DIAGNOSTICS];
+    size_t count;
+} Diagnostics;
+
+static bool discard(ASTNode *instruction, void *ctx) {
+    (void)instruction;
+    (void)ctx;
+    return true;
+}
+
+static void collect(const char *source, size_t length, size_t limit, bool streaming, Diagnostics *out) {
+    Parser parser;
+    parser_init(&parser, source, length);
+    parser_set_max_errors(&parser, limit);
+    if (streaming) {
+        parser_parse_streaming(&parser, discard, NULL);
+    } else {
+        ast_free(parser_parse(&parser));
+    }
+    out->count = 0;
+    for (size_t i = 0; i < parser_error_count(&parser) && i < MAX_DIAGNOSTICS; i++) {
+        out->items[i].location = parser_error_location_at(&parser, i);
+        out->items[i].message = parser_error_message_at(&parser, i);
+        out->count++;
+    }
+    parser_free(&parser);
+}
+
+static bool same_diagnostic(const Diagnostic *a, const Diagnostic *b) {
+    return a->location.line == b->location.line && a->location.column == b->location.column &&
+           strcmp(a->message, b->message) == 0;
+}
+
+static size_t count_tokens(const char *source, size_t length) {
+    Lexer lexer;
+    lexer_init(&lexer, source, length);
+    size_t count = 0;
+    while (lexer_next_token(&lexer).type != TOKEN_EOF) {
+        count++;
+    }
+    lexer_free(&lexer);
+    return count + 1;
+}
+
+static void check(const char *label, const char *source, size_t length) {
+    static Diagnostics all;
+    static Diagnostics limited;
+    char what[320];
+    for (int streaming = 0; streaming < 2; streaming++) {
+        const char *mode = streaming ? "por instrucciones" : "completo";
+        collect(source, length, 0, streaming, &all);
+        if (all.count > count_tokens(source, length)) {
+            snprintf(what, sizeof(what), "%zu errores con %zu tokens (%s)", all.count, count_tokens(source, length),
+                     mode);
+            fail(label, what);
+            continue;
+        }
+        recovered += all.count > 1;
+        for (size_t i = 0; i < LIMIT_COUNT; i++) {
+            collect(source, length, LIMITS[i], streaming, &limited);
+            compared++;
+            size_t expected = all.count < LIMITS[i] ? all.count : LIMITS[i];
+            if (limited.count != expected) {
+                snprintf(what, sizeof(what), "%zu errores con el límite %zu y %zu sin límite (%s)", limited.count,
+                         LIMITS[i], all.count, mode);
+                fail(label, what);
+                continue;
+            }
+            for (size_t e = 0; e < expected; e++) {
+                const Diagnostic *a = &limited.items[e];
+                const Diagnostic *b = &all.items[e];
+                if (!same_diagnostic(a, b)) {
+                    snprintf(what, sizeof(what), "error %zu con el límite %zu: %zu:%zu %s; sin límite: %zu:%zu %s (%s)",
+                             e + 1, LIMITS[i], a->location.line, a->location.column, a->message, b->location.line,
+                             b->location.column, b->message, mode);
+                    fail(label, what);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text *text, const char *piece, size_t length) {
+    if (text->length + length > text->capacity) {
+        text->capacity = (text->length + length) * 2;
+        text->data = (char *)realloc(text->data, text->capacity);
+        if (!text->data) {
+            fprintf(stderr, "Memoria insuficiente\n");
+            exit(1);
+        }
+    }
+    memcpy(text->data + text->length, piece, length);
+    text->length += length;
+}
+
+static const char *const STATEMENTS[] = {
+    "int x = 1;\n",
+    "x = x + 2 * (3 - x);\n",
+    "array a = [1, 2, 3];\n",
+    "csay(\"hola\", x);\n",
+    "if (x > 1) { x = x - 1; }\n",
+    "while (x < 10) { x = x + 1; }\n",
+    "for (v in a) { csay(v); }\n",
+    "func suma(p, q) {\n    int t = p + q;\n    return t;\n}\n",
+};
+#define STATEMENT_COUNT (sizeof(STATEMENTS) / sizeof(STATEMENTS[0]))
+
+// Errores que se insertan en cualquier punto, incluso a mitad de un token.
+static const char *const ERRORS[] = {"@", ")", "(", "{", "}", "]", ";", "int = ;", "x = ;", "if x", "func (",
+                                     "return", ",", "\"", "= =", "++", "1 2"};
+#define ERROR_COUNT (sizeof(ERRORS) / sizeof(ERRORS[0]))
+
+static const char *const FRAGMENTS[] = {"int", "x", "=", "1", ";", "(", ")", "{", "}", "[", "]", ",", "+",
+                                        "*", "==", "if", "while", "for", "in", "func", "return", "csay", "\"s\"",
+                                        "'c'", "@", "\n", "array"};
+#define FRAGMENT_COUNT (sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]))
+
+static void insert(Text *text, size_t at, const char *piece) {
+    size_t length = strlen(piece);
+    append(text, piece, length);
+    memmove(text->data + at + length, text->data + at, text->length - length - at);
+    memcpy(text->data + at, piece, length);
+}
+
+// Tres instrucciones rotas en las líneas 1, 3 y 5: con el límite por defecto
+// sale solo la primera y sin límite, las tres en orden.
+static void check_known(void) {
+    static const char SOURCE[] = "int = 1;\nint y = 2;\ny = ;\ncsay(y);\nwhile { y = 1; }\nint z = y;\n";
+    static const size_t LINES[] = {1, 3, 5};
+    static Diagnostics all;
+    collect(SOURCE, strlen(SOURCE), 0, false, &all);
+    bool ok = all.count == 3;
+    for (size_t i = 0; ok && i < 3; i++) {
+        ok = all.items[i].location.line == LINES[i];
+    }
+    if (!ok) {
+        fail("programa conocido", "no da los errores de las líneas 1, 3 y 5");
+    }
+    check("programa conocido", SOURCE, strlen(SOURCE));
+}
+
+int main(void) {
+    signal(SIGALRM, on_alarm);
+    alarm(TIMEOUT_SECONDS);
+    check_known();
+
+    Text text = {NULL, 0, 0};
+    for (size_t program = 0; program < PROGRAMS; program++) {
+        text.length = 0;
+        size_t statements = 1 + rng_next() % PROGRAM_STATEMENTS;
+        for (size_t i = 0; i < statements; i++) {
+            const char *statement = STATEMENTS[rng_next() % STATEMENT_COUNT];
+            append(&text, statement, strlen(statement));
+        }
+        size_t errors = 1 + rng_next() % PROGRAM_ERRORS;
+        for (size_t i = 0; i < errors; i++) {
+            insert(&text, rng_next() % (text.length + 1), ERRORS[rng_next() % ERROR_COUNT]);
+        }
+        check("programa con errores", text.data, text.length);
+    }
+    for (size_t soup = 0; soup < SOUPS; soup++) {
+        text.length = 0;
+        size_t fragments = rng_next() % SOUP_FRAGMENTS;
+        for (size_t i = 0; i < fragments; i++) {
+            const char *fragment = FRAGMENTS[rng_next() % FRAGMENT_COUNT];
+            append(&text, fragment, strlen(fragment));
+            append(&text, " ", 1);
+        }
+        check("sopa de tokens", text.data ? text.data : "", text.length);
+    }
+    for (size_t garbage = 0; garbage < GARBAGE; garbage++) {
+        text.length = 0;
+        size_t length = rng_next() % GARBAGE_LENGTH;
+        for (size_t i = 0; i < length; i++) {
+            char byte = (char)(rng_next() & 0xff);
+            append(&text, &byte, 1);
+        }
+        check("bytes al azar", text.data ? text.data : "", text.length);
+    }
+    free(text.data);
+    if (failures) {
+        fprintf(stderr, "test_recovery: %zu fallos en %zu comparaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_recovery: %zu comparaciones con límite iguales a los primeros errores sin límite (%zu con varios)\n",
+           compared, recovered);
+    return 0;
+}
@@ -0,0 +1,274 @@
+// resolver_resolve sobre programas fijos: para cada aparición de un
+// identificador (la n-ésima con ese nombre, en orden del código) se comprueban
+// depth, slot y el número de declaración, y además el frame_size del programa
+// y de cada func, declaration_count y los errores (línea y mensaje). Se cubren
+// la ocultación en bloques y en func, el reúso de huecos al cerrar un bloque,
+// el uso antes de declarar (también en el propio valor inicial), la
+// redeclaración en el mismo ámbito, las llamadas a func declaradas más abajo,
+// la recursión mutua y las variables de dos funciones hacia fuera.
+
+#include "parser/parser.h"
+#include "resolver/resolver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_IDENTIFIERS 64
+#define MAX_EXPECTED 32
+#define MAX_FUNCTIONS 4
+#define MAX_ERRORS 4
+
+#define UNRESOLVED AST_NO_SLOT, AST_NO_DECLARATION
+
+typedef struct {
+    const char *name;
+    unsigned occurrence;
+    uint32_t depth;
+    uint32_t slot;
+    uint32_t declaration;
+} ExpectedIdentifier;
+
+typedef struct {
+    size_t line;
+    const char *message;
+} ExpectedError;
+
+typedef struct {
+    const char *label;
+    const char *source;
+    ExpectedIdentifier identifiers[MAX_EXPECTED];
+    // frame_size del programa y de cada func, en orden del código.
+    uint32_t program_frame;
+    uint32_t function_frames[MAX_FUNCTIONS];
+    size_t function_count;
+    size_t declarations;
+    ExpectedError errors[MAX_ERRORS];
+} ResolverCase;
+
+static const ResolverCase CASES[] = {
+    {"ocultación en un bloque",
+     "int x = 1;\n"
+     "if (x > 0) {\n"
+     "    int x = 2;\n"
+     "    csay(x);\n"
+     "}\n"
+     "csay(x);\n"
+     "int y = 3;\n",
+     {{"x", 0, 0, 0, 0}, {"x", 1, 0, 0, 0}, {"x", 2, 0, 1, 1}, {"x", 3, 0, 1, 1}, {"x", 4, 0, 0, 0},
+      // El hueco del x del bloque queda libre para y.
+      {"y", 0, 0, 1, 2}},
+     2, {0}, 0, 3, {{0}}},
+    {"func con variables de fuera",
+     "int a = 1;\n"
+     "func f(p) {\n"
+     "    int b = a + p;\n"
+     "    return b;\n"
+     "}\n"
+     "csay(f(a));\n",
+     // Las func del bloque se declaran antes que nada.
+     {{"f", 0, 0, 0, 0}, {"a", 0, 0, 1, 1}, {"p", 0, 0, 0, 2}, {"a", 1, 1, 1, 1}, {"p", 1, 0, 0, 2},
+      {"b", 0, 0, 1, 3}, {"b", 1, 0, 1, 3}, {"f", 1, 0, 0, 0}, {"a", 2, 0, 1, 1}},
+     2, {2}, 1, 4, {{0}}},
+    {"ocultación de un parámetro",
+     "int x = 1;\n"
+     "func f(x) {\n"
+     "    return x;\n"
+     "}\n"
+     "csay(x, f(x));\n",
+     {{"x", 0, 0, 1, 1}, {"f", 0, 0, 0, 0}, {"x", 1, 0, 0, 2}, {"x", 2, 0, 0, 2}, {"x", 3, 0, 1, 1},
+      {"f", 1, 0, 0, 0}, {"x", 4, 0, 1, 1}},
+     2, {1}, 1, 3, {{0}}},
+    {"uso antes de declarar",
+     "csay(x);\n"
+     "int x = x;\n"
+     "csay(x);\n",
+     // El valor inicial se resuelve antes de que el nombre exista.
+     {{"x", 0, 0, UNRESOLVED}, {"x", 1, 0, 0, 0}, {"x", 2, 0, UNRESOLVED}, {"x", 3, 0, 0, 0}},
+     1, {0}, 0, 1, {{1, "Nombre no declarado."}, {2, "Nombre no declarado."}}},
+    {"redeclaración",
+     "int x = 1;\n"
+     "int x = 2;\n"
+     "if (true) { int x = 3; }\n",
+     {{"x", 0, 0, 0, 0}, {"x", 1, 0, 0, 0}, {"x", 2, 0, 1, 1}},
+     2, {0}, 0, 2, {{2, "Nombre ya declarado en este ámbito."}}},
+    {"recursión mutua",
+     "bool r = par(4);\n"
+     "func par(n) { if (n == 0) { return true; } return impar(n - 1); }\n"
+     "func impar(n) { if (n == 0) { return false; } return par(n - 1); }\n",
+     {{"r", 0, 0, 2, 2}, {"par", 0, 0, 0, 0}, {"par", 1, 0, 0, 0}, {"n", 0, 0, 0, 3}, {"n", 1, 0, 0, 3},
+      {"impar", 0, 1, 1, 1}, {"n", 2, 0, 0, 3}, {"impar", 1, 0, 1, 1}, {"n", 3, 0, 0, 4}, {"n", 4, 0, 0, 4},
+      {"par", 2, 1, 0, 0}, {"n", 5, 0, 0, 4}},
+     3, {1, 1}, 2, 5, {{0}}},
+    {"func anidadas y bloques",
+     "int g = 5;\n"
+     "func outer(a) {\n"
+     "    func inner(b) {\n"
+     "        return a + b + g;\n"
+     "    }\n"
+     "    array l = [1, 2];\n"
+     "    for (v in l) {\n"
+     "        int w = v;\n"
+     "    }\n"
+     "    int z = 0;\n"
+     "    return inner(a);\n"
+     "}\n",
+     {{"g", 0, 0, 1, 1}, {"outer", 0, 0, 0, 0}, {"a", 0, 0, 0, 2}, {"inner", 0, 0, 1, 3}, {"b", 0, 0, 0, 4},
+      {"a", 1, 1, 0, 2}, {"b", 1, 0, 0, 4}, {"g", 1, 2, 1, 1}, {"l", 0, 0, 2, 5}, {"v", 0, 0, 3, 6},
+      {"l", 1, 0, 2, 5}, {"w", 0, 0, 4, 7}, {"v", 1, 0, 3, 6}, {"z", 0, 0, 3, 8}, {"inner", 1, 0, 1, 3},
+      {"a", 2, 0, 0, 2}},
+     2, {5, 1}, 2, 9, {{0}}},
+};
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+static void fail(const char *label, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s: %s\n", label, what);
+    }
+}
+
+typedef struct {
+    const ASTNode *identifiers[MAX_IDENTIFIERS];
+    size_t identifier_count;
+    const ASTNode *functions[MAX_FUNCTIONS];
+    size_t function_count;
+} Collected;
+
+static void collect(const ASTNode *node, Collected *out) {
+    if (!node) {
+        return;
+    }
+    if (node->type == AST_IDENTIFIER && out->identifier_count < MAX_IDENTIFIERS) {
+        out->identifiers[out->identifier_count++] = node;
+    }
+    if (node->type == AST_FUNCTION && out->function_count < MAX_FUNCTIONS) {
+        out->functions[out->function_count++] = node;
+    }
+    for (uint32_t i = 0; i < node->child_count; ++i) {
+        collect(node->children[i], out);
+    }
+}
+
+static int compare_offsets(const void *a, const void *b) {
+    uint32_t left = (*(const ASTNode *const *)a)->token.offset;
+    uint32_t right = (*(const ASTNode *const *)b)->token.offset;
+    return (left > right) - (left < right);
+}
+
+// La aparición occurrence de name, en orden del código.
+static const ASTNode *find(const char *source, const Collected *collected, const char *name, unsigned occurrence) {
+    size_t length = strlen(name);
+    for (size_t i = 0; i < collected->identifier_count; i++) {
+        const ASTNode *node = collected->identifiers[i];
+        if (node->token.length == length && memcmp(source + node->token.offset, name, length) == 0 &&
+            occurrence-- == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+static void check_case(const ResolverCase *test) {
+    char what[160];
+    Parser parser;
+    parser_init(&parser, test->source, strlen(test->source));
+    ASTNode *program = parser_parse(&parser);
+    if (!program) {
+        fail(test->label, parser_error_message(&parser));
+        parser_free(&parser);
+        return;
+    }
+    Resolver resolver;
+    resolver_init(&resolver);
+    resolver_set_max_errors(&resolver, 0);
+    resolver_resolve(&resolver, program, parser_symbols(&parser));
+
+    Collected collected = {{NULL}, 0, {NULL}, 0};
+    collect(program, &collected);
+    // Las func se recorren en preorden, que ya es el orden del código.
+    qsort(collected.identifiers, collected.identifier_count, sizeof(const ASTNode *), compare_offsets);
+    size_t expected_identifiers = 0;
+    for (size_t i = 0; i < MAX_EXPECTED && test->identifiers[i].name; i++) {
+        const ExpectedIdentifier *expected = &test->identifiers[i];
+        const ASTNode *node = find(test->source, &collected, expected->name, expected->occurrence);
+        compared++;
+        expected_identifiers++;
+        if (!node) {
+            snprintf(what, sizeof(what), "no aparece %s #%u", expected->name, expected->occurrence);
+            fail(test->label, what);
+        } else if (node->depth != expected->depth || node->slot != expected->slot ||
+                   node->declaration != expected->declaration) {
+            snprintf(what, sizeof(what), "%s #%u: depth %u, slot %u, declaración %u; se esperaba %u, %u, %u",
+                     expected->name, expected->occurrence, node->depth, node->slot, node->declaration,
+                     expected->depth, expected->slot, expected->declaration);
+            fail(test->label, what);
+        }
+    }
+    if (expected_identifiers != collected.identifier_count) {
+        snprintf(what, sizeof(what), "%zu identificadores y se esperaban %zu", collected.identifier_count,
+                 expected_identifiers);
+        fail(test->label, what);
+    }
+
+    compared++;
+    if (program->frame_size != test->program_frame) {
+        snprintf(what, sizeof(what), "marco del programa de %u y se esperaba %u", program->frame_size,
+                 test->program_frame);
+        fail(test->label, what);
+    }
+    if (collected.function_count != test->function_count) {
+        fail(test->label, "número de func distinto");
+    }
+    for (size_t i = 0; i < collected.function_count && i < test->function_count; i++) {
+        compared++;
+        if (collected.functions[i]->frame_size != test->function_frames[i]) {
+            snprintf(what, sizeof(what), "marco de la func %zu de %u y se esperaba %u", i,
+                     collected.functions[i]->frame_size, test->function_frames[i]);
+            fail(test->label, what);
+        }
+    }
+    compared++;
+    if (resolver.declaration_count != test->declarations) {
+        snprintf(what, sizeof(what), "%zu declaraciones y se esperaban %zu", resolver.declaration_count,
+                 test->declarations);
+        fail(test->label, what);
+    }
+
+    size_t expected_errors = 0;
+    while (expected_errors < MAX_ERRORS && test->errors[expected_errors].message) {
+        expected_errors++;
+    }
+    compared++;
+    if (resolver.error_count != expected_errors) {
+        snprintf(what, sizeof(what), "%zu errores y se esperaban %zu", resolver.error_count, expected_errors);
+        fail(test->label, what);
+    } else {
+        for (size_t i = 0; i < expected_errors; i++) {
+            SourceLocation location = lexer_location(&parser.lexer, resolver.errors[i].token.offset);
+            if (location.line != test->errors[i].line || strcmp(resolver.errors[i].message, test->errors[i].message)) {
+                snprintf(what, sizeof(what), "error %zu en la línea %zu: %s; se esperaba en la %zu: %s", i + 1,
+                         location.line, resolver.errors[i].message, test->errors[i].line, test->errors[i].message);
+                fail(test->label, what);
+            }
+        }
+    }
+    resolver_free(&resolver);
+    ast_free(program);
+    parser_free(&parser);
+}
+
+int main(void) {
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        check_case(&CASES[i]);
+    }
+    if (failures) {
+        fprintf(stderr, "test_resolver: %zu diferencias en %zu comprobaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_resolver: %zu comprobaciones de depth, slot, marcos y errores en %zu programas\n", compared,
+           CASE_COUNT);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// source_load sobre cada tipo de entrada: un archivo regular (proyectado), uno
+// vacío, y un FIFO con un escritor que envía el texto y cierra. El FIFO solo se
+// puede abrir una vez por escritor; si source_load lo abriera dos veces se
+// quedaría esperando, y la alarma hace fallar la prueba en lugar de colgarla.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "source/source.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define TIMEOUT_SECONDS 10
+// Más que el búfer de una tubería, para que el escritor tenga que esperar.
+#define FIFO_TEXT_REPEAT 20000
+
+static const char LINE[] = "int x = 1;\ncsay(\"hola\");\n";
+
+static size_t failures = 0;
+
+static void fail(const char *label, const char *what) {
+    failures++;
+    fprintf(stderr, "%s: %s\n", label, what);
+}
+
+static void on_alarm(int signal) {
+    (void)signal;
+    static const char message[] = "test_source: source_load no terminó (¿se reabrió el FIFO?)\n";
+    if (write(STDERR_FILENO, message, sizeof(message) - 1) < 0) {
+        _exit(1);
+    }
+    _exit(1);
+}
+
+static void write_file(const char *path, const char *data, size_t length) {
+    FILE *file = fopen(path, "wb");
+    if (!file || fwrite(data, 1, length, file) != length) {
+        fprintf(stderr, "No se pudo escribir %s\n", path);
+        exit(1);
+    }
+    fclose(file);
+}
+
+static void expect(const char *label, const char *path, const char *data, size_t length, bool mapped) {
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        fail(label, "no se cargó");
+        return;
+    }
+    if (file.length != length || (length && memcmp(file.data, data, length) != 0)) {
+        fail(label, "contenido distinto");
+    }
+    if (file.mapped != mapped) {
+        fail(label, mapped ? "no se proyectó" : "se proyectó");
+    }
+    source_release(&file);
+}
+
+// Un proceso hijo abre el FIFO para escribir, envía data y lo cierra.
+static pid_t start_writer(const char *path, const char *data, size_t length) {
+    pid_t child = fork();
+    if (child == 0) {
+        FILE *fifo = fopen(path, "wb");
+        bool ok = fifo && fwrite(data, 1, length, fifo) == length;
+        if (fifo) {
+            fclose(fifo);
+        }
+        _exit(ok ? 0 : 1);
+    }
+    return child;
+}
+
+static void expect_fifo(const char *label, const char *path, const char *data, size_t length) {
+    pid_t writer = start_writer(path, data, length);
+    if (writer < 0) {
+        perror("fork");
+        exit(1);
+    }
+    expect(label, path, data, length, false);
+    int status;
+    waitpid(writer, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fail(label, "el escritor no pudo enviar todo");
+    }
+}
+
+int main(void) {
+    char dir[] = "/tmp/test_source_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    signal(SIGALRM, on_alarm);
+    alarm(TIMEOUT_SECONDS);
+
+    size_t line_length = sizeof(LINE) - 1;
+    size_t length = line_length * FIFO_TEXT_REPEAT;
+    char *text = (char *)malloc(length);
+    for (size_t i = 0; i < FIFO_TEXT_REPEAT; i++) {
+        memcpy(text + i * line_length, LINE, line_length);
+    }
+
+    char regular[sizeof(dir) + 16];
+    char empty[sizeof(dir) + 16];
+    char fifo[sizeof(dir) + 16];
+    char missing[sizeof(dir) + 16];
+    snprintf(regular, sizeof(regular), "%s/regular", dir);
+    snprintf(empty, sizeof(empty), "%s/empty", dir);
+    snprintf(fifo, sizeof(fifo), "%s/fifo", dir);
+    snprintf(missing, sizeof(missing), "%s/missing", dir);
+    write_file(regular, text, length);
+    write_file(empty, "", 0);
+    if (mkfifo(fifo, 0600) != 0) {
+        perror("mkfifo");
+        return 1;
+    }
+
+    size_t checks = 0;
+    expect("archivo regular", regular, text, length, true);
+    checks++;
+    expect("archivo vacío", empty, "", 0, false);
+    checks++;
+    expect_fifo("FIFO corto", fifo, LINE, line_length);
+    checks++;
+    expect_fifo("FIFO mayor que la tubería", fifo, text, length);
+    checks++;
+    expect_fifo("FIFO vacío", fifo, "", 0);
+    checks++;
+    SourceFile file;
+    if (source_load(&file, missing)) {
+        source_release(&file);
+        fail("archivo inexistente", "se cargó");
+    }
+    checks++;
+
+    unlink(regular);
+    unlink(empty);
+    unlink(fifo);
+    rmdir(dir);
+    free(text);
+    if (failures) {
+        fprintf(stderr, "test_source: %zu fallos en %zu casos\n", failures, checks);
+        return 1;
+    }
+    printf("test_source: %zu casos de source_load correctos, FIFOs incluidos\n", checks);
+    return 0;
+}
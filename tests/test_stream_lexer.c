@@ -0,0 +1,154 @@
+// StreamLexer frente a lexer_next_token sobre el búfer entero: la fuente se
+// entrega en fragmentos de 1 a CHUNK_SMALL bytes y de algunos tamaños mayores,
+// de modo que cada token, cadena y comentario cruza límites entre fragmentos.
+// Los tokens deben ser idénticos (tipo, offset y longitud), el lexema debe
+// coincidir con los bytes de la fuente y la posición (línea y columna) con la
+// de lexer_location. Cada fragmento se copia a un búfer que se sobrescribe al
+// pedir el siguiente, como hace --stream, para que una referencia a un
+// fragmento ya entregado se note.
+
+#include "lexer/lexer.h"
+#include "lexer/stream_lexer.h"
+#include "source/source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHUNK_SMALL 8
+static const size_t CHUNK_LARGE[] = {13, 64, 4096};
+#define RANDOM_INPUTS 20000
+#define INPUT_FRAGMENTS 24
+
+static unsigned long long rng_state = 0x3c6ef372fe94f82bull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+static void fail(const char *label, size_t chunk, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s (fragmentos de %zu bytes): %s\n", label, chunk, what);
+    }
+}
+
+static void compare(const char *label, const char *source, size_t length, size_t chunk) {
+    Lexer whole;
+    lexer_init(&whole, source, length);
+    StreamLexer stream;
+    stream_lexer_init(&stream);
+    char *buffer = (char *)malloc(chunk);
+    size_t fed = 0;
+    compared++;
+    while (true) {
+        StreamToken token;
+        StreamStatus status = stream_lexer_next(&stream, &token);
+        if (status == STREAM_NEED_INPUT) {
+            size_t size = length - fed < chunk ? length - fed : chunk;
+            // El fragmento anterior ya no debe usarse: se machaca.
+            memset(buffer, '#', chunk);
+            memcpy(buffer, source + fed, size);
+            fed += size;
+            stream_lexer_feed(&stream, buffer, size, fed == length);
+            continue;
+        }
+        Token expected = lexer_next_token(&whole);
+        if (status == STREAM_END) {
+            if (expected.type != TOKEN_EOF) {
+                fail(label, chunk, "el flujo terminó antes que el lexer");
+            }
+            break;
+        }
+        char what[160];
+        if (expected.type != token.type || expected.offset != token.offset || expected.length != token.length) {
+            snprintf(what, sizeof(what), "en serie %s@%u/%u y por fragmentos %s@%zu/%zu",
+                     token_type_str(expected.type), expected.offset, expected.length, token_type_str(token.type),
+                     token.offset, token.length);
+            fail(label, chunk, what);
+            break;
+        }
+        if (memcmp(token.lexeme, source + token.offset, token.length) != 0) {
+            snprintf(what, sizeof(what), "lexema distinto en el offset %zu", token.offset);
+            fail(label, chunk, what);
+            break;
+        }
+        SourceLocation a = lexer_location(&whole, expected.offset);
+        SourceLocation b = stream_lexer_location(&stream, token.offset);
+        if (a.line != b.line || a.column != b.column) {
+            snprintf(what, sizeof(what), "offset %zu: línea %zu, columna %zu en serie y %zu, %zu por fragmentos",
+                     token.offset, a.line, a.column, b.line, b.column);
+            fail(label, chunk, what);
+            break;
+        }
+    }
+    free(buffer);
+    stream_lexer_free(&stream);
+    lexer_free(&whole);
+}
+
+static void compare_all_chunks(const char *label, const char *source, size_t length) {
+    for (size_t chunk = 1; chunk <= CHUNK_SMALL; chunk++) {
+        compare(label, source, length, chunk);
+    }
+    for (size_t i = 0; i < sizeof(CHUNK_LARGE) / sizeof(CHUNK_LARGE[0]); i++) {
+        compare(label, source, length, CHUNK_LARGE[i]);
+    }
+}
+
+// Tokens de cada clase, los cuatro tipos de comentario (con sus delimitadores
+// de dos caracteres, que son los que pueden quedar partidos) y cadenas con
+// escapes o sin cerrar.
+static const char *const FRAGMENTS[] = {
+    "int", "float", "if", "while", "func", "return", "csay", "true", "x", "_tmp9", "valor_42", "0", "42",
+    "3.14", "1.2.3", "7.", "\"hola\"", "\"esc \\\" \\n\"", "\"sin cerrar", "'a'", "'\\''", "'", "+", "++",
+    "-", "--", "*", "/", "%", "=", "==", "!", "!=", "<", "<=", ">", ">=", "&&", "||", "&", "|", "(", ")",
+    "{", "}", "[", "]", ",", ";", ".", "// línea\n", "$ dólar\n", "/* bloque * / */", "/* sin cerrar",
+    "%% porcentaje %%", "%%", "%% a % b %%", "@", "#", "\xc3\xb1",
+};
+#define FRAGMENT_COUNT (sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]))
+
+static const char *const SEPARATORS[] = {"", " ", "\n", "\t", "  \n    ", "\r\n"};
+#define SEPARATOR_COUNT (sizeof(SEPARATORS) / sizeof(SEPARATORS[0]))
+
+int main(void) {
+    SourceFile file;
+    if (!source_load(&file, "sample.pycl")) {
+        fprintf(stderr, "No se pudo leer el archivo: sample.pycl\n");
+        return 1;
+    }
+    compare_all_chunks("sample.pycl", file.data, file.length);
+    source_release(&file);
+
+    char text[INPUT_FRAGMENTS * 32];
+    for (size_t input = 0; input < RANDOM_INPUTS; input++) {
+        size_t length = 0;
+        size_t fragments = 1 + rng_next() % INPUT_FRAGMENTS;
+        for (size_t i = 0; i < fragments; i++) {
+            const char *fragment = FRAGMENTS[rng_next() % FRAGMENT_COUNT];
+            const char *separator = SEPARATORS[rng_next() % SEPARATOR_COUNT];
+            memcpy(text + length, fragment, strlen(fragment));
+            length += strlen(fragment);
+            memcpy(text + length, separator, strlen(separator));
+            length += strlen(separator);
+        }
+        // Una de cada cuatro entradas se prueba con todos los tamaños; el resto,
+        // con uno pequeño al azar.
+        if (input % 4 == 0) {
+            compare_all_chunks("entrada generada", text, length);
+        } else {
+            compare("entrada generada", text, length, 1 + rng_next() % CHUNK_SMALL);
+        }
+    }
+    if (failures) {
+        fprintf(stderr, "test_stream_lexer: %zu diferencias en %zu comparaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_stream_lexer: %zu análisis por fragmentos iguales al del búfer entero\n", compared);
+    return 0;
+}
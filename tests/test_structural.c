@@ -0,0 +1,184 @@
+// lexer_tokenize_parallel frente a lexer_tokenize_all: con cada núcleo de
+// scan.h (escalar, SSE2 y AVX2, los que soporte la CPU), trozos mínimos de
+// 1 byte y de 2 a 31 hilos, los tokens deben ser idénticos (tipo, offset y
+// longitud). Las entradas están hechas de cadenas, comentarios de los cuatro
+// tipos y espacios dentro de ellos, sin cerrar o con escapes, de modo que los
+// cortes del índice estructural caen justo antes, dentro y después de ellos y
+// a ambos lados de cada bloque de 64 bytes. También se comprueba que cada
+// corte de lexer_find_boundaries sea un espacio en blanco y estén en orden.
+
+#include "lexer/lexer.h"
+#include "lexer/scan.h"
+#include "lexer/structural.h"
+#include "source/source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUTS_PER_LEVEL 1500
+#define INPUT_FRAGMENTS 120
+#define MIN_THREADS 2
+#define MAX_THREADS 31
+#define MAX_BOUNDARIES 64
+
+static unsigned long long rng_state = 0xbb67ae8584caa73bull;
+
+static unsigned long long rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+static void fail(const char *label, const char *what, size_t threads, size_t min_chunk) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s (%s, %zu hilos, trozo mínimo %zu): %s\n", label,
+                scan_kernels()->level == SCAN_AVX2   ? "avx2"
+                : scan_kernels()->level == SCAN_SSE2 ? "sse2"
+                                                     : "scalar",
+                threads, min_chunk, what);
+    }
+}
+
+static bool tokenize(const char *source, size_t length, size_t threads, size_t min_chunk, TokenBuffer *tokens) {
+    Lexer lexer;
+    lexer_init(&lexer, source, length);
+    bool ok = threads > 1 ? lexer_tokenize_parallel(&lexer, tokens, threads, min_chunk)
+                          : lexer_tokenize_all(&lexer, tokens);
+    lexer_free(&lexer);
+    return ok;
+}
+
+static void check_boundaries(const char *label, const char *source, size_t length) {
+    size_t boundaries[MAX_BOUNDARIES];
+    size_t count = lexer_find_boundaries(source, 0, length, boundaries, MAX_BOUNDARIES);
+    for (size_t i = 0; i < count; i++) {
+        char c = source[boundaries[i]];
+        if (boundaries[i] >= length || (c != ' ' && c != '\t' && c != '\n' && c != '\r') ||
+            (i > 0 && boundaries[i] <= boundaries[i - 1])) {
+            fail(label, "corte fuera de orden o que no es un espacio", 0, 0);
+            return;
+        }
+    }
+}
+
+static void compare(const char *label, const char *source, size_t length, size_t threads, size_t min_chunk) {
+    TokenBuffer expected;
+    TokenBuffer actual;
+    token_buffer_init(&expected);
+    token_buffer_init(&actual);
+    compared++;
+    if (!tokenize(source, length, 1, 0, &expected) || !tokenize(source, length, threads, min_chunk, &actual)) {
+        fail(label, "sin memoria", threads, min_chunk);
+    } else if (expected.count != actual.count) {
+        char what[96];
+        snprintf(what, sizeof(what), "%zu tokens en serie y %zu en paralelo", expected.count, actual.count);
+        fail(label, what, threads, min_chunk);
+    } else {
+        for (size_t i = 0; i < expected.count; i++) {
+            Token a = expected.tokens[i];
+            Token b = actual.tokens[i];
+            if (a.type != b.type || a.offset != b.offset || a.length != b.length) {
+                char what[128];
+                snprintf(what, sizeof(what), "token %zu: %s@%u/%u en serie y %s@%u/%u en paralelo", i,
+                         token_type_str(a.type), a.offset, a.length, token_type_str(b.type), b.offset, b.length);
+                fail(label, what, threads, min_chunk);
+                break;
+            }
+        }
+    }
+    token_buffer_free(&expected);
+    token_buffer_free(&actual);
+}
+
+// Cadenas y comentarios con espacios dentro (cortes que el índice debe
+// descartar), sin cerrar, con escapes, y tokens normales entre ellos.
+static const char *const FRAGMENTS[] = {
+    "\"a b  c\"", "\"esc \\\" x y\"", "\"\\\\\" ", "\"sin cerrar y más ", "'a'", "'\\''", "' '", "'",
+    "/* x  y \n z */", "/* * / ** */", "/* sin cerrar ", "// línea con espacios\n", "$ dólar con espacios\n",
+    "%% bloque con espacios %%", "%% sin cerrar ", "%%", "/", "*", "$", "%", "\"", "\\", "int x = 1;",
+    "func f(a, b) { return a + b; }", "csay(\"hola\");", "3.14", "x_9", "\xc3\xb1", "@",
+    "\"                                                                     \"",
+    "/*                                                                     */",
+};
+#define FRAGMENT_COUNT (sizeof(FRAGMENTS) / sizeof(FRAGMENTS[0]))
+
+static const char *const SEPARATORS[] = {"", " ", "\n", "\t", "   \n  ", "\r\n", "                                 "};
+#define SEPARATOR_COUNT (sizeof(SEPARATORS) / sizeof(SEPARATORS[0]))
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void append(Text *text, const char *piece) {
+    size_t length = strlen(piece);
+    if (text->length + length > text->capacity) {
+        text->capacity = (text->length + length) * 2;
+        text->data = (char *)realloc(text->data, text->capacity);
+        if (!text->data) {
+            fprintf(stderr, "Memoria insuficiente\n");
+            exit(1);
+        }
+    }
+    memcpy(text->data + text->length, piece, length);
+    text->length += length;
+}
+
+static void check_file(const char *path) {
+    SourceFile file;
+    if (!source_load(&file, path)) {
+        fprintf(stderr, "No se pudo leer el archivo: %s\n", path);
+        failures++;
+        return;
+    }
+    check_boundaries(path, file.data, file.length);
+    for (size_t threads = MIN_THREADS; threads <= MAX_THREADS; threads++) {
+        compare(path, file.data, file.length, threads, 1);
+    }
+    source_release(&file);
+}
+
+int main(void) {
+    static const ScanLevel LEVELS[] = {SCAN_SCALAR, SCAN_SSE2, SCAN_AVX2};
+    Text text = {NULL, 0, 0};
+    size_t levels = 0;
+    for (size_t level = 0; level < sizeof(LEVELS) / sizeof(LEVELS[0]); level++) {
+        // Un nivel que la CPU no tiene cae al inferior, ya probado.
+        scan_set_level(LEVELS[level]);
+        if (scan_kernels()->level != LEVELS[level]) {
+            continue;
+        }
+        levels++;
+        check_file("sample.pycl");
+        for (size_t input = 0; input < INPUTS_PER_LEVEL; input++) {
+            text.length = 0;
+            size_t fragments = rng_next() % INPUT_FRAGMENTS;
+            for (size_t i = 0; i < fragments; i++) {
+                append(&text, FRAGMENTS[rng_next() % FRAGMENT_COUNT]);
+                append(&text, SEPARATORS[rng_next() % SEPARATOR_COUNT]);
+            }
+            const char *source = text.data ? text.data : "";
+            check_boundaries("entrada generada", source, text.length);
+            size_t threads = MIN_THREADS + rng_next() % (MAX_THREADS - MIN_THREADS + 1);
+            // Casi siempre trozos mínimos de 1 byte, para que haya tantos cortes
+            // como hilos; a veces algo mayores.
+            size_t min_chunk = rng_next() % 4 ? 1 : 1 + rng_next() % 256;
+            compare("entrada generada", source, text.length, threads, min_chunk);
+        }
+    }
+    free(text.data);
+    scan_set_level(SCAN_AUTO);
+    if (failures) {
+        fprintf(stderr, "test_structural: %zu diferencias en %zu comparaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_structural: %zu entradas con los mismos tokens en serie y por trozos con %zu núcleos de escaneo\n",
+           compared, levels);
+    return 0;
+}
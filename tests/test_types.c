@@ -0,0 +1,172 @@
+// types_infer sobre programas fijos: el resumen (expresiones y operadores, con
+// y sin tipo concreto, y especializaciones) debe dar exactamente las cuentas
+// hechas a mano, y el valor inicial de algunas declaraciones el tipo esperado,
+// junto con el tipo de lo que devuelve la especialización a la que llama. Se
+// cubren una func llamada con int y con float (dos especializaciones, con el
+// cuerpo VALUE_DYNAMIC), la recursión que se resuelve por punto fijo, los
+// elementos de un array a través del iterador de un for y una func que nunca
+// se llama.
+
+#include "parser/parser.h"
+#include "resolver/resolver.h"
+#include "types/types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DECLARATIONS 4
+
+typedef struct {
+    // Nombre de la variable declarada y tipo de su valor inicial; si es una
+    // llamada, result es el tipo que devuelve su especialización.
+    const char *name;
+    ValueType type;
+    ValueType result;
+} ExpectedDeclaration;
+
+typedef struct {
+    const char *label;
+    const char *source;
+    TypeSummary summary;
+    ExpectedDeclaration declarations[MAX_DECLARATIONS];
+} TypesCase;
+
+static const TypesCase CASES[] = {
+    // doble: 3 expresiones (v * 2, v y 2), con tipo solo el 2, porque v es int
+    // en una especialización y float en la otra. Declaraciones: llamada y
+    // argumento (2 + 2), el arreglo y sus elementos (3), &&, <, i, f y true
+    // (5). csay no cuenta, pero sí lo que recibe: doble(i) e i (2), y en el
+    // for, a, e + 0.5, e y 0.5 (4).
+    {"especialización por tipos",
+     "func doble(v) {\n"
+     "    return v * 2;\n"
+     "}\n"
+     "int i = doble(3);\n"
+     "float f = doble(1.5);\n"
+     "array a = [1, 2];\n"
+     "bool b = i < f && true;\n"
+     "csay(doble(i));\n"
+     "for (e in a) { csay(e + 0.5); }\n",
+     {21, 19, 4, 3, 2},
+     {{"i", VALUE_INT, VALUE_INT}, {"f", VALUE_FLOAT, VALUE_FLOAT}, {"a", VALUE_ARRAY, VALUE_UNKNOWN},
+      {"b", VALUE_BOOL, VALUE_UNKNOWN}}},
+    // fib: la condición, n y 2 (3); return n (1); la suma, las dos llamadas y
+    // sus argumentos n - 1 y n - 2 con sus operandos (9). r: llamada y 10 (2).
+    {"recursión",
+     "func fib(n) {\n"
+     "    if (n < 2) { return n; }\n"
+     "    return fib(n - 1) + fib(n - 2);\n"
+     "}\n"
+     "int r = fib(10);\n",
+     {15, 15, 4, 4, 1},
+     {{"r", VALUE_INT, VALUE_INT}}},
+    // nunca: sin llamadas, se analiza una vez con el parámetro VALUE_DYNAMIC,
+    // así que p + 1 y p quedan sin tipo y el 1 no. c: la resta y sus dos
+    // literales char, que dan int.
+    {"func sin llamar",
+     "func nunca(p) { return p + 1; }\n"
+     "int c = 'z' - 'a';\n",
+     {6, 4, 2, 1, 1},
+     {{"c", VALUE_INT, VALUE_UNKNOWN}}},
+};
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+
+static size_t failures = 0;
+static size_t compared = 0;
+
+static void fail(const char *label, const char *what) {
+    if (failures++ < 20) {
+        fprintf(stderr, "%s: %s\n", label, what);
+    }
+}
+
+// Valor inicial de la declaración de nivel superior de name.
+static const ASTNode *declared_value(const char *source, const ASTNode *program, const char *name) {
+    const ASTNode *list = program->children[0];
+    size_t length = strlen(name);
+    for (uint32_t i = 0; i < list->child_count; ++i) {
+        const ASTNode *node = list->children[i];
+        if (node->type == AST_DECLARATION && node->child_count == 2 && node->children[0]->token.length == length &&
+            memcmp(source + node->children[0]->token.offset, name, length) == 0) {
+            return node->children[1];
+        }
+    }
+    return NULL;
+}
+
+static void check_case(const TypesCase *test) {
+    char what[200];
+    Parser parser;
+    parser_init(&parser, test->source, strlen(test->source));
+    ASTNode *program = parser_parse(&parser);
+    if (!program) {
+        fail(test->label, parser_error_message(&parser));
+        parser_free(&parser);
+        return;
+    }
+    Resolver resolver;
+    resolver_init(&resolver);
+    if (!resolver_resolve(&resolver, program, parser_symbols(&parser))) {
+        fail(test->label, resolver.errors[0].message);
+    }
+    TypeInference types;
+    types_init(&types);
+    if (!types_infer(&types, program, resolver.declaration_count, test->source)) {
+        fail(test->label, "sin memoria para inferir");
+    }
+    resolver_free(&resolver);
+
+    const TypeSummary *actual = &types.summary;
+    const TypeSummary *expected = &test->summary;
+    compared++;
+    if (actual->expressions != expected->expressions || actual->typed_expressions != expected->typed_expressions ||
+        actual->operators != expected->operators || actual->typed_operators != expected->typed_operators ||
+        actual->specializations != expected->specializations) {
+        snprintf(what, sizeof(what),
+                 "resumen %zu/%zu expresiones, %zu/%zu operadores y %zu especializaciones; se esperaba %zu/%zu, "
+                 "%zu/%zu y %zu",
+                 actual->typed_expressions, actual->expressions, actual->typed_operators, actual->operators,
+                 actual->specializations, expected->typed_expressions, expected->expressions,
+                 expected->typed_operators, expected->operators, expected->specializations);
+        fail(test->label, what);
+    }
+    for (size_t i = 0; i < MAX_DECLARATIONS && test->declarations[i].name; i++) {
+        const ExpectedDeclaration *declaration = &test->declarations[i];
+        const ASTNode *value = declared_value(test->source, program, declaration->name);
+        compared++;
+        if (!value || value->value_type != declaration->type) {
+            snprintf(what, sizeof(what), "%s: tipo %d y se esperaba %d", declaration->name,
+                     value ? (int)value->value_type : -1, (int)declaration->type);
+            fail(test->label, what);
+            continue;
+        }
+        if (declaration->result == VALUE_UNKNOWN) {
+            continue;
+        }
+        compared++;
+        uint32_t specialization = value->type == AST_CALL ? value->specialization : TYPES_NO_SPECIALIZATION;
+        if (specialization == TYPES_NO_SPECIALIZATION || specialization == TYPES_MIXED_SPECIALIZATION ||
+            specialization >= types.specialization_count ||
+            types.specializations[specialization].result.type != declaration->result) {
+            snprintf(what, sizeof(what), "%s: la llamada no va a una especialización que devuelva %d",
+                     declaration->name, (int)declaration->result);
+            fail(test->label, what);
+        }
+    }
+    types_free(&types);
+    ast_free(program);
+    parser_free(&parser);
+}
+
+int main(void) {
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        check_case(&CASES[i]);
+    }
+    if (failures) {
+        fprintf(stderr, "test_types: %zu diferencias en %zu comprobaciones\n", failures, compared);
+        return 1;
+    }
+    printf("test_types: %zu comprobaciones del resumen y de los tipos en %zu programas\n", compared, CASE_COUNT);
+    return 0;
+}